@@ -37,6 +37,7 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -52,6 +53,8 @@
 
 struct hook_table;
 
+#define HOOK_LATENCY_BUCKETS 12  /* < 1ms, < 2ms, ... < 1024ms, longer */
+
 struct hook
 {
     struct list_head         chain;    /* hook chain entry */
@@ -68,6 +71,9 @@ struct hook
     int                 unicode;  /* is it a unicode hook? */
     WCHAR              *module;   /* module name for global hooks */
     data_size_t         module_size;
+    unsigned int        ll_calls;     /* low-level hook messages answered */
+    unsigned int        ll_timeouts;  /* low-level hook messages that timed out */
+    unsigned int        ll_latency[HOOK_LATENCY_BUCKETS];  /* latency histogram, see add_hook_ll_latency */
 };
 
 #define WH_WINEVENT (WH_MAXHOOK+1)
@@ -80,6 +86,7 @@ struct hook_table
     struct object obj;              /* object header */
     struct list_head   hooks[NB_HOOKS];  /* array of hook chains */
     int           counts[NB_HOOKS]; /* use counts for each hook chain */
+    unsigned int  live_mask;        /* chains containing at least one non-deleted hook */
 };
 
 static void hook_table_dump( struct object *obj, int verbose );
@@ -119,6 +126,7 @@ static struct hook_table *alloc_hook_table(void)
             list_init( &table->hooks[i] );
             table->counts[i] = 0;
         }
+        table->live_mask = 0;
     }
     return table;
 }
@@ -157,6 +165,9 @@ static struct hook *add_hook( struct desktop *desktop, struct thread *thread, in
     hook->thread = thread ? (struct thread *)grab_object( thread ) : NULL;
     hook->table  = table;
     hook->index  = index;
+    hook->ll_calls    = 0;
+    hook->ll_timeouts = 0;
+    memset( hook->ll_latency, 0, sizeof(hook->ll_latency) );
     wine_list_add_head( &table->hooks[index], &hook->chain );
     if (thread) thread->desktop_users++;
     return hook;
@@ -203,6 +214,23 @@ static inline struct hook *get_first_hook( struct hook_table *table, int index )
     return elem ? HOOK_ENTRY( elem ) : NULL;
 }
 
+/* recompute whether a chain still contains a non-deleted hook */
+static void update_live_mask( struct hook_table *table, int index )
+{
+    struct hook *hook = get_first_hook( table, index );
+
+    table->live_mask &= ~(1 << index);
+    while (hook)
+    {
+        if (hook->proc)
+        {
+            table->live_mask |= 1 << index;
+            break;
+        }
+        hook = HOOK_ENTRY( list_next( &table->hooks[index], &hook->chain ) );
+    }
+}
+
 /* check if a given hook should run in the owner thread instead of the current_thread thread */
 static inline int run_hook_in_owner_thread( struct hook *hook )
 {
@@ -229,8 +257,10 @@ static inline struct hook *get_first_valid_hook( struct hook_table *table, int i
                                                  int event, user_handle_t win,
                                                  int object_id, int child_id )
 {
-    struct hook *hook = get_first_hook( table, index );
+    struct hook *hook;
 
+    if (!(table->live_mask & (1 << index))) return NULL;
+    hook = get_first_hook( table, index );
     while (hook)
     {
         if (hook->proc && run_hook_in_current_thread( hook ))
@@ -284,8 +314,28 @@ static struct hook *get_next_hook( struct thread *thread, struct hook *hook, int
 
 static void hook_table_dump( struct object *obj, int verbose )
 {
-    /* struct hook_table *table = (struct hook_table *)obj; */
-    fprintf( stderr, "Hook table\n" );
+    struct hook_table *table = (struct hook_table *)obj;
+    struct hook *hook;
+    int i, j;
+
+    fprintf( stderr, "Hook table live=%08x\n", table->live_mask );
+    for (i = 0; i < NB_HOOKS; i++)
+    {
+        for (hook = get_first_hook( table, i ); hook;
+             hook = HOOK_ENTRY( list_next( &table->hooks[i], &hook->chain ) ))
+        {
+            if (!hook->proc) continue;
+            fprintf( stderr, "  %08x: id=%d calls=%u timeouts=%u",
+                     hook->handle, i + WH_MINHOOK, hook->ll_calls, hook->ll_timeouts );
+            if (verbose && hook->ll_calls)
+            {
+                fprintf( stderr, " latency=" );
+                for (j = 0; j < HOOK_LATENCY_BUCKETS; j++)
+                    fprintf( stderr, "%s%u", j ? "," : "", hook->ll_latency[j] );
+            }
+            fprintf( stderr, "\n" );
+        }
+    }
 }
 
 static void hook_table_destroy( struct object *obj )
@@ -303,10 +353,14 @@ static void hook_table_destroy( struct object *obj )
 /* remove a hook, freeing it if the chain is not in use */
 static void remove_hook( struct hook *hook )
 {
-    if (hook->table->counts[hook->index])
+    struct hook_table *table = hook->table;
+    int index = hook->index;
+
+    if (table->counts[index])
         hook->proc = 0; /* chain is in use, just mark it and return */
     else
         free_hook( hook );
+    update_live_mask( table, index );
 }
 
 /* release a hook chain, removing deleted hooks if the use count drops to 0 */
@@ -353,8 +407,10 @@ void remove_thread_hooks( struct thread *thread )
 /* get a bitmap of active hooks in a hook table */
 static int is_hook_active( struct hook_table *table, int index )
 {
-    struct hook *hook = get_first_hook( table, index );
+    struct hook *hook;
 
+    if (!(table->live_mask & (1 << index))) return 0;
+    hook = get_first_hook( table, index );
     while (hook)
     {
         if (hook->proc && run_hook_in_current_thread( hook )) return 1;
@@ -380,17 +436,40 @@ unsigned int get_active_hooks(void)
     return ret;
 }
 
-/* return the thread that owns the first global hook */
-struct thread *get_first_global_hook( int id )
+/* return the thread that owns the first global hook, and the hook handle */
+struct thread *get_first_global_hook( int id, user_handle_t *handle )
 {
     struct hook *hook;
     struct hook_table *global_hooks = get_global_hooks( current_thread );
 
     if (!global_hooks) return NULL;
     if (!(hook = get_first_valid_hook( global_hooks, id - WH_MINHOOK, EVENT_MIN, 0, 0, 0 ))) return NULL;
+    *handle = hook->handle;
     return hook->owner;
 }
 
+/* account the time a low-level hook took to answer a hardware event */
+void add_hook_ll_latency( user_handle_t handle, timeout_t latency, int timed_out )
+{
+    struct hook *hook = get_user_object( handle, USER_HOOK );
+    unsigned int ms, bucket = 0;
+
+    if (!hook) return;
+    if (timed_out)
+    {
+        hook->ll_timeouts++;
+        return;
+    }
+    hook->ll_calls++;
+    ms = latency > 0 ? latency / 10000 : 0;
+    while (ms && bucket < HOOK_LATENCY_BUCKETS - 1)
+    {
+        ms >>= 1;
+        bucket++;
+    }
+    hook->ll_latency[bucket]++;
+}
+
 /* set a window hook */
 DECL_HANDLER(set_hook)
 {
@@ -471,6 +550,7 @@ DECL_HANDLER(set_hook)
         hook->unicode     = req->unicode;
         hook->module      = module;
         hook->module_size = module_size;
+        update_live_mask( hook->table, hook->index );
         reply->handle = hook->handle;
         reply->active_hooks = get_active_hooks();
     }
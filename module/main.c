@@ -172,6 +172,7 @@ extern void destroy_syscall_chardev(void);
 extern void get_kallsyms_lookup_name(void);
 extern int timer_loop(void*);
 extern void destroy_reg_name( void );
+extern void free_image_cache(void);
 extern void register_pe_binfmt(void);
 extern void unregister_pe_binfmt(void);
 
@@ -180,12 +181,20 @@ struct task_struct* timer_kernel_task = NULL;
 /* module entry*/
 static int __init unifiedkernel_init(void)
 {
+    int ret;
+
     server_start_time = current_time;
     get_kallsyms_lookup_name();
     init_thread_hash_table();
     create_syscall_chardev();
     init_directories();
     init_uk_lock();
+    if ((ret = init_req_stats())) goto failed;
+    if ((ret = init_req_trace()))
+    {
+        destroy_req_stats();
+        goto failed;
+    }
     register_pe_binfmt();
 
     timer_kernel_task = kthread_run(timer_loop, NULL, "timer_thread");
@@ -195,11 +204,17 @@ static int __init unifiedkernel_init(void)
     }
 
     return 0;
+
+failed:
+    destroy_syscall_chardev();
+    return ret;
 }
 
 static void __exit unifiedkernel_exit(void)
 {
     destroy_syscall_chardev();
+    destroy_req_trace();
+    destroy_req_stats();
     unregister_pe_binfmt();
     kthread_stop(timer_kernel_task);
     flush_registry();
@@ -207,6 +222,7 @@ static void __exit unifiedkernel_exit(void)
     close_objects();  /* shut down everything properly */
 #endif
     destroy_reg_name();
+    free_image_cache();
 #ifdef MEM_LEAK_CHECK
     void print_mem_list(void);
     print_mem_list();
@@ -122,6 +122,30 @@ static const struct fd_ops mapping_fd_ops =
 
 static struct list_head shared_list = LIST_INIT(shared_list);
 
+/* PE header information cached per file, so that mapping an image that is
+ * already in use doesn't require parsing its headers again */
+struct image_info
+{
+    struct list_head entry;        /* entry in image_cache, most recently used first */
+    dev_t           dev;           /* identity of the image file */
+    ino_t           ino;
+    time_t          mtime;
+    unsigned long   mtime_nsec;
+    time_t          ctime;         /* not settable, catches writes that restore the mtime */
+    file_pos_t      file_size;
+    enum cpu_type   cpu;           /* client CPU the headers were checked for */
+    mem_size_t      size;          /* image size */
+    client_ptr_t    base;          /* default base address */
+    int             header_size;   /* size of headers */
+    unsigned int    nb_sec;        /* number of section headers */
+    IMAGE_SECTION_HEADER sec[1];   /* section headers */
+};
+
+#define MAX_IMAGE_CACHE 64
+
+static struct list_head image_cache = LIST_INIT(image_cache);
+static unsigned int image_cache_count;
+
 static size_t page_mask;
 
 #define ROUND_SIZE(size)  (((size) + page_mask) & ~page_mask)
@@ -379,11 +403,61 @@ static int build_shared_mapping( struct mapping *mapping, int fd,
     return 0;
 }
 
-/* retrieve the mapping parameters for an executable (PE) image */
-static unsigned int get_image_params( struct mapping *mapping, int unix_fd, int protect )
+/* nanoseconds of the modification time, coarse file systems leave them 0 */
+static inline unsigned long get_mtime_nsec( const struct stat *st )
+{
+    return st->st_mtime_nsec;
+}
+
+/* look for cached header information of an image file */
+static struct image_info *find_image_info( const struct stat *st, enum cpu_type cpu )
+{
+    struct image_info *info;
+
+    LIST_FOR_EACH_ENTRY( info, &image_cache, struct image_info, entry )
+    {
+        if (info->dev != st->st_dev || info->ino != st->st_ino) continue;
+        if (info->mtime != st->st_mtime || info->mtime_nsec != get_mtime_nsec( st )) continue;
+        if (info->ctime != st->st_ctime || info->file_size != st->st_size || info->cpu != cpu) continue;
+        list_remove( &info->entry );
+        wine_list_add_head( &image_cache, &info->entry );
+        return info;
+    }
+    return NULL;
+}
+
+/* add header information to the cache, evicting the least recently used entry if needed */
+static void add_image_info( struct image_info *info )
+{
+    wine_list_add_head( &image_cache, &info->entry );
+    if (++image_cache_count > MAX_IMAGE_CACHE)
+    {
+        struct image_info *old = LIST_ENTRY( list_tail( &image_cache ), struct image_info, entry );
+        list_remove( &old->entry );
+        free( old );
+        image_cache_count--;
+    }
+}
+
+/* free the cached header information when the module is unloaded */
+void free_image_cache(void)
+{
+    struct image_info *info, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( info, next, &image_cache, struct image_info, entry )
+    {
+        list_remove( &info->entry );
+        free( info );
+    }
+    image_cache_count = 0;
+}
+
+/* load the PE headers of an image file */
+static unsigned int load_image_info( int unix_fd, const struct stat *st, enum cpu_type cpu,
+                                     struct image_info **ret )
 {
     IMAGE_DOS_HEADER dos;
-    IMAGE_SECTION_HEADER *sec = NULL;
+    struct image_info *info;
     struct
     {
         DWORD Signature;
@@ -394,6 +468,9 @@ static unsigned int get_image_params( struct mapping *mapping, int unix_fd, int
             IMAGE_OPTIONAL_HEADER64 hdr64;
         } opt;
     } nt;
+    mem_size_t image_size = 0;
+    int header_size = 0;
+    client_ptr_t base = 0;
     off_t pos;
     int size;
 
@@ -413,8 +490,7 @@ static unsigned int get_image_params( struct mapping *mapping, int unix_fd, int
         return STATUS_INVALID_IMAGE_PROTECT;
     }
 
-    mapping->cpu = current_thread->process->cpu;
-    switch (mapping->cpu)
+    switch (cpu)
     {
     case CPU_x86:
         if (nt.FileHeader.Machine != IMAGE_FILE_MACHINE_I386) return STATUS_INVALID_IMAGE_FORMAT;
@@ -445,37 +521,73 @@ static unsigned int get_image_params( struct mapping *mapping, int unix_fd, int
     switch (nt.opt.hdr32.Magic)
     {
     case IMAGE_NT_OPTIONAL_HDR32_MAGIC:
-        mapping->size        = ROUND_SIZE( nt.opt.hdr32.SizeOfImage );
-        mapping->base        = nt.opt.hdr32.ImageBase;
-        mapping->header_size = nt.opt.hdr32.SizeOfHeaders;
+        image_size  = ROUND_SIZE( nt.opt.hdr32.SizeOfImage );
+        base        = nt.opt.hdr32.ImageBase;
+        header_size = nt.opt.hdr32.SizeOfHeaders;
         break;
     case IMAGE_NT_OPTIONAL_HDR64_MAGIC:
-        mapping->size        = ROUND_SIZE( nt.opt.hdr64.SizeOfImage );
-        mapping->base        = nt.opt.hdr64.ImageBase;
-        mapping->header_size = nt.opt.hdr64.SizeOfHeaders;
+        image_size  = ROUND_SIZE( nt.opt.hdr64.SizeOfImage );
+        base        = nt.opt.hdr64.ImageBase;
+        header_size = nt.opt.hdr64.SizeOfHeaders;
         break;
     }
 
     /* load the section headers */
 
     pos += sizeof(nt.Signature) + sizeof(nt.FileHeader) + nt.FileHeader.SizeOfOptionalHeader;
-    size = sizeof(*sec) * nt.FileHeader.NumberOfSections;
-    if (pos + size > mapping->size) goto error;
-    if (pos + size > mapping->header_size) mapping->header_size = pos + size;
-    if (!(sec = malloc( size ))) goto error;
-    if (pread( unix_fd, sec, size, pos ) != size) goto error;
+    size = sizeof(info->sec[0]) * nt.FileHeader.NumberOfSections;
+    if (pos + size > image_size) return STATUS_INVALID_FILE_FOR_SECTION;
+    if (pos + size > header_size) header_size = pos + size;
+    if (!(info = malloc( offsetof( struct image_info, sec ) + size )))
+        return STATUS_INVALID_FILE_FOR_SECTION;
+    if (pread( unix_fd, info->sec, size, pos ) != size)
+    {
+        free( info );
+        return STATUS_INVALID_FILE_FOR_SECTION;
+    }
+
+    info->dev         = st->st_dev;
+    info->ino         = st->st_ino;
+    info->mtime       = st->st_mtime;
+    info->mtime_nsec  = get_mtime_nsec( st );
+    info->ctime       = st->st_ctime;
+    info->file_size   = st->st_size;
+    info->cpu         = cpu;
+    info->size        = image_size;
+    info->base        = base;
+    info->header_size = header_size;
+    info->nb_sec      = nt.FileHeader.NumberOfSections;
+    *ret = info;
+    return 0;
+}
 
-    if (!build_shared_mapping( mapping, unix_fd, sec, nt.FileHeader.NumberOfSections )) goto error;
+/* retrieve the mapping parameters for an executable (PE) image */
+static unsigned int get_image_params( struct mapping *mapping, int unix_fd, int protect )
+{
+    enum cpu_type cpu = current_thread->process->cpu;
+    struct image_info *info;
+    struct stat st;
+    unsigned int err;
+
+    if (fstat( unix_fd, &st ) == -1) return STATUS_INVALID_FILE_FOR_SECTION;
+    if (!(info = find_image_info( &st, cpu )))
+    {
+        if ((err = load_image_info( unix_fd, &st, cpu, &info ))) return err;
+        add_image_info( info );
+    }
+
+    mapping->cpu         = cpu;
+    mapping->size        = info->size;
+    mapping->base        = info->base;
+    mapping->header_size = info->header_size;
+
+    if (!build_shared_mapping( mapping, unix_fd, info->sec, info->nb_sec ))
+        return STATUS_INVALID_FILE_FOR_SECTION;
 
     if (mapping->shared_file) wine_list_add_head( &shared_list, &mapping->shared_entry );
 
     mapping->protect = protect;
-    free( sec );
     return 0;
-
- error:
-    free( sec );
-    return STATUS_INVALID_FILE_FOR_SECTION;
 }
 
 static struct object *create_mapping( struct directory *root, const struct unicode_str *name,
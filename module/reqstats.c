@@ -0,0 +1,216 @@
+/*
+ * reqstats.c
+ *
+ * Per-request counters and latency histograms
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation; either version 2 of the  License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * Every request handled by NtWineService is accounted in per-cpu counters,
+ * so that collecting them costs two clock reads and a few additions and can
+ * stay enabled all the time.  The counters of all cpus are summed when
+ * /proc/unifiedkernel/reqstats is read; writing anything to that file
+ * resets them.
+ *
+ * Each line of the file describes one request type that was called at least
+ * once:
+ *
+ *   name calls total_ns max_ns lock_wait_ns bytes_in bytes_out hist
+ *
+ * where hist is a comma separated list of counts, bucket n holding calls
+ * that took between 2^(n-1) and 2^n - 1 nanoseconds.  Trailing empty
+ * buckets are omitted.
+ */
+
+#include <linux/kernel.h>
+#include <linux/version.h>
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
+#include <linux/bitops.h>
+#include <linux/string.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "winternl.h"
+#include "wine/server_protocol.h"
+#include "klog.h"
+
+#define REQ_STATS_BUCKETS 32
+
+struct req_stats
+{
+    unsigned long long calls;                      /* number of calls */
+    unsigned long long total_ns;                   /* time spent in the handler */
+    unsigned long long max_ns;                     /* longest call */
+    unsigned long long lock_wait_ns;               /* time spent waiting for uk_lock */
+    unsigned long long bytes_in;                   /* request data received */
+    unsigned long long bytes_out;                  /* reply data sent */
+    unsigned long long hist[REQ_STATS_BUCKETS];    /* log2 histogram of handler time */
+};
+
+extern const char *get_req_name( enum request req );
+
+static struct req_stats __percpu *req_stats[REQ_NB_REQUESTS];
+struct proc_dir_entry *uk_proc_dir;  /* /proc/unifiedkernel, shared with reqtrace.c */
+
+/* clock used for all request timings */
+unsigned long long req_stats_clock(void)
+{
+    return ktime_to_ns( ktime_get() );
+}
+
+/* account one call of a request handler */
+void req_stats_record( unsigned int req, unsigned long long lock_wait_ns, unsigned long long ns,
+                       unsigned int bytes_in, unsigned int bytes_out )
+{
+    struct req_stats *stats;
+    unsigned int bucket;
+
+    if (req >= REQ_NB_REQUESTS || !req_stats[req]) return;
+
+    bucket = fls64( ns );
+    if (bucket >= REQ_STATS_BUCKETS) bucket = REQ_STATS_BUCKETS - 1;
+
+    stats = get_cpu_ptr( req_stats[req] );
+    stats->calls++;
+    stats->total_ns += ns;
+    if (ns > stats->max_ns) stats->max_ns = ns;
+    stats->lock_wait_ns += lock_wait_ns;
+    stats->bytes_in += bytes_in;
+    stats->bytes_out += bytes_out;
+    stats->hist[bucket]++;
+    put_cpu_ptr( req_stats[req] );
+}
+
+/* sum the counters of all cpus for a request */
+static void sum_req_stats( unsigned int req, struct req_stats *sum )
+{
+    int cpu, i;
+
+    memset( sum, 0, sizeof(*sum) );
+    for_each_possible_cpu( cpu )
+    {
+        const struct req_stats *stats = per_cpu_ptr( req_stats[req], cpu );
+
+        sum->calls += stats->calls;
+        sum->total_ns += stats->total_ns;
+        if (stats->max_ns > sum->max_ns) sum->max_ns = stats->max_ns;
+        sum->lock_wait_ns += stats->lock_wait_ns;
+        sum->bytes_in += stats->bytes_in;
+        sum->bytes_out += stats->bytes_out;
+        for (i = 0; i < REQ_STATS_BUCKETS; i++) sum->hist[i] += stats->hist[i];
+    }
+}
+
+static int reqstats_show( struct seq_file *m, void *v )
+{
+    struct req_stats sum;
+    unsigned int req;
+    int i, last;
+
+    seq_printf( m, "# name calls total_ns max_ns lock_wait_ns bytes_in bytes_out hist\n" );
+    for (req = 0; req < REQ_NB_REQUESTS; req++)
+    {
+        if (!req_stats[req]) continue;
+        sum_req_stats( req, &sum );
+        if (!sum.calls) continue;
+
+        seq_printf( m, "%s %llu %llu %llu %llu %llu %llu ", get_req_name( req ), sum.calls,
+                    sum.total_ns, sum.max_ns, sum.lock_wait_ns, sum.bytes_in, sum.bytes_out );
+        for (last = REQ_STATS_BUCKETS - 1; last > 0 && !sum.hist[last]; last--) ;
+        for (i = 0; i <= last; i++) seq_printf( m, "%s%llu", i ? "," : "", sum.hist[i] );
+        seq_putc( m, '\n' );
+    }
+    return 0;
+}
+
+static int reqstats_open( struct inode *inode, struct file *file )
+{
+    return single_open( file, reqstats_show, NULL );
+}
+
+/* counters updated concurrently with a reset may keep a few old events */
+static ssize_t reqstats_write( struct file *file, const char __user *buf, size_t len, loff_t *ppos )
+{
+    unsigned int req;
+    int cpu;
+
+    for (req = 0; req < REQ_NB_REQUESTS; req++)
+    {
+        if (!req_stats[req]) continue;
+        for_each_possible_cpu( cpu )
+            memset( per_cpu_ptr( req_stats[req], cpu ), 0, sizeof(struct req_stats) );
+    }
+    return len;
+}
+
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,6,0))
+static const struct proc_ops reqstats_fops =
+{
+    .proc_open      = reqstats_open,
+    .proc_read      = seq_read,
+    .proc_write     = reqstats_write,
+    .proc_lseek     = seq_lseek,
+    .proc_release   = single_release,
+};
+#else
+static const struct file_operations reqstats_fops =
+{
+    .owner      = THIS_MODULE,
+    .open       = reqstats_open,
+    .read       = seq_read,
+    .write      = reqstats_write,
+    .llseek     = seq_lseek,
+    .release    = single_release,
+};
+#endif
+
+void destroy_req_stats(void)
+{
+    unsigned int req;
+
+    if (uk_proc_dir)
+    {
+        remove_proc_entry( "reqstats", uk_proc_dir );
+        remove_proc_entry( "unifiedkernel", NULL );
+        uk_proc_dir = NULL;
+    }
+    for (req = 0; req < REQ_NB_REQUESTS; req++)
+    {
+        free_percpu( req_stats[req] );
+        req_stats[req] = NULL;
+    }
+}
+
+int init_req_stats(void)
+{
+    unsigned int req;
+
+    for (req = 0; req < REQ_NB_REQUESTS; req++)
+    {
+        if (!(req_stats[req] = alloc_percpu( struct req_stats )))
+        {
+            klog(0, "alloc_percpu failed for request %u\n", req);
+            destroy_req_stats();
+            return -ENOMEM;
+        }
+    }
+
+    if (!(uk_proc_dir = proc_mkdir( "unifiedkernel", NULL )) ||
+        !proc_create( "reqstats", 0644, uk_proc_dir, &reqstats_fops ))
+    {
+        klog(0, "cannot create /proc/unifiedkernel/reqstats\n");
+        if (uk_proc_dir) remove_proc_entry( "unifiedkernel", NULL );
+        uk_proc_dir = NULL;
+        destroy_req_stats();
+        return -ENOMEM;
+    }
+    return 0;
+}
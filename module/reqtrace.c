@@ -0,0 +1,265 @@
+/*
+ * reqtrace.c
+ *
+ * Binary request tracing into per-cpu ring buffers
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of  the GNU General  Public License as published by the
+ * Free Software Foundation; either version 2 of the  License, or (at your
+ * option) any later version.
+ */
+
+/*
+ * When the reqtrace module parameter is set, NtWineService copies the raw
+ * request and reply structures, and the first REQTRACE_DATA_MAX bytes of
+ * their variable-size data, into a ring buffer of the current cpu instead of
+ * formatting them as text.  Reading /proc/unifiedkernel/reqtrace drains the
+ * buffers; when a buffer is full the oldest records are overwritten and a
+ * REQTRACE_LOST record tells the reader how many were dropped.  The records
+ * are decoded offline with tools/decode_reqtrace.
+ */
+
+#include <linux/kernel.h>
+#include <linux/version.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "winternl.h"
+#include "wine/server_protocol.h"
+#include "wine/reqtrace.h"
+#include "klog.h"
+
+#define REQTRACE_ALIGN(size) (((size) + 7) & ~7)
+
+struct reqtrace_buffer
+{
+    spinlock_t     lock;
+    char          *data;     /* ring buffer */
+    unsigned int   size;     /* size of the ring buffer */
+    unsigned int   head;     /* offset of the next record to write */
+    unsigned int   tail;     /* offset of the oldest record */
+    unsigned int   used;     /* bytes between tail and head */
+    unsigned int   lost;     /* records overwritten since the last read */
+};
+
+static int reqtrace;
+module_param(reqtrace, int, 0644);
+MODULE_PARM_DESC(reqtrace, "record requests in the binary trace buffers");
+
+static unsigned int reqtrace_kb = 256;
+module_param(reqtrace_kb, uint, 0444);
+MODULE_PARM_DESC(reqtrace_kb, "size of the per-cpu trace buffers in kilobytes");
+
+static DEFINE_PER_CPU(struct reqtrace_buffer, reqtrace_buffers);
+static struct proc_dir_entry *reqtrace_entry;
+
+extern unsigned long long req_stats_clock(void);
+extern struct proc_dir_entry *uk_proc_dir;
+
+int reqtrace_enabled(void)
+{
+    return reqtrace;
+}
+
+/* copy into the ring at a given offset, wrapping around */
+static void ring_write( struct reqtrace_buffer *buf, unsigned int pos, const void *src, unsigned int len )
+{
+    unsigned int first = min( len, buf->size - pos );
+
+    memcpy( buf->data + pos, src, first );
+    if (len > first) memcpy( buf->data, (const char *)src + first, len - first );
+}
+
+/* copy out of the ring at a given offset, wrapping around */
+static void ring_read( struct reqtrace_buffer *buf, unsigned int pos, void *dst, unsigned int len )
+{
+    unsigned int first = min( len, buf->size - pos );
+
+    memcpy( dst, buf->data + pos, first );
+    if (len > first) memcpy( (char *)dst + first, buf->data, len - first );
+}
+
+/* size of the oldest record in the ring */
+static unsigned int ring_first_size( struct reqtrace_buffer *buf )
+{
+    unsigned int size;
+
+    ring_read( buf, buf->tail, &size, sizeof(size) );
+    return size;
+}
+
+/* append a record to the buffer of the current cpu */
+void reqtrace_record( unsigned short type, unsigned int tid, unsigned int req, unsigned int error,
+                      const void *header, unsigned int header_size,
+                      const void *data, unsigned int data_size )
+{
+    struct reqtrace_buffer *buf;
+    struct reqtrace_record rec;
+    static const char zero[8];
+    unsigned long flags;
+    unsigned int pos;
+
+    rec.data_copied = data ? min( data_size, (unsigned int)REQTRACE_DATA_MAX ) : 0;
+    rec.size        = REQTRACE_ALIGN( sizeof(rec) + header_size + rec.data_copied );
+    rec.type        = type;
+    rec.time        = req_stats_clock();
+    rec.tid         = tid;
+    rec.req         = req;
+    rec.error       = error;
+    rec.header_size = header_size;
+    rec.data_size   = data_size;
+
+    buf = &get_cpu_var( reqtrace_buffers );
+    rec.cpu = smp_processor_id();
+    if (!buf->data || rec.size > buf->size) goto done;
+
+    spin_lock_irqsave( &buf->lock, flags );
+    while (buf->size - buf->used < rec.size)
+    {
+        unsigned int size = ring_first_size( buf );
+        buf->tail = (buf->tail + size) % buf->size;
+        buf->used -= size;
+        buf->lost++;
+    }
+    pos = buf->head;
+    ring_write( buf, pos, &rec, sizeof(rec) );
+    pos = (pos + sizeof(rec)) % buf->size;
+    ring_write( buf, pos, header, header_size );
+    pos = (pos + header_size) % buf->size;
+    ring_write( buf, pos, data, rec.data_copied );
+    pos = (pos + rec.data_copied) % buf->size;
+    ring_write( buf, pos, zero, rec.size - sizeof(rec) - header_size - rec.data_copied );
+    buf->head = (buf->head + rec.size) % buf->size;
+    buf->used += rec.size;
+    spin_unlock_irqrestore( &buf->lock, flags );
+done:
+    put_cpu_var( reqtrace_buffers );
+}
+
+/* move whole records of one cpu into a bounce buffer */
+static unsigned int drain_buffer( struct reqtrace_buffer *buf, int cpu, char *dst, unsigned int len )
+{
+    unsigned long flags;
+    unsigned int ret = 0;
+
+    spin_lock_irqsave( &buf->lock, flags );
+    if (buf->lost && len >= sizeof(struct reqtrace_record))
+    {
+        struct reqtrace_record *rec = (struct reqtrace_record *)dst;
+
+        memset( rec, 0, sizeof(*rec) );
+        rec->size  = sizeof(*rec);
+        rec->type  = REQTRACE_LOST;
+        rec->cpu   = cpu;
+        rec->time  = req_stats_clock();
+        rec->error = buf->lost;
+        buf->lost = 0;
+        ret += rec->size;
+    }
+    while (buf->used)
+    {
+        unsigned int size = ring_first_size( buf );
+
+        if (ret + size > len) break;
+        ring_read( buf, buf->tail, dst + ret, size );
+        buf->tail = (buf->tail + size) % buf->size;
+        buf->used -= size;
+        ret += size;
+    }
+    spin_unlock_irqrestore( &buf->lock, flags );
+    return ret;
+}
+
+static ssize_t reqtrace_read( struct file *file, char __user *ubuf, size_t len, loff_t *ppos )
+{
+    unsigned int bounce_size = min( len, (size_t)(64 * 1024) ), ret = 0;
+    char *bounce;
+    int cpu;
+
+    if (!len) return 0;
+    if (!(bounce = kmalloc( bounce_size, GFP_KERNEL ))) return -ENOMEM;
+
+    for_each_possible_cpu( cpu )
+    {
+        unsigned int size = drain_buffer( &per_cpu( reqtrace_buffers, cpu ), cpu, bounce, bounce_size );
+
+        if (!size) continue;
+        if (copy_to_user( ubuf + ret, bounce, size ))
+        {
+            kfree( bounce );
+            return ret ? ret : -EFAULT;
+        }
+        ret += size;
+        len -= size;
+        bounce_size = min( len, (size_t)bounce_size );
+        if (bounce_size < sizeof(struct reqtrace_record)) break;
+    }
+    kfree( bounce );
+    *ppos += ret;
+    return ret;
+}
+
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,6,0))
+static const struct proc_ops reqtrace_fops =
+{
+    .proc_read      = reqtrace_read,
+};
+#else
+static const struct file_operations reqtrace_fops =
+{
+    .owner      = THIS_MODULE,
+    .read       = reqtrace_read,
+};
+#endif
+
+void destroy_req_trace(void)
+{
+    int cpu;
+
+    reqtrace = 0;
+    if (reqtrace_entry) proc_remove( reqtrace_entry );
+    reqtrace_entry = NULL;
+    for_each_possible_cpu( cpu )
+    {
+        struct reqtrace_buffer *buf = &per_cpu( reqtrace_buffers, cpu );
+        vfree( buf->data );
+        buf->data = NULL;
+    }
+}
+
+int init_req_trace(void)
+{
+    int cpu;
+
+    for_each_possible_cpu( cpu )
+    {
+        struct reqtrace_buffer *buf = &per_cpu( reqtrace_buffers, cpu );
+
+        spin_lock_init( &buf->lock );
+        buf->size = reqtrace_kb * 1024;
+        buf->head = buf->tail = buf->used = buf->lost = 0;
+        if (!(buf->data = vmalloc( buf->size )))
+        {
+            klog(0, "cannot allocate the trace buffer of cpu %d\n", cpu);
+            destroy_req_trace();
+            return -ENOMEM;
+        }
+    }
+
+    if (!uk_proc_dir || !(reqtrace_entry = proc_create( "reqtrace", 0400, uk_proc_dir, &reqtrace_fops )))
+    {
+        klog(0, "cannot create /proc/unifiedkernel/reqtrace\n");
+        destroy_req_trace();
+        return -ENOMEM;
+    }
+    return 0;
+}
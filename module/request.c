@@ -82,12 +82,16 @@
 
 #ifdef CONFIG_UNIFIED_KERNEL
 #include "wine/server.h" /* for struct __server_request_info */
+#include "wine/reqtrace.h"
 #include <linux/kernel.h>
+#include <linux/version.h>
 #include <linux/module.h>
 #include <linux/errno.h>
 #include <linux/cdev.h>
 #include <linux/slab.h>
 #include <linux/device.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 #endif
 
 /* Some versions of glibc don't define this */
@@ -958,13 +962,14 @@ NTSTATUS NtEarlyInit(int __user* init_data_ptr)
     }
 }
 
-NTSTATUS NtWineService(int __user *user_req_info)
+NTSTATUS NtWineService(int __user *user_req_info, unsigned long long lock_wait_ns)
 {
     struct thread *thread;
     struct __server_request_info req_msg;
     union generic_reply reply;
     enum request req = -1;
     NTSTATUS status = STATUS_SUCCESS;
+    unsigned long long start;
     int i;
 
     thread = get_current_thread();
@@ -1009,11 +1014,17 @@ NTSTATUS NtWineService(int __user *user_req_info)
     clear_error();
     memset( &reply, 0, sizeof(reply) );
 
-    if (debug_level) trace_request();
+    if (reqtrace_enabled())
+        reqtrace_record( REQTRACE_REQUEST, thread->id, req, 0, &thread->req, sizeof(thread->req),
+                         thread->req_data, thread->req.request_header.request_size );
+    else if (debug_level) trace_request();
 
     if (req < REQ_NB_REQUESTS)
     {
+        start = req_stats_clock();
         req_handlers[req]( &thread->req, &reply ); /* call handle */
+        req_stats_record( req, lock_wait_ns, req_stats_clock() - start,
+                          thread->req.request_header.request_size, thread->reply_size );
     }
     else
     {
@@ -1027,7 +1038,10 @@ NTSTATUS NtWineService(int __user *user_req_info)
     {
         reply.reply_header.error = thread->error;
         reply.reply_header.reply_size = thread->reply_size;
-        if (debug_level) trace_reply( req, &reply );
+        if (reqtrace_enabled())
+            reqtrace_record( REQTRACE_REPLY, thread->id, req, thread->error, &reply, sizeof(reply),
+                             thread->reply_data, thread->reply_size );
+        else if (debug_level) trace_reply( req, &reply );
     }
     else
     {
@@ -1081,6 +1095,9 @@ NTSTATUS NtKillProcess(int __user* exit_code)
     return STATUS_SUCCESS;
 }
 
+/* registry key generations, mapped read-only by the clients */
+unsigned int *reg_generations;
+
 /* for syscall_chardev_fops */
 static struct class *class;
 static struct device *dev;
@@ -1121,10 +1138,25 @@ static ssize_t syscall_chardev_write(struct file *filp, const char __user *buf,
 }
 
 
+static int syscall_chardev_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+    if (!reg_generations || vma->vm_pgoff ||
+        vma->vm_end - vma->vm_start > REG_GENERATION_SLOTS * sizeof(*reg_generations))
+        return -EINVAL;
+    if (vma->vm_flags & VM_WRITE) return -EACCES;
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6,3,0))
+    vm_flags_clear(vma, VM_MAYWRITE);
+#else
+    vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+    return remap_vmalloc_range(vma, reg_generations, 0);
+}
+
 static long syscall_chardev_unlocked_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
     int err = 0;
     int __user* argp = (int __user*)arg;
+    unsigned long long lock_start;
 
     if ( (cmd > Nt_MaxNum) || (cmd < Nt_None) )
     {
@@ -1132,6 +1164,7 @@ static long syscall_chardev_unlocked_ioctl(struct file *filp, unsigned int cmd,
         return STATUS_INVALID_PARAMETER;
     }
 
+    lock_start = req_stats_clock();
     uk_lock();
     switch (cmd) 
     {
@@ -1141,7 +1174,7 @@ static long syscall_chardev_unlocked_ioctl(struct file *filp, unsigned int cmd,
             err = NtEarlyInit(argp);
             break;
         case Nt_WineService:
-            err = NtWineService(argp);
+            err = NtWineService(argp, req_stats_clock() - lock_start);
             break;
         case Nt_KillThread:
             err = NtKillThread(argp);
@@ -1164,6 +1197,7 @@ static const struct file_operations syscall_chardev_fops =
     .read       = syscall_chardev_read,
     .write      = syscall_chardev_write,
     .unlocked_ioctl = syscall_chardev_unlocked_ioctl,
+    .mmap       = syscall_chardev_mmap,
 };
 
 static char *chardev_devnode(struct device *dev, umode_t *mode)
@@ -1179,6 +1213,11 @@ int create_syscall_chardev(void)
     const char filename[]="syscall";
     int ret;
 
+    /* the client registry caches are simply disabled if this fails */
+    reg_generations = vmalloc_user(REG_GENERATION_SLOTS * sizeof(*reg_generations));
+    if(reg_generations == NULL)
+        klog(0,"cannot allocate the registry generations\n");
+
     chardev = cdev_alloc();
     if(chardev == NULL)
     {
@@ -1237,5 +1276,7 @@ void destroy_syscall_chardev(void)
     class_destroy(class);
     unregister_chrdev_region(devno, 1);
     kfree(chardev);
+    vfree(reg_generations);
+    reg_generations = NULL;
 }
 #endif
@@ -72,6 +72,22 @@ extern int server_dir_fd, config_dir_fd;
 
 extern void trace_request(void);
 extern void trace_reply( enum request req, const union generic_reply *reply );
+extern const char *get_req_name( enum request req );
+
+extern int init_req_stats(void);
+extern void destroy_req_stats(void);
+extern unsigned long long req_stats_clock(void);
+extern void req_stats_record( unsigned int req, unsigned long long lock_wait_ns, unsigned long long ns,
+                              unsigned int bytes_in, unsigned int bytes_out );
+
+extern unsigned int *reg_generations;
+
+extern int init_req_trace(void);
+extern void destroy_req_trace(void);
+extern int reqtrace_enabled(void);
+extern void reqtrace_record( unsigned short type, unsigned int tid, unsigned int req, unsigned int error,
+                             const void *header, unsigned int header_size,
+                             const void *data, unsigned int data_size );
 
 /* get the request vararg data */
 static inline const void *get_req_data(void)
@@ -203,6 +219,7 @@ DECL_HANDLER(add_mapping_committed_range);
 DECL_HANDLER(create_snapshot);
 DECL_HANDLER(next_process);
 DECL_HANDLER(next_thread);
+DECL_HANDLER(list_processes);
 DECL_HANDLER(wait_debug_event);
 DECL_HANDLER(queue_exception_event);
 DECL_HANDLER(get_exception_status);
@@ -464,6 +481,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_create_snapshot,
     (req_handler)req_next_process,
     (req_handler)req_next_thread,
+    (req_handler)req_list_processes,
     (req_handler)req_wait_debug_event,
     (req_handler)req_queue_exception_event,
     (req_handler)req_get_exception_status,
@@ -1227,6 +1245,10 @@ C_ASSERT( FIELD_OFFSET(struct next_thread_reply, tid) == 16 );
 C_ASSERT( FIELD_OFFSET(struct next_thread_reply, base_pri) == 20 );
 C_ASSERT( FIELD_OFFSET(struct next_thread_reply, delta_pri) == 24 );
 C_ASSERT( sizeof(struct next_thread_reply) == 32 );
+C_ASSERT( sizeof(struct list_processes_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct list_processes_reply, info_size) == 8 );
+C_ASSERT( FIELD_OFFSET(struct list_processes_reply, process_count) == 12 );
+C_ASSERT( sizeof(struct list_processes_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct wait_debug_event_request, get_handle) == 12 );
 C_ASSERT( sizeof(struct wait_debug_event_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct wait_debug_event_reply, pid) == 8 );
@@ -1276,12 +1298,14 @@ C_ASSERT( FIELD_OFFSET(struct create_key_request, namelen) == 28 );
 C_ASSERT( sizeof(struct create_key_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct create_key_reply, hkey) == 8 );
 C_ASSERT( FIELD_OFFSET(struct create_key_reply, created) == 12 );
-C_ASSERT( sizeof(struct create_key_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct create_key_reply, key_id) == 16 );
+C_ASSERT( sizeof(struct create_key_reply) == 24 );
 C_ASSERT( FIELD_OFFSET(struct open_key_request, parent) == 12 );
 C_ASSERT( FIELD_OFFSET(struct open_key_request, access) == 16 );
 C_ASSERT( FIELD_OFFSET(struct open_key_request, attributes) == 20 );
 C_ASSERT( sizeof(struct open_key_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct open_key_reply, hkey) == 8 );
+C_ASSERT( FIELD_OFFSET(struct open_key_reply, key_id) == 12 );
 C_ASSERT( sizeof(struct open_key_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct delete_key_request, hkey) == 12 );
 C_ASSERT( sizeof(struct delete_key_request) == 16 );
@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -62,6 +63,58 @@ struct snapshot
     int                       thread_pos;    /* current_thread position in thread snapshot */
 };
 
+/* fill the process and thread records of a process snapshot, return their total size */
+static data_size_t get_process_info( const struct process_snapshot *snapshot, int count, char *data )
+{
+    struct process_info *info = NULL;
+    struct thread_info *thread_info;
+    struct process_dll *exe_module;
+    struct thread *thread;
+    data_size_t pos = 0, name_len;
+    int i, threads;
+
+    for (i = 0; i < count; i++)
+    {
+        struct process *process = snapshot[i].process;
+
+        name_len = 0;
+        if ((exe_module = get_process_exe_module( process )) && exe_module->filename)
+            name_len = exe_module->namelen;
+        if (data)
+        {
+            info = (struct process_info *)(data + pos);
+            info->start_time   = process->start_time;
+            info->name_len     = name_len;
+            info->priority     = snapshot[i].priority;
+            info->pid          = get_process_id( process );
+            info->parent_pid   = process->parent ? get_process_id( process->parent ) : 0;
+            info->handle_count = snapshot[i].handles;
+            info->unix_pid     = process->unix_pid;
+            if (name_len) memcpy( info + 1, exe_module->filename, name_len );
+        }
+        pos = (pos + sizeof(*info) + name_len + 7) & ~7;
+
+        threads = 0;
+        LIST_FOR_EACH_ENTRY( thread, &process->thread_list, struct thread, proc_entry )
+        {
+            if (thread->state == TERMINATED) continue;
+            if (data)
+            {
+                thread_info = (struct thread_info *)(data + pos);
+                thread_info->start_time       = thread->creation_time;
+                thread_info->tid              = get_thread_id( thread );
+                thread_info->base_priority    = thread->priority;
+                thread_info->current_priority = thread->priority;
+                thread_info->unix_tid         = thread->unix_tid;
+            }
+            pos += sizeof(*thread_info);
+            threads++;
+        }
+        if (data) info->thread_count = threads;
+    }
+    return pos;
+}
+
 static void snapshot_dump( struct object *obj, int verbose );
 static void snapshot_destroy( struct object *obj );
 
@@ -229,3 +282,28 @@ DECL_HANDLER(next_thread)
         release_object( snapshot );
     }
 }
+
+/* get all the processes and their threads in a single request */
+DECL_HANDLER(list_processes)
+{
+    struct process_snapshot *snapshot;
+    data_size_t size;
+    char *data;
+    int i, count = 0;
+
+    snapshot = process_snap( &count );
+    size = get_process_info( snapshot, count, NULL );
+    reply->info_size = size;
+    reply->process_count = count;
+
+    /* let the client retry with a large enough buffer */
+    if (size > get_reply_max_size()) set_error( STATUS_INFO_LENGTH_MISMATCH );
+    else if ((data = set_reply_data_size( size )))
+    {
+        memset( data, 0, size );  /* don't leak the alignment padding */
+        get_process_info( snapshot, count, data );
+    }
+
+    for (i = 0; i < count; i++) release_object( snapshot[i].process );
+    free( snapshot );
+}
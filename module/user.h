@@ -108,7 +108,8 @@ extern void cleanup_clipboard_thread( struct thread *thread );
 
 extern void remove_thread_hooks( struct thread *thread );
 extern unsigned int get_active_hooks(void);
-extern struct thread *get_first_global_hook( int id );
+extern struct thread *get_first_global_hook( int id, user_handle_t *handle );
+extern void add_hook_ll_latency( user_handle_t handle, timeout_t latency, int timed_out );
 
 /* queue functions */
 
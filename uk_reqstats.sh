@@ -0,0 +1,57 @@
+#!/bin/bash
+#
+# Dump the per-request statistics collected by the unifiedkernel module.
+#
+# usage: uk_reqstats.sh [-r] [-n count] [-s calls|total|max|avg|wait|in|out] [-H]
+#   -r  reset the counters
+#   -n  only show the first <count> requests (default: all)
+#   -s  sort key (default: total)
+#   -H  also show the log2 latency histogram of each request
+
+stats=/proc/unifiedkernel/reqstats
+count=0
+sort_key=total
+hist=0
+
+while getopts "rn:s:H" opt; do
+    case $opt in
+        r) echo reset > $stats || exit 1; exit 0;;
+        n) count=$OPTARG;;
+        s) sort_key=$OPTARG;;
+        H) hist=1;;
+        *) sed -n '5,9s/^# \?//p' $0; exit 1;;
+    esac
+done
+
+[ -r $stats ] || { echo "$stats not found, is unifiedkernel loaded?" >&2; exit 1; }
+
+case $sort_key in
+    calls) column=2;;
+    total) column=3;;
+    max)   column=4;;
+    avg)   column=9;;
+    wait)  column=5;;
+    in)    column=6;;
+    out)   column=7;;
+    *)     echo "unknown sort key $sort_key" >&2; exit 1;;
+esac
+
+grep -v '^#' $stats |
+awk '{ print $1, $2, $3, $4, $5, $6, $7, $8, int($3 / $2) }' |
+sort -k$column -n -r |
+{ [ $count -gt 0 ] && head -n $count || cat; } |
+awk -v hist=$hist '
+BEGIN {
+    printf "%-32s %10s %14s %12s %10s %14s %12s %12s\n",
+           "request", "calls", "total_us", "max_us", "avg_ns", "lock_wait_us", "bytes_in", "bytes_out"
+}
+{
+    printf "%-32s %10d %14.1f %12.1f %10d %14.1f %12d %12d\n",
+           $1, $2, $3 / 1000, $4 / 1000, $9, $5 / 1000, $6, $7
+    if (hist)
+    {
+        n = split($8, h, ",")
+        for (i = 1; i <= n; i++)
+            if (h[i] > 0) printf "    < %-12d ns %d\n", 2 ^ (i - 1), h[i]
+    }
+}'
@@ -314,7 +314,7 @@ install-dev:: $ac_dir/install-dev"
 wine_fn_clean_rules ()
 {
     ac_clean=$[@]
-    ac_extraclean="$ac_dir/Makefile"
+    ac_extraclean="$ac_dir/Makefile $ac_dir/.makedep.cache"
     test "$srcdir" = . && ac_extraclean="$ac_extraclean $ac_dir/.gitignore"
 
     if wine_fn_has_flag clean
@@ -337,7 +337,7 @@ $ac_dir/clean: dummy
 wine_fn_disabled_rules ()
 {
     ac_clean=$[@]
-    ac_extraclean="$ac_dir/Makefile"
+    ac_extraclean="$ac_dir/Makefile $ac_dir/.makedep.cache"
     test "$srcdir" = . && ac_extraclean="$ac_extraclean $ac_dir/.gitignore"
 
     wine_fn_append_rule \
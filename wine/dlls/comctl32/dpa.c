@@ -265,9 +265,10 @@ BOOL WINAPI DPA_Merge (HDPA hdpa1, HDPA hdpa2, DWORD dwFlags,
                        LPARAM lParam)
 {
     INT nCount;
-    LPVOID *pWork1, *pWork2;
-    INT nResult, i;
+    LPVOID *pWork1, *pWork2, *pResult;
+    INT nResult, nTotal, nOut;
     INT nIndex;
+    BOOL bRet = TRUE;
 
     TRACE("%p %p %08x %p %p %08lx)\n",
            hdpa1, hdpa2, dwFlags, pfnCompare, pfnMerge, lParam);
@@ -300,8 +301,15 @@ BOOL WINAPI DPA_Merge (HDPA hdpa1, HDPA hdpa2, DWORD dwFlags,
     TRACE("hdpa1->nItemCount=%d hdpa2->nItemCount=%d\n",
            hdpa1->nItemCount, hdpa2->nItemCount);
 
-
-    /* working but untrusted implementation */
+    /* The arrays are walked from their ends and the merged items are stored
+     * from the end of a separate buffer, so that inserting and deleting items
+     * doesn't move the rest of DPA 1 every time.  The items of DPA 1 that
+     * were not reached are kept in front of them. */
+    nTotal = hdpa1->nItemCount + hdpa2->nItemCount;
+    pResult = HeapAlloc (GetProcessHeap (), 0, nTotal * sizeof(LPVOID));
+    if (!pResult)
+        return FALSE;
+    nOut = nTotal;
 
     pWork1 = &(hdpa1->ptrs[hdpa1->nItemCount - 1]);
     pWork2 = &(hdpa2->ptrs[hdpa2->nItemCount - 1]);
@@ -316,13 +324,16 @@ BOOL WINAPI DPA_Merge (HDPA hdpa1, HDPA hdpa2, DWORD dwFlags,
                 /* Now insert the remaining new items into DPA 1 */
                 TRACE("%d items to be inserted at start of DPA 1\n",
                       nCount+1);
-                for (i=nCount; i>=0; i--) {
+                for (; nCount >= 0; nCount--) {
                     PVOID ptr;
 
                     ptr = (pfnMerge)(DPAMM_INSERT, *pWork2, NULL, lParam);
                     if (!ptr)
-                        return FALSE;
-                    DPA_InsertPtr (hdpa1, 0, ptr);
+                    {
+                        bRet = FALSE;
+                        break;
+                    }
+                    pResult[--nOut] = ptr;
                     pWork2--;
                 }
             }
@@ -338,11 +349,14 @@ BOOL WINAPI DPA_Merge (HDPA hdpa1, HDPA hdpa2, DWORD dwFlags,
 
             ptr = (pfnMerge)(DPAMM_MERGE, *pWork1, *pWork2, lParam);
             if (!ptr)
-                return FALSE;
+            {
+                bRet = FALSE;
+                break;
+            }
 
             nCount--;
             pWork2--;
-            *pWork1 = ptr;
+            pResult[--nOut] = ptr;
             nIndex--;
             pWork1--;
         }
@@ -352,12 +366,10 @@ BOOL WINAPI DPA_Merge (HDPA hdpa1, HDPA hdpa2, DWORD dwFlags,
             if (dwFlags & DPAM_INTERSECT)
             {
                 /* Now delete the extra item in DPA1 */
-                PVOID ptr;
-
-                ptr = DPA_DeletePtr (hdpa1, nIndex);
-
-                (pfnMerge)(DPAMM_DELETE, ptr, NULL, lParam);
+                (pfnMerge)(DPAMM_DELETE, *pWork1, NULL, lParam);
             }
+            else
+                pResult[--nOut] = *pWork1;
             nIndex--;
             pWork1--;
         }
@@ -371,8 +383,11 @@ BOOL WINAPI DPA_Merge (HDPA hdpa1, HDPA hdpa2, DWORD dwFlags,
 
                 ptr = (pfnMerge)(DPAMM_INSERT, *pWork2, NULL, lParam);
                 if (!ptr)
-                    return FALSE;
-                DPA_InsertPtr (hdpa1, nIndex+1, ptr);
+                {
+                    bRet = FALSE;
+                    break;
+                }
+                pResult[--nOut] = ptr;
             }
             nCount--;
             pWork2--;
@@ -381,7 +396,19 @@ BOOL WINAPI DPA_Merge (HDPA hdpa1, HDPA hdpa2, DWORD dwFlags,
     }
     while (nCount >= 0);
 
-    return TRUE;
+    /* DPA 1 becomes its unprocessed items followed by the merged ones */
+    nTotal = nIndex + 1 + (nTotal - nOut);
+    if (nTotal > hdpa1->nItemCount && !DPA_SetPtr (hdpa1, nTotal - 1, NULL))
+        bRet = FALSE;
+    else
+    {
+        if (nTotal > nIndex + 1)
+            memcpy (&hdpa1->ptrs[nIndex + 1], &pResult[nOut], (nTotal - nIndex - 1) * sizeof(LPVOID));
+        hdpa1->nItemCount = nTotal;
+    }
+
+    HeapFree (GetProcessHeap (), 0, pResult);
+    return bRet;
 }
 
 
@@ -639,9 +666,10 @@ BOOL WINAPI DPA_SetPtr (HDPA hdpa, INT i, LPVOID p)
     if (hdpa->nItemCount <= i) {
         /* within the old array */
         if (hdpa->nMaxCount <= i) {
-            /* resize the block of memory */
-            INT nNewItems =
-                hdpa->nGrow * ((((i+1) - 1) / hdpa->nGrow) + 1);
+            /* resize the block of memory, growing by at least half of the
+             * current size so that appending n items costs O(n) */
+            INT nNewItems = max(i + 1, hdpa->nMaxCount + hdpa->nMaxCount / 2);
+            nNewItems = hdpa->nGrow * (((nNewItems - 1) / hdpa->nGrow) + 1);
             INT nSize = nNewItems * sizeof(LPVOID);
 
             if (hdpa->ptrs)
@@ -702,8 +730,9 @@ LPVOID WINAPI DPA_DeletePtr (HDPA hdpa, INT i)
 
     hdpa->nItemCount --;
 
-    /* free memory ?*/
-    if ((hdpa->nMaxCount - hdpa->nItemCount) >= hdpa->nGrow) {
+    /* free memory ? only once half of the array is unused, so that
+     * alternating inserts and deletes don't reallocate every time */
+    if ((hdpa->nMaxCount - hdpa->nItemCount) >= max(hdpa->nGrow, hdpa->nMaxCount / 2)) {
         INT nNewItems = max(hdpa->nGrow * 2, hdpa->nItemCount);
         nSize = nNewItems * sizeof(LPVOID);
         lpDest = HeapReAlloc (hdpa->hHeap, HEAP_ZERO_MEMORY,
@@ -751,12 +780,14 @@ BOOL WINAPI DPA_DeleteAllPtrs (HDPA hdpa)
 
 
 /**************************************************************************
- * DPA_QuickSort [Internal]
+ * DPA_MergeSort [Internal]
  *
- * Ordinary quicksort (used by DPA_Sort).
+ * Stable merge sort (used by DPA_Sort). Short ranges are sorted by
+ * insertion, longer ones are merged through a buffer holding the left half.
  *
  * PARAMS
  *     lpPtrs     [I] pointer to the pointer array
+ *     lpTemp     [I] buffer of at least (r - l) / 2 + 1 pointers
  *     l          [I] index of the "left border" of the partition
  *     r          [I] index of the "right border" of the partition
  *     pfnCompare [I] pointer to the compare function
@@ -765,38 +796,46 @@ BOOL WINAPI DPA_DeleteAllPtrs (HDPA hdpa)
  * RETURNS
  *     NONE
  */
-static VOID DPA_QuickSort (LPVOID *lpPtrs, INT l, INT r,
+static VOID DPA_MergeSort (LPVOID *lpPtrs, LPVOID *lpTemp, INT l, INT r,
                            PFNDPACOMPARE pfnCompare, LPARAM lParam)
 {
-    INT m;
+    INT i, j, k, m;
     LPVOID t;
 
-    TRACE("l=%i r=%i\n", l, r);
-
-    if (l==r)    /* one element is always sorted */
-        return;
-    if (r<l)     /* oops, got it in the wrong order */
+    if (r - l < 8)
+    {
+        for (i = l + 1; i <= r; i++)
         {
-        DPA_QuickSort(lpPtrs, r, l, pfnCompare, lParam);
-        return;
+            t = lpPtrs[i];
+            for (j = i; j > l && pfnCompare(lpPtrs[j - 1], t, lParam) > 0; j--)
+                lpPtrs[j] = lpPtrs[j - 1];
+            lpPtrs[j] = t;
         }
-    m = (l+r)/2; /* divide by two */
-    DPA_QuickSort(lpPtrs, l, m, pfnCompare, lParam);
-    DPA_QuickSort(lpPtrs, m+1, r, pfnCompare, lParam);
+        return;
+    }
 
-    /* join the two sides */
-    while( (l<=m) && (m<r) )
-    {
-        if(pfnCompare(lpPtrs[l],lpPtrs[m+1],lParam)>0)
-        {
-            t = lpPtrs[m+1];
-            memmove(&lpPtrs[l+1],&lpPtrs[l],(m-l+1)*sizeof(lpPtrs[l]));
-            lpPtrs[l] = t;
+    m = l + (r - l) / 2;
+    DPA_MergeSort(lpPtrs, lpTemp, l, m, pfnCompare, lParam);
+    DPA_MergeSort(lpPtrs, lpTemp, m + 1, r, pfnCompare, lParam);
 
-            m++;
-        }
-        l++;
+    /* nothing to do if the two sides are already in order */
+    if (pfnCompare(lpPtrs[m], lpPtrs[m + 1], lParam) <= 0)
+        return;
+
+    /* join the two sides, taking the left item first on equality */
+    memcpy(lpTemp, &lpPtrs[l], (m - l + 1) * sizeof(lpPtrs[0]));
+    i = 0;
+    j = m + 1;
+    k = l;
+    while (i <= m - l && j <= r)
+    {
+        if (pfnCompare(lpTemp[i], lpPtrs[j], lParam) > 0)
+            lpPtrs[k++] = lpPtrs[j++];
+        else
+            lpPtrs[k++] = lpTemp[i++];
     }
+    while (i <= m - l)
+        lpPtrs[k++] = lpTemp[i++];
 }
 
 
@@ -822,8 +861,16 @@ BOOL WINAPI DPA_Sort (HDPA hdpa, PFNDPACOMPARE pfnCompare, LPARAM lParam)
     TRACE("(%p %p 0x%lx)\n", hdpa, pfnCompare, lParam);
 
     if ((hdpa->nItemCount > 1) && (hdpa->ptrs))
-        DPA_QuickSort (hdpa->ptrs, 0, hdpa->nItemCount - 1,
+    {
+        LPVOID *lpTemp = HeapAlloc (GetProcessHeap (), 0,
+                                    (hdpa->nItemCount / 2 + 1) * sizeof(LPVOID));
+
+        if (!lpTemp)
+            return FALSE;
+        DPA_MergeSort (hdpa->ptrs, lpTemp, 0, hdpa->nItemCount - 1,
                        pfnCompare, lParam);
+        HeapFree (GetProcessHeap (), 0, lpTemp);
+    }
 
     return TRUE;
 }
@@ -244,6 +244,7 @@ typedef struct tagLISTVIEW_INFO
   /* items */
   INT nItemCount;		/* the number of items in the list */
   HDPA hdpaItems;               /* array ITEM_INFO pointers */
+  BOOL bItemsSorted;            /* items are known to be in the order of the sort style */
   HDPA hdpaItemIds;             /* array of ITEM_ID pointers */
   HDPA hdpaPosX;		/* maintains the (X, Y) coordinates of the */
   HDPA hdpaPosY;		/* items in LVS_ICON, and LVS_SMALLICON modes */
@@ -3226,7 +3227,7 @@ static BOOL ranges_add(RANGES ranges, RANGE range)
     else
     {
 	RANGE *chkrgn, *mrgrgn;
-	INT fromindex, mergeindex;
+	INT mergeindex;
 
 	chkrgn = DPA_GetPtr(ranges->hdpa, index);
 	TRACE("Merge with %s @%d\n", debugrange(chkrgn), index);
@@ -3236,30 +3237,40 @@ static BOOL ranges_add(RANGES ranges, RANGE range)
 	
 	TRACE("New range %s @%d\n", debugrange(chkrgn), index);
 
-        /* merge now common ranges */
-	fromindex = 0;
+        /* merge now common ranges; the ranges are sorted and disjoint,
+         * so only the neighbours of the grown range can touch it */
 	srchrgn.lower = chkrgn->lower - 1;
 	srchrgn.upper = chkrgn->upper + 1;
-	    
-	do
+
+	mergeindex = index - 1;
+	while (mergeindex >= 0)
 	{
-	    mergeindex = DPA_Search(ranges->hdpa, &srchrgn, fromindex, ranges_cmp, 0, 0);
-	    if (mergeindex == -1) break;
-	    if (mergeindex == index) 
-	    {
-		fromindex = index + 1;
-		continue;
-	    }
-	  
+	    mrgrgn = DPA_GetPtr(ranges->hdpa, mergeindex);
+	    if (ranges_cmp(&srchrgn, mrgrgn, 0) != 0) break;
+
 	    TRACE("Merge with index %i\n", mergeindex);
-	    
+
+	    chkrgn->lower = min(chkrgn->lower, mrgrgn->lower);
+	    chkrgn->upper = max(chkrgn->upper, mrgrgn->upper);
+	    Free(mrgrgn);
+	    DPA_DeletePtr(ranges->hdpa, mergeindex);
+	    index--;
+	    mergeindex--;
+	}
+
+	mergeindex = index + 1;
+	while (mergeindex < DPA_GetPtrCount(ranges->hdpa))
+	{
 	    mrgrgn = DPA_GetPtr(ranges->hdpa, mergeindex);
+	    if (ranges_cmp(&srchrgn, mrgrgn, 0) != 0) break;
+
+	    TRACE("Merge with index %i\n", mergeindex);
+
 	    chkrgn->lower = min(chkrgn->lower, mrgrgn->lower);
 	    chkrgn->upper = max(chkrgn->upper, mrgrgn->upper);
 	    Free(mrgrgn);
 	    DPA_DeletePtr(ranges->hdpa, mergeindex);
-	    if (mergeindex < index) index --;
-	} while(1);
+	}
     }
 
     ranges_check(ranges, "after add");
@@ -3278,9 +3289,11 @@ static BOOL ranges_del(RANGES ranges, RANGE range)
     TRACE("(%s)\n", debugrange(&range));
     ranges_check(ranges, "before del");
 
-    /* we don't use DPAS_SORTED here, since we need *
-     * to find the first overlapping range          */
-    index = DPA_Search(ranges->hdpa, &range, 0, ranges_cmp, 0, 0);
+    /* the sorted search may hit any of the overlapping ranges, *
+     * step back to the first one                                */
+    index = DPA_Search(ranges->hdpa, &range, 0, ranges_cmp, 0, DPAS_SORTED);
+    while (index > 0 && ranges_cmp(&range, DPA_GetPtr(ranges->hdpa, index - 1), 0) == 0)
+        index--;
     while(index != -1)
     {
 	chkrgn = DPA_GetPtr(ranges->hdpa, index);
@@ -3307,6 +3320,7 @@ static BOOL ranges_del(RANGES ranges, RANGE range)
 		  (chkrgn->lower < range.lower) )
 	{
 	    chkrgn->upper = range.lower;
+	    index++;
 	}
 	/* case 4: overlap lower */
 	else if ( (chkrgn->upper > range.upper) &&
@@ -3332,7 +3346,10 @@ static BOOL ranges_del(RANGES ranges, RANGE range)
 	    break;
 	}
 
-	index = DPA_Search(ranges->hdpa, &range, index, ranges_cmp, 0, 0);
+	/* the next overlapping range, if any, is at index now */
+	if (index >= DPA_GetPtrCount(ranges->hdpa) ||
+	    ranges_cmp(&range, DPA_GetPtr(ranges->hdpa, index), 0) != 0)
+	    break;
     }
 
     ranges_check(ranges, "after del");
@@ -4262,7 +4279,11 @@ static BOOL set_main_item(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem, BOOL
 
     /* copy information */
     if (lpLVItem->mask & LVIF_TEXT)
+    {
         textsetptrT(&lpItem->hdr.pszText, lpLVItem->pszText, isW);
+        /* sorted controls don't move an item whose text changes */
+        if (!isNew) infoPtr->bItemsSorted = FALSE;
+    }
 
     if (lpLVItem->mask & LVIF_IMAGE)
 	lpItem->hdr.iImage = lpLVItem->iImage;
@@ -5416,7 +5437,7 @@ static BOOL LISTVIEW_DeleteAllItems(LISTVIEW_INFO *infoPtr, BOOL destroy)
 	    hdpaSubItems = DPA_GetPtr(infoPtr->hdpaItems, i);
 	    lpItem = DPA_GetPtr(hdpaSubItems, 0);
 	    /* free id struct */
-	    j = DPA_GetPtrIndex(infoPtr->hdpaItemIds, lpItem->id);
+	    j = DPA_Search(infoPtr->hdpaItemIds, lpItem->id, -1, MapIdSearchCompare, 0, DPAS_SORTED);
 	    lpID = DPA_GetPtr(infoPtr->hdpaItemIds, j);
 	    DPA_DeletePtr(infoPtr->hdpaItemIds, j);
 	    Free(lpID);
@@ -5707,7 +5728,7 @@ static BOOL LISTVIEW_DeleteItem(LISTVIEW_INFO *infoPtr, INT nItem)
 	lpItem = DPA_GetPtr(hdpaSubItems, 0);
 
 	/* free id struct */
-	i = DPA_GetPtrIndex(infoPtr->hdpaItemIds, lpItem->id);
+	i = DPA_Search(infoPtr->hdpaItemIds, lpItem->id, -1, MapIdSearchCompare, 0, DPAS_SORTED);
 	lpID = DPA_GetPtr(infoPtr->hdpaItemIds, i);
 	DPA_DeletePtr(infoPtr->hdpaItemIds, i);
 	Free(lpID);
@@ -7657,6 +7678,39 @@ static INT LISTVIEW_HitTest(const LISTVIEW_INFO *infoPtr, LPLVHITTESTINFO lpht,
     return lpht->iItem = iItem;
 }
 
+/***
+ * DESCRIPTION:
+ * Checks whether the items are in the order of the sort style, so that
+ * sorted insertion can binary search them.
+ *
+ * PARAMETER(S):
+ * [I] infoPtr : valid pointer to the listview structure
+ *
+ * RETURN:
+ *   TRUE if the items are sorted, FALSE otherwise
+ */
+static BOOL LISTVIEW_CheckItemsSorted(const LISTVIEW_INFO *infoPtr)
+{
+    ITEM_INFO *prev = NULL, *item;
+    INT i, cmpv;
+
+    for (i = 0; i < infoPtr->nItemCount; i++)
+    {
+        item = DPA_GetPtr(DPA_GetPtr(infoPtr->hdpaItems, i), 0);
+
+        /* callback texts don't compare consistently */
+        if (item->hdr.pszText == LPSTR_TEXTCALLBACKW) return FALSE;
+        if (prev)
+        {
+            cmpv = textcmpWT(prev->hdr.pszText, item->hdr.pszText, TRUE);
+            if (infoPtr->dwStyle & LVS_SORTDESCENDING) cmpv *= -1;
+            if (cmpv > 0) return FALSE;
+        }
+        prev = item;
+    }
+    return TRUE;
+}
+
 /***
  * DESCRIPTION:
  * Inserts a new item in the listview control.
@@ -7713,23 +7767,51 @@ static INT LISTVIEW_InsertItemT(LISTVIEW_INFO *infoPtr, const LVITEMW *lpLVItem,
     {
         HDPA hItem;
         ITEM_INFO *item_s;
-        INT i = 0, cmpv;
+        INT low = 0, high = infoPtr->nItemCount, i, cmpv;
+
+        /* the style may have been set after the items were added, or item
+         * texts changed since; checking costs no more than the linear scan */
+        if (!infoPtr->bItemsSorted) infoPtr->bItemsSorted = LISTVIEW_CheckItemsSorted(infoPtr);
 
-        while (i < infoPtr->nItemCount)
+        if (infoPtr->bItemsSorted)
         {
-            hItem  = DPA_GetPtr( infoPtr->hdpaItems, i);
-            item_s = DPA_GetPtr(hItem, 0);
+            /* binary search for the first item that doesn't sort before the new one */
+            while (low < high)
+            {
+                i = low + (high - low) / 2;
+                hItem  = DPA_GetPtr( infoPtr->hdpaItems, i);
+                item_s = DPA_GetPtr(hItem, 0);
 
-            cmpv = textcmpWT(item_s->hdr.pszText, lpLVItem->pszText, isW);
-            if (infoPtr->dwStyle & LVS_SORTDESCENDING) cmpv *= -1;
+                cmpv = textcmpWT(item_s->hdr.pszText, lpLVItem->pszText, isW);
+                if (infoPtr->dwStyle & LVS_SORTDESCENDING) cmpv *= -1;
+
+                if (cmpv >= 0) high = i;
+                else low = i + 1;
+            }
+            nItem = low;
+        }
+        else
+        {
+            i = 0;
+            while (i < infoPtr->nItemCount)
+            {
+                hItem  = DPA_GetPtr( infoPtr->hdpaItems, i);
+                item_s = DPA_GetPtr(hItem, 0);
+
+                cmpv = textcmpWT(item_s->hdr.pszText, lpLVItem->pszText, isW);
+                if (infoPtr->dwStyle & LVS_SORTDESCENDING) cmpv *= -1;
 
-            if (cmpv >= 0) break;
-            i++;
+                if (cmpv >= 0) break;
+                i++;
+            }
+            nItem = i;
         }
-        nItem = i;
     }
     else
+    {
         nItem = min(lpLVItem->iItem, infoPtr->nItemCount);
+        infoPtr->bItemsSorted = FALSE;
+    }
 
     TRACE("inserting at %d, sorted=%d, count=%d, iItem=%d\n", nItem, is_sorted, infoPtr->nItemCount, lpLVItem->iItem);
     nItem = DPA_InsertPtr( infoPtr->hdpaItems, nItem, hdpaSubItems );
@@ -9092,37 +9174,22 @@ static INT LISTVIEW_SetView(LISTVIEW_INFO *infoPtr, DWORD nView)
 
 /* LISTVIEW_SetWorkAreas */
 
-/***
- * DESCRIPTION:
- * Callback internally used by LISTVIEW_SortItems() in response of LVM_SORTITEMS
- *
- * PARAMETER(S):
- * [I] first : pointer to first ITEM_INFO to compare
- * [I] second : pointer to second ITEM_INFO to compare
- * [I] lParam : HWND of control
- *
- * RETURN:
- *   if first comes before second : negative
- *   if first comes after second : positive
- *   if first and second are equivalent : zero
- */
-static INT WINAPI LISTVIEW_CallBackCompare(LPVOID first, LPVOID second, LPARAM lParam)
+/* item being sorted, with the value passed to the client defined callback:
+ * the item lParam for LVM_SORTITEMS, its index before sorting for LVM_SORTITEMSEX */
+typedef struct tagSORT_KEY
 {
-  LISTVIEW_INFO *infoPtr = (LISTVIEW_INFO *)lParam;
-  ITEM_INFO* lv_first = DPA_GetPtr( first, 0 );
-  ITEM_INFO* lv_second = DPA_GetPtr( second, 0 );
-
-  /* Forward the call to the client defined callback */
-  return (infoPtr->pfnCompare)( lv_first->lParam , lv_second->lParam, infoPtr->lParamSort );
-}
+  HDPA hdpaSubItems;
+  LPARAM key;
+} SORT_KEY;
 
 /***
  * DESCRIPTION:
- * Callback internally used by LISTVIEW_SortItems() in response of LVM_SORTITEMSEX
+ * Callback internally used by LISTVIEW_SortItems() in response of LVM_SORTITEMS
+ * and LVM_SORTITEMSEX
  *
  * PARAMETER(S):
- * [I] first : pointer to first ITEM_INFO to compare
- * [I] second : pointer to second ITEM_INFO to compare
+ * [I] first : pointer to first SORT_KEY to compare
+ * [I] second : pointer to second SORT_KEY to compare
  * [I] lParam : HWND of control
  *
  * RETURN:
@@ -9130,14 +9197,14 @@ static INT WINAPI LISTVIEW_CallBackCompare(LPVOID first, LPVOID second, LPARAM l
  *   if first comes after second : positive
  *   if first and second are equivalent : zero
  */
-static INT WINAPI LISTVIEW_CallBackCompareEx(LPVOID first, LPVOID second, LPARAM lParam)
+static INT WINAPI LISTVIEW_CallBackCompare(LPVOID first, LPVOID second, LPARAM lParam)
 {
   LISTVIEW_INFO *infoPtr = (LISTVIEW_INFO *)lParam;
-  INT first_idx  = DPA_GetPtrIndex( infoPtr->hdpaItems, first  );
-  INT second_idx = DPA_GetPtrIndex( infoPtr->hdpaItems, second );
+  const SORT_KEY *lv_first = first;
+  const SORT_KEY *lv_second = second;
 
   /* Forward the call to the client defined callback */
-  return (infoPtr->pfnCompare)( first_idx, second_idx, infoPtr->lParamSort );
+  return (infoPtr->pfnCompare)( lv_first->key, lv_second->key, infoPtr->lParamSort );
 }
 
 /***
@@ -9157,8 +9224,9 @@ static INT WINAPI LISTVIEW_CallBackCompareEx(LPVOID first, LPVOID second, LPARAM
 static BOOL LISTVIEW_SortItems(LISTVIEW_INFO *infoPtr, PFNLVCOMPARE pfnCompare,
                                LPARAM lParamSort, BOOL IsEx)
 {
-    HDPA hdpaSubItems;
+    HDPA hdpaSubItems, hdpaKeys;
     ITEM_INFO *lpItem;
+    SORT_KEY *keys;
     LPVOID selectionMarkItem = NULL;
     LPVOID focusedItem = NULL;
     int i;
@@ -9173,6 +9241,28 @@ static BOOL LISTVIEW_SortItems(LISTVIEW_INFO *infoPtr, PFNLVCOMPARE pfnCompare,
     /* if there are 0 or 1 items, there is no need to sort */
     if (infoPtr->nItemCount < 2) return TRUE;
 
+    /* Sort a copy holding the callback values, so that they are read once per
+     * item, and the indices given for LVM_SORTITEMSEX keep referring to the
+     * unsorted items the callback may query while the copy is sorted. */
+    if (!(keys = Alloc(infoPtr->nItemCount * sizeof(*keys)))) return FALSE;
+    if (!(hdpaKeys = DPA_Create(infoPtr->nItemCount)))
+    {
+        Free(keys);
+        return FALSE;
+    }
+    for (i = 0; i < infoPtr->nItemCount; i++)
+    {
+        keys[i].hdpaSubItems = DPA_GetPtr(infoPtr->hdpaItems, i);
+        if (IsEx)
+            keys[i].key = i;
+        else
+        {
+            lpItem = DPA_GetPtr(keys[i].hdpaSubItems, 0);
+            keys[i].key = lpItem->lParam;
+        }
+        DPA_SetPtr(hdpaKeys, i, &keys[i]);
+    }
+
     /* clear selection */
     ranges_clear(infoPtr->selectionRanges);
 
@@ -9184,10 +9274,21 @@ static BOOL LISTVIEW_SortItems(LISTVIEW_INFO *infoPtr, PFNLVCOMPARE pfnCompare,
 
     infoPtr->pfnCompare = pfnCompare;
     infoPtr->lParamSort = lParamSort;
-    if (IsEx)
-        DPA_Sort(infoPtr->hdpaItems, LISTVIEW_CallBackCompareEx, (LPARAM)infoPtr);
-    else
-        DPA_Sort(infoPtr->hdpaItems, LISTVIEW_CallBackCompare, (LPARAM)infoPtr);
+    DPA_Sort(hdpaKeys, LISTVIEW_CallBackCompare, (LPARAM)infoPtr);
+    infoPtr->bItemsSorted = FALSE;
+
+    /* the callback shouldn't have added or removed items, but don't crash if it did */
+    if (DPA_GetPtrCount(hdpaKeys) == infoPtr->nItemCount &&
+        DPA_GetPtrCount(infoPtr->hdpaItems) == infoPtr->nItemCount)
+    {
+        for (i = 0; i < infoPtr->nItemCount; i++)
+        {
+            SORT_KEY *key = DPA_GetPtr(hdpaKeys, i);
+            DPA_SetPtr(infoPtr->hdpaItems, i, key->hdpaSubItems);
+        }
+    }
+    DPA_Destroy(hdpaKeys);
+    Free(keys);
 
     /* restore selection ranges */
     for (i=0; i < infoPtr->nItemCount; i++)
@@ -10988,6 +11089,10 @@ static INT LISTVIEW_StyleChanged(LISTVIEW_INFO *infoPtr, WPARAM wStyleType,
     infoPtr->dwStyle = lpss->styleNew;
     map_style_view(infoPtr);
 
+    /* the items were not kept in the new order */
+    if ((lpss->styleOld ^ lpss->styleNew) & (LVS_SORTASCENDING | LVS_SORTDESCENDING | LVS_OWNERDRAWFIXED))
+        infoPtr->bItemsSorted = FALSE;
+
     if (((lpss->styleOld & WS_HSCROLL) != 0)&&
         ((lpss->styleNew & WS_HSCROLL) == 0))
        ShowScrollBar(infoPtr->hwndSelf, SB_HORZ, FALSE);
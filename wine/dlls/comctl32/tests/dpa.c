@@ -22,6 +22,7 @@
 #define COBJMACROS
 
 #include <stdarg.h>
+#include <stdlib.h>
 
 #include "windef.h"
 #include "winbase.h"
@@ -353,6 +354,61 @@ static void test_dpa(void)
     pDPA_Destroy(dpa3);
 }
 
+static INT nCompares;
+
+static INT CALLBACK CB_CmpKey(PVOID p1, PVOID p2, LPARAM lp)
+{
+    ULONG_PTR k1 = (ULONG_PTR)p1 >> 20, k2 = (ULONG_PTR)p2 >> 20;
+
+    nCompares++;
+    return k1 < k2 ? -1 : k1 > k2 ? 1 : 0;
+}
+
+static void test_DPA_Sort_large(void)
+{
+    static const char *names[] = { "random", "reversed", "nearly sorted" };
+    const INT count = 1 << 20;
+    HDPA dpa;
+    DWORD start;
+    INT i, j, bad;
+
+    /* items hold a sort key in their upper bits and their original position
+     * in the lower 20 bits, to check that equal keys keep their order */
+    for (i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        dpa = pDPA_Create(count);
+        ok(dpa != NULL, "DPA_Create failed\n");
+        if (!dpa) return;
+
+        srand(i);
+        for (j = 0; j < count; j++)
+        {
+            ULONG_PTR key;
+
+            if (i == 0) key = rand() % 2048;
+            else if (i == 1) key = (count - 1 - j) >> 10;
+            else key = (j % 100) ? j >> 10 : rand() % 1024;
+            if (!pDPA_SetPtr(dpa, j, (PVOID)(key << 20 | j))) break;
+        }
+        ok(j == count, "DPA_SetPtr failed at %d\n", j);
+
+        nCompares = 0;
+        start = GetTickCount();
+        ok(pDPA_Sort(dpa, CB_CmpKey, 0), "DPA_Sort failed\n");
+        trace("sorting %d %s items took %u ms, %d compares\n", count, names[i],
+              GetTickCount() - start, nCompares);
+
+        for (j = 1, bad = 0; j < count; j++)
+        {
+            ULONG_PTR prev = (ULONG_PTR)pDPA_GetPtr(dpa, j - 1), cur = (ULONG_PTR)pDPA_GetPtr(dpa, j);
+
+            if ((prev >> 20) > (cur >> 20) || ((prev >> 20) == (cur >> 20) && prev > cur)) bad++;
+        }
+        ok(!bad, "%d items out of order in %s array\n", bad, names[i]);
+        pDPA_Destroy(dpa);
+    }
+}
+
 static void test_DPA_Merge(void)
 {
     HDPA dpa, dpa2, dpa3;
@@ -754,6 +810,7 @@ START_TEST(dpa)
 
     test_dpa();
     test_DPA_Merge();
+    test_DPA_Sort_large();
     test_DPA_EnumCallback();
     test_DPA_DestroyCallback();
     test_DPA_LoadStream();
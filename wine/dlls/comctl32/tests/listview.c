@@ -2737,9 +2737,10 @@ static void test_sorting(void)
 {
     HWND hwnd;
     LVITEMA item = {0};
-    INT r;
+    INT r, i;
     LONG_PTR style;
     static CHAR names[][5] = {"A", "B", "C", "D", "0"};
+    static CHAR bb[] = "BB";
     CHAR buff[10];
 
     hwnd = create_listview_control(LVS_REPORT);
@@ -2871,6 +2872,16 @@ static void test_sorting(void)
     expect(TRUE, r);
     ok(lstrcmpA(buff, names[3]) == 0, "Expected '%s', got '%s'\n", names[3], buff);
 
+    /* the new item goes before the first item that doesn't sort before it */
+    item.mask = LVIF_TEXT;
+    item.iItem = 4;
+    item.iSubItem = 0;
+    item.pszText = bb;
+    r = SendMessageA(hwnd, LVM_INSERTITEMA, 0, (LPARAM) &item);
+    expect(1, r);
+    r = SendMessageA(hwnd, LVM_DELETEITEM, 1, 0);
+    expect(TRUE, r);
+
     /* corner case - item should be placed at first position */
     item.mask = LVIF_TEXT;
     item.iItem = 4;
@@ -2909,6 +2920,34 @@ static void test_sorting(void)
     ok(lstrcmpA(buff, names[3]) == 0, "Expected '%s', got '%s'\n", names[3], buff);
 
     DestroyWindow(hwnd);
+
+    /* changing the text of an item doesn't move it */
+    hwnd = create_listview_control(LVS_REPORT | LVS_SORTASCENDING);
+    ok(hwnd != NULL, "failed to create a listview window\n");
+
+    for (i = 0; i < 3; i++)
+    {
+        item.mask = LVIF_TEXT;
+        item.iItem = i;
+        item.iSubItem = 0;
+        item.pszText = names[i];
+        r = SendMessageA(hwnd, LVM_INSERTITEMA, 0, (LPARAM) &item);
+        expect(i, r);
+    }
+
+    item.iSubItem = 0;
+    item.pszText = names[3];
+    r = SendMessageA(hwnd, LVM_SETITEMTEXTA, 0, (LPARAM) &item);
+    expect(TRUE, r);
+
+    item.mask = LVIF_TEXT;
+    item.iItem = 3;
+    item.iSubItem = 0;
+    item.pszText = bb;
+    r = SendMessageA(hwnd, LVM_INSERTITEMA, 0, (LPARAM) &item);
+    expect(0, r);
+
+    DestroyWindow(hwnd);
 }
 
 static void test_ownerdata(void)
@@ -4418,6 +4457,156 @@ static void test_indentation(void)
     DestroyWindow(hwnd);
 }
 
+/* comparison callback for test_sorting_many, looks the items up by index */
+static INT WINAPI test_CallBackCompareEx(LPARAM first, LPARAM second, LPARAM lParam)
+{
+    LVITEMA item;
+    LPARAM param1, param2;
+
+    item.mask = LVIF_PARAM;
+    item.iSubItem = 0;
+    item.iItem = first;
+    SendMessageA((HWND)lParam, LVM_GETITEMA, 0, (LPARAM)&item);
+    param1 = item.lParam;
+    item.iItem = second;
+    SendMessageA((HWND)lParam, LVM_GETITEMA, 0, (LPARAM)&item);
+    param2 = item.lParam;
+
+    if (param1 == param2) return 0;
+    return (param1 > param2 ? 1 : -1);
+}
+
+static void test_sorting_many(void)
+{
+    const int count = 20000;
+    LVITEMA item;
+    DWORD start;
+    HWND hwnd;
+    int i, bad;
+    INT r;
+
+    if (g_is_below_5)
+    {
+        win_skip("LVM_SORTITEMSEX is not supported\n");
+        return;
+    }
+
+    hwnd = create_listview_control(LVS_REPORT);
+    ok(hwnd != NULL, "failed to create a listview window\n");
+
+    SendMessageA(hwnd, LVM_SETITEMCOUNT, count, 0);
+    item.mask = LVIF_PARAM;
+    item.iSubItem = 0;
+    for (i = 0; i < count; i++)
+    {
+        item.iItem = i;
+        item.lParam = count - i;
+        SendMessageA(hwnd, LVM_INSERTITEMA, 0, (LPARAM)&item);
+    }
+
+    /* the callback looks up the items it compares by the indices it is given */
+    start = GetTickCount();
+    r = SendMessageA(hwnd, LVM_SORTITEMSEX, (WPARAM)hwnd, (LPARAM)test_CallBackCompareEx);
+    expect(TRUE, r);
+    trace("LVM_SORTITEMSEX of %d items took %u ms\n", count, GetTickCount() - start);
+
+    for (i = bad = 0; i < count; i++)
+    {
+        item.iItem = i;
+        SendMessageA(hwnd, LVM_GETITEMA, 0, (LPARAM)&item);
+        if (item.lParam != i + 1) bad++;
+    }
+    ok(!bad, "%d items out of order\n", bad);
+
+    start = GetTickCount();
+    r = SendMessageA(hwnd, LVM_SORTITEMS, 0, (LPARAM)test_CallBackCompare);
+    expect(TRUE, r);
+    trace("LVM_SORTITEMS of %d sorted items took %u ms\n", count, GetTickCount() - start);
+
+    DestroyWindow(hwnd);
+}
+
+static void test_many_items(void)
+{
+    const int count = 20000;
+    char buff[16], text[16];
+    LVITEMA item;
+    DWORD start;
+    HWND hwnd;
+    int i, bad;
+    INT r;
+
+    hwnd = create_listview_control(LVS_REPORT | LVS_SORTASCENDING);
+    ok(hwnd != NULL, "failed to create a listview window\n");
+
+    /* sorted insertion of the numbers in shuffled order */
+    start = GetTickCount();
+    item.mask = LVIF_TEXT;
+    item.iSubItem = 0;
+    item.pszText = buff;
+    for (i = 0; i < count; i++)
+    {
+        item.iItem = i;
+        sprintf(buff, "%05d", (i * 7919) % count);
+        SendMessageA(hwnd, LVM_INSERTITEMA, 0, (LPARAM)&item);
+    }
+    trace("sorted insertion of %d items took %u ms\n", count, GetTickCount() - start);
+    r = SendMessageA(hwnd, LVM_GETITEMCOUNT, 0, 0);
+    expect(count, r);
+
+    for (i = bad = 0; i < count; i++)
+    {
+        item.iItem = i;
+        item.pszText = buff;
+        item.cchTextMax = sizeof(buff);
+        SendMessageA(hwnd, LVM_GETITEMA, 0, (LPARAM)&item);
+        sprintf(text, "%05d", i);
+        if (strcmp(buff, text)) bad++;
+    }
+    ok(!bad, "%d items out of order\n", bad);
+
+    /* every other item selected gives the largest number of ranges */
+    start = GetTickCount();
+    item.stateMask = LVIS_SELECTED;
+    item.state = LVIS_SELECTED;
+    for (i = 0; i < count; i += 2)
+        SendMessageA(hwnd, LVM_SETITEMSTATE, i, (LPARAM)&item);
+    trace("selecting %d items took %u ms\n", count / 2, GetTickCount() - start);
+    r = SendMessageA(hwnd, LVM_GETSELECTEDCOUNT, 0, 0);
+    expect(count / 2, r);
+
+    start = GetTickCount();
+    for (i = count - 2; i >= 0; i -= 2)
+        SendMessageA(hwnd, LVM_DELETEITEM, i, 0);
+    trace("deleting %d items took %u ms\n", count / 2, GetTickCount() - start);
+    r = SendMessageA(hwnd, LVM_GETITEMCOUNT, 0, 0);
+    expect(count / 2, r);
+    r = SendMessageA(hwnd, LVM_GETSELECTEDCOUNT, 0, 0);
+    expect(0, r);
+
+    for (i = bad = 0; i < count / 2; i++)
+    {
+        item.mask = LVIF_TEXT;
+        item.iItem = i;
+        item.pszText = buff;
+        item.cchTextMax = sizeof(buff);
+        SendMessageA(hwnd, LVM_GETITEMA, 0, (LPARAM)&item);
+        sprintf(text, "%05d", 2 * i + 1);
+        if (strcmp(buff, text)) bad++;
+    }
+    ok(!bad, "%d items are wrong after the deletion\n", bad);
+
+    start = GetTickCount();
+    r = SendMessageA(hwnd, LVM_DELETEALLITEMS, 0, 0);
+    expect(TRUE, r);
+    trace("deleting all %d items took %u ms\n", count / 2, GetTickCount() - start);
+    r = SendMessageA(hwnd, LVM_GETITEMCOUNT, 0, 0);
+    expect(0, r);
+
+    DestroyWindow(hwnd);
+    flush_sequences(sequences, NUM_MSG_SEQUENCES);
+}
+
 static INT CALLBACK DummyCompareEx(LPARAM first, LPARAM second, LPARAM param)
 {
     return 0;
@@ -5593,6 +5782,8 @@ START_TEST(listview)
     test_getitemrect();
     test_subitem_rect();
     test_sorting();
+    test_sorting_many();
+    test_many_items();
     test_ownerdata();
     test_norecompute();
     test_nosortheader();
@@ -227,30 +227,94 @@ void DSOUND_CheckEvent(const IDirectSoundBufferImpl *dsb, DWORD playpos, int len
 	}
 }
 
-static inline float get_current_sample(const IDirectSoundBufferImpl *dsb,
-        DWORD mixpos, DWORD channel)
+/**
+ * Read count frames of one channel, starting at the current mix position,
+ * into a float array. Looping buffers wrap around, others are padded with
+ * silence once their end is reached.
+ */
+static void get_channel_samples(const IDirectSoundBufferImpl *dsb, DWORD channel,
+        float *out, UINT count)
 {
-    if (mixpos >= dsb->buflen && !(dsb->playflags & DSBPLAY_LOOPING))
-        return 0.0f;
-    return dsb->get(dsb, mixpos % dsb->buflen, channel);
+    UINT istride = dsb->pwfx->nBlockAlign;
+    DWORD pos = dsb->sec_mixpos;
+    UINT i;
+
+    for (i = 0; i < count; i++, pos += istride)
+    {
+        while (pos >= dsb->buflen)
+        {
+            if (!(dsb->playflags & DSBPLAY_LOOPING))
+            {
+                for (; i < count; i++)
+                    out[i] = 0.0f;
+                return;
+            }
+            pos -= dsb->buflen;
+        }
+        out[i] = dsb->get(dsb, pos, channel);
+    }
 }
 
 static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
 {
     UINT istride = dsb->pwfx->nBlockAlign;
     UINT ostride = dsb->device->pwfx->nChannels * sizeof(float);
+    DWORD pos = dsb->sec_mixpos;
     DWORD channel, i;
-    for (i = 0; i < count; i++)
+    for (i = 0; i < count; i++, pos += istride)
+    {
+        while (pos >= dsb->buflen && (dsb->playflags & DSBPLAY_LOOPING))
+            pos -= dsb->buflen;
         for (channel = 0; channel < dsb->mix_channels; channel++)
-            dsb->put(dsb, i * ostride, channel, get_current_sample(dsb,
-                    dsb->sec_mixpos + i * istride, channel));
+            dsb->put(dsb, i * ostride, channel,
+                    pos < dsb->buflen ? dsb->get(dsb, pos, channel) : 0.0f);
+    }
     return count;
 }
 
+/**
+ * Advance over count output frames without producing them, used for
+ * buffers that are currently inaudible.
+ */
+static UINT cp_fields_skip(IDirectSoundBufferImpl *dsb, UINT count, float *freqAcc)
+{
+    float freqAcc_end;
+    UINT max_ipos;
+
+    if (dsb->freqAdjust == 1.0)
+        return count;
+
+    freqAcc_end = *freqAcc + count * dsb->freqAdjust;
+    max_ipos = freqAcc_end;
+    *freqAcc = freqAcc_end - (int)freqAcc_end;
+    return max_ipos;
+}
+
+/**
+ * Apply the FIR to one channel of the (non-interleaved) input.
+ * Four partial sums keep the loop free of a serial dependency so
+ * that the compiler can vectorize it.
+ */
+static inline float fir_apply(const float *coeffs, const float *input, int count)
+{
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+    int j;
+
+    for (j = 0; j + 3 < count; j += 4)
+    {
+        sum0 += coeffs[j] * input[j];
+        sum1 += coeffs[j + 1] * input[j + 1];
+        sum2 += coeffs[j + 2] * input[j + 2];
+        sum3 += coeffs[j + 3] * input[j + 3];
+    }
+    for (; j < count; j++)
+        sum0 += coeffs[j] * input[j];
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
 static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, float *freqAcc)
 {
     UINT i, channel;
-    UINT istride = dsb->pwfx->nBlockAlign;
     UINT ostride = dsb->device->pwfx->nChannels * sizeof(float);
 
     float freqAdjust = dsb->freqAdjust;
@@ -262,22 +326,32 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, float *f
 
     UINT fir_cachesize = (fir_len + dsbfirstep - 2) / dsbfirstep;
     UINT required_input = max_ipos + fir_cachesize;
+    UINT size_bytes = sizeof(float) * (required_input * channels + fir_cachesize);
 
-    float* intermediate = HeapAlloc(GetProcessHeap(), 0,
-            sizeof(float) * required_input * channels);
+    float *intermediate, *fir_copy;
 
-    float* fir_copy = HeapAlloc(GetProcessHeap(), 0,
-            sizeof(float) * fir_cachesize);
+    /* The scratch space is kept around in the device, mixing of all the
+     * buffers happens under the device's mixlock. */
+    if (dsb->device->cp_buffer_len < size_bytes || !dsb->device->cp_buffer)
+    {
+        HeapFree(GetProcessHeap(), 0, dsb->device->cp_buffer);
+        dsb->device->cp_buffer = HeapAlloc(GetProcessHeap(), 0, size_bytes);
+        dsb->device->cp_buffer_len = dsb->device->cp_buffer ? size_bytes : 0;
+        if (!dsb->device->cp_buffer)
+        {
+            memset(dsb->device->tmp_buffer, 0, count * ostride);
+            return cp_fields_skip(dsb, count, freqAcc);
+        }
+    }
+    intermediate = dsb->device->cp_buffer;
+    fir_copy = intermediate + required_input * channels;
 
     /* Important: this buffer MUST be non-interleaved
      * if you want -msse3 to have any effect.
      * This is good for CPU cache effects, too.
      */
-    float* itmp = intermediate;
     for (channel = 0; channel < channels; channel++)
-        for (i = 0; i < required_input; i++)
-            *(itmp++) = get_current_sample(dsb,
-                    dsb->sec_mixpos + i * istride, channel);
+        get_channel_samples(dsb, channel, intermediate + channel * required_input, required_input);
 
     for(i = 0; i < count; ++i) {
         float total_fir_steps = (freqAcc_start + i * freqAdjust) * dsbfirstep;
@@ -296,30 +370,24 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, float *f
         assert(fir_used <= fir_cachesize);
         assert(ipos + fir_used <= required_input);
 
-        for (channel = 0; channel < dsb->mix_channels; channel++) {
-            int j;
-            float sum = 0.0;
-            float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
-            dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
-        }
+        for (channel = 0; channel < dsb->mix_channels; channel++)
+            dsb->put(dsb, i * ostride, channel, dsb->firgain *
+                    fir_apply(fir_copy, &intermediate[channel * required_input + ipos], fir_used));
     }
 
     freqAcc_end -= (int)freqAcc_end;
     *freqAcc = freqAcc_end;
 
-    HeapFree(GetProcessHeap(), 0, fir_copy);
-    HeapFree(GetProcessHeap(), 0, intermediate);
-
     return max_ipos;
 }
 
-static void cp_fields(IDirectSoundBufferImpl *dsb, UINT count, float *freqAcc)
+static void cp_fields(IDirectSoundBufferImpl *dsb, UINT count, float *freqAcc, BOOL silent)
 {
     DWORD ipos, adv;
 
-    if (dsb->freqAdjust == 1.0)
+    if (silent)
+        adv = cp_fields_skip(dsb, count, freqAcc);
+    else if (dsb->freqAdjust == 1.0)
         adv = cp_fields_noresample(dsb, count); /* *freqAcc is unmodified */
     else
         adv = cp_fields_resample(dsb, count, freqAcc);
@@ -365,7 +433,7 @@ static inline DWORD DSOUND_BufPtrDiff(DWORD buflen, DWORD ptr1, DWORD ptr2)
  *
  * NOTE: writepos + len <= buflen. When called by mixer, MixOne makes sure of this.
  */
-static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
+static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames, BOOL silent)
 {
 	UINT size_bytes = frames * sizeof(float) * dsb->device->pwfx->nChannels;
 
@@ -378,38 +446,60 @@ static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
 			dsb->device->tmp_buffer = HeapAlloc(GetProcessHeap(), 0, size_bytes);
 	}
 
-	cp_fields(dsb, frames, &dsb->freqAcc);
+	cp_fields(dsb, frames, &dsb->freqAcc, silent);
 }
 
-static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
+/**
+ * Get the volume factors to apply to the buffer.
+ *
+ * Returns FALSE if the samples can be mixed unchanged.
+ */
+static BOOL DSOUND_GetMixerVol(const IDirectSoundBufferImpl *dsb, float *vLeft, float *vRight)
 {
-	INT	i;
-	float vLeft, vRight;
-	UINT channels = dsb->device->pwfx->nChannels, chan;
+	UINT channels = dsb->device->pwfx->nChannels;
 
-	TRACE("(%p,%d)\n",dsb,frames);
 	TRACE("left = %x, right = %x\n", dsb->volpan.dwTotalLeftAmpFactor,
 		dsb->volpan.dwTotalRightAmpFactor);
 
 	if ((!(dsb->dsbd.dwFlags & DSBCAPS_CTRLPAN) || (dsb->volpan.lPan == 0)) &&
 	    (!(dsb->dsbd.dwFlags & DSBCAPS_CTRLVOLUME) || (dsb->volpan.lVolume == 0)) &&
 	     !(dsb->dsbd.dwFlags & DSBCAPS_CTRL3D))
-		return; /* Nothing to do */
+		return FALSE; /* Nothing to do */
 
 	if (channels != 1 && channels != 2)
 	{
 		FIXME("There is no support for %u channels\n", channels);
-		return;
+		return FALSE;
 	}
 
-	vLeft = dsb->volpan.dwTotalLeftAmpFactor / ((float)0xFFFF);
-	vRight = dsb->volpan.dwTotalRightAmpFactor / ((float)0xFFFF);
-	for(i = 0; i < frames; ++i){
-		for(chan = 0; chan < channels; ++chan){
-			if(chan == 0)
-				dsb->device->tmp_buffer[i * channels + chan] *= vLeft;
-			else
-				dsb->device->tmp_buffer[i * channels + chan] *= vRight;
+	*vLeft = dsb->volpan.dwTotalLeftAmpFactor / ((float)0xFFFF);
+	*vRight = channels == 2 ? dsb->volpan.dwTotalRightAmpFactor / ((float)0xFFFF) : *vLeft;
+	return TRUE;
+}
+
+/**
+ * Mix the temporary buffer into the mix buffer, applying the volume on the
+ * way instead of in a separate pass.
+ */
+static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames, float vLeft, float vRight)
+{
+	const float *src = dsb->device->tmp_buffer;
+	float *dst = dsb->device->mix_buffer;
+	INT i;
+
+	TRACE("(%p,%d)\n",dsb,frames);
+
+	if (dsb->device->pwfx->nChannels == 1)
+	{
+		for (i = 0; i < frames; i++)
+			dst[i] += src[i] * vLeft;
+	}
+	else
+	{
+		for (i = 0; i < frames; i++)
+		{
+			dst[2 * i] += src[2 * i] * vLeft;
+			dst[2 * i + 1] += src[2 * i + 1] * vRight;
 		}
 	}
 }
@@ -430,7 +520,8 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
 static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, DWORD writepos, DWORD fraglen)
 {
 	INT len = fraglen;
-	float *ibuf;
+	float vLeft, vRight;
+	BOOL volume, silent;
 	DWORD oldpos;
 	UINT frames = fraglen / dsb->device->pwfx->nBlockAlign;
 
@@ -446,13 +537,18 @@ static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, DWORD writepos, DWO
 	/* Resample buffer to temporary buffer specifically allocated for this purpose, if needed */
 	oldpos = dsb->sec_mixpos;
 
-	DSOUND_MixToTemporary(dsb, frames);
-	ibuf = dsb->device->tmp_buffer;
+	/* Inaudible buffers only need their position to be advanced */
+	volume = DSOUND_GetMixerVol(dsb, &vLeft, &vRight);
+	silent = volume && vLeft == 0.0f && vRight == 0.0f;
 
-	/* Apply volume if needed */
-	DSOUND_MixerVol(dsb, frames);
+	DSOUND_MixToTemporary(dsb, frames, silent);
 
-	mixieee32(ibuf, dsb->device->mix_buffer, frames * dsb->device->pwfx->nChannels);
+	if (silent)
+		TRACE("skipping silent buffer %p\n", dsb);
+	else if (volume)
+		DSOUND_MixerVol(dsb, frames, vLeft, vRight);
+	else
+		mixieee32(dsb->device->tmp_buffer, dsb->device->mix_buffer, frames * dsb->device->pwfx->nChannels);
 
 	/* check for notification positions */
 	if (dsb->dsbd.dwFlags & DSBCAPS_CTRLPOSITIONNOTIFY &&
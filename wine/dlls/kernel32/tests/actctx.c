@@ -1931,6 +1931,24 @@ static void test_actctx(void)
         pReleaseActCtx(handle);
     }
 
+    trace("manifest4 again\n");
+
+    /* the common controls manifest parsed for the previous context is reused */
+    if(!create_manifest_file("test4.manifest", manifest4, -1, NULL, NULL)) {
+        skip("Could not create manifest file\n");
+        return;
+    }
+
+    handle = test_create("test4.manifest");
+    DeleteFileA("test4.manifest");
+    if(handle != INVALID_HANDLE_VALUE) {
+        test_basic_info(handle, __LINE__);
+        test_detailed_info(handle, &detailed_info2, __LINE__);
+        test_info_in_assembly(handle, 1, &manifest4_info, __LINE__);
+        test_info_in_assembly(handle, 2, &manifest_comctrl_info, __LINE__);
+        pReleaseActCtx(handle);
+    }
+
     trace("manifest1 in subdir\n");
 
     CreateDirectoryW(work_dir_subdir, NULL);
@@ -318,6 +318,39 @@ static void test_error_handling(void)
     }
 }
 
+static void test_many_atoms(void)
+{
+    static const int count = 2000;
+    ATOM *atoms = HeapAlloc( GetProcessHeap(), 0, count * sizeof(*atoms) );
+    char name[32];
+    DWORD start;
+    int i;
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "wine_atom_test_%d", i );
+        atoms[i] = GlobalAddAtomA( name );
+        ok( atoms[i] >= 0xc000, "%d: GlobalAddAtomA failed %u\n", i, GetLastError() );
+    }
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "WINE_ATOM_TEST_%d", i );
+        ok( GlobalFindAtomA( name ) == atoms[i], "%d: wrong atom %x/%x\n", i, GlobalFindAtomA( name ), atoms[i] );
+    }
+    trace( "added and found %d atoms in %u ms\n", count, GetTickCount() - start );
+
+    for (i = 0; i < count; i += 2) GlobalDeleteAtom( atoms[i] );
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "wine_atom_test_%d", i );
+        if (i & 1) ok( GlobalFindAtomA( name ) == atoms[i], "%d: atom not found\n", i );
+        else ok( !GlobalFindAtomA( name ), "%d: deleted atom found\n", i );
+    }
+    for (i = 1; i < count; i += 2) GlobalDeleteAtom( atoms[i] );
+    HeapFree( GetProcessHeap(), 0, atoms );
+}
+
 static void test_local_add_atom(void)
 {
     ATOM atom, w_atom;
@@ -593,6 +626,7 @@ START_TEST(atom)
     test_add_atom();
     test_get_atom_name();
     test_error_handling();
+    test_many_atoms();
     test_local_add_atom();
     test_local_get_atom_name();
     test_local_error_handling();
@@ -1963,6 +1963,34 @@ static void test_TerminateProcess(void)
     CloseHandle(pi.hThread);
 }
 
+static void test_StartupTime(void)
+{
+    static const int count = 10;
+    char cmdline[MAX_PATH];
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si;
+    DWORD start, exit_code;
+    BOOL ret;
+    int i;
+
+    memset(&si, 0, sizeof(si));
+    si.cb = sizeof(si);
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        strcpy(cmdline, "cmd /c exit");
+        ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+        ok(ret, "CreateProcess error %u\n", GetLastError());
+        if (!ret) return;
+        ok(WaitForSingleObject(pi.hProcess, 30000) == WAIT_OBJECT_0, "child process wasn't terminated\n");
+        ret = GetExitCodeProcess(pi.hProcess, &exit_code);
+        ok(ret && !exit_code, "GetExitCodeProcess returned %d, exit code %u\n", ret, exit_code);
+        CloseHandle(pi.hProcess);
+        CloseHandle(pi.hThread);
+    }
+    trace("%d runs of cmd /c exit: %u ms per process\n", count, (GetTickCount() - start) / count);
+}
+
 static void test_DuplicateHandle(void)
 {
     char path[MAX_PATH], file_name[MAX_PATH];
@@ -2089,6 +2117,7 @@ START_TEST(process)
     test_SystemInfo();
     test_RegistryQuota();
     test_DuplicateHandle();
+    test_StartupTime();
     /* things that can be tested:
      *  lookup:         check the way program to be executed is searched
      *  handles:        check the handle inheritance stuff (+sec options)
@@ -181,7 +181,7 @@ static BOOL fetch_process_thread( DWORD flags, SYSTEM_PROCESS_INFORMATION** pspi
                                   ULONG* num_pcs, ULONG* num_thd)
 {
     NTSTATUS                    status;
-    ULONG                       size, offset;
+    ULONG                       size, needed, offset;
     PSYSTEM_PROCESS_INFORMATION spi;
 
     *num_pcs = *num_thd = 0;
@@ -191,7 +191,7 @@ static BOOL fetch_process_thread( DWORD flags, SYSTEM_PROCESS_INFORMATION** pspi
     for (;;)
     {
         status = NtQuerySystemInformation( SystemProcessInformation, *pspi,
-                                           size, NULL );
+                                           size, &needed );
         switch (status)
         {
         case STATUS_SUCCESS:
@@ -205,7 +205,9 @@ static BOOL fetch_process_thread( DWORD flags, SYSTEM_PROCESS_INFORMATION** pspi
             } while ((offset = spi->NextEntryOffset));
             return TRUE;
         case STATUS_INFO_LENGTH_MISMATCH:
-            *pspi = HeapReAlloc( GetProcessHeap(), 0, *pspi, size *= 2 );
+            /* retry with the size reported, processes may start in between */
+            size = max( needed, size * 2 );
+            *pspi = HeapReAlloc( GetProcessHeap(), 0, *pspi, size );
             break;
         default:
             SetLastError( RtlNtStatusToDosError( status ) );
@@ -376,7 +376,11 @@ static void release_namespaces(domdoc *This)
 void xmldoc_link_xmldecl(xmlDocPtr doc, xmlNodePtr node)
 {
     assert(doc != NULL);
-    if (doc->standalone != -1) xmlAddPrevSibling( doc->children, node );
+    if (doc->standalone != -1)
+    {
+        xmlAddPrevSibling( doc->children, node );
+        xmlnode_tree_changed();
+    }
 }
 
 /* unlinks a first "<?xml" child if it was created */
@@ -394,6 +398,7 @@ xmlNodePtr xmldoc_unlink_xmldecl(xmlDocPtr doc)
     {
         node = first_child;
         xmlUnlinkNode( node );
+        xmlnode_tree_changed();
     }
     else
         node = NULL;
@@ -1590,6 +1595,7 @@ static HRESULT WINAPI domdoc_put_documentElement(
     /* old root is still orphaned by its document, update refcount from new root */
     if (refcount) xmldoc_add_refs(get_doc(This), refcount);
     oldRoot = xmlDocSetRootElement( get_doc(This), xmlNode->node);
+    xmlnode_tree_changed();
     if (refcount) xmldoc_release_refs(old_doc, refcount);
     IXMLDOMNode_Release( elementNode );
 
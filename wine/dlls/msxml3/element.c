@@ -1056,6 +1056,7 @@ static HRESULT WINAPI domelem_put_dataType(
                 if (attr)
                 {
                     attr = xmlSetNsProp(get_element(This), attr->ns, DT_prefix, dt_to_str(dt));
+                    xmlnode_tree_changed();
                     hr = S_OK;
                 }
                 else
@@ -1067,6 +1068,7 @@ static HRESULT WINAPI domelem_put_dataType(
                         if (attr)
                         {
                             xmlAddChild(get_element(This), (xmlNodePtr)attr);
+                            xmlnode_tree_changed();
                             hr = S_OK;
                         }
                         else
@@ -1289,6 +1291,7 @@ static HRESULT WINAPI domelem_setAttribute(
 
     if (!xmlSetNsProp(element, NULL, xml_name, xml_value))
         hr = E_FAIL;
+    xmlnode_tree_changed();
 
     heap_free(xml_value);
     heap_free(xml_name);
@@ -1446,6 +1449,7 @@ static HRESULT WINAPI domelem_setAttributeNode(
     }
 
     attr = xmlSetNsProp(get_element(This), NULL, name, value);
+    xmlnode_tree_changed();
     if (attr)
         attr_node->parent = (IXMLDOMNode*)iface;
 
@@ -1662,6 +1666,7 @@ static HRESULT domelem_set_named_item(xmlNodePtr node, IXMLDOMNode *newItem, IXM
             WARN("%p is not an orphan of %p\n", ThisNew->node, ThisNew->node->doc);
 
     nodeNew = xmlAddChild(node, ThisNew->node);
+    xmlnode_tree_changed();
 
     if(namedItem)
         *namedItem = create_node( nodeNew );
@@ -1706,6 +1711,7 @@ static HRESULT domelem_remove_qualified_item(xmlNodePtr node, BSTR name, BSTR ur
     if (item)
     {
         xmlUnlinkNode( (xmlNodePtr) attr );
+        xmlnode_tree_changed();
         xmldoc_add_orphan( attr->doc, (xmlNodePtr) attr );
         *item = create_node( (xmlNodePtr) attr );
     }
@@ -1713,6 +1719,7 @@ static HRESULT domelem_remove_qualified_item(xmlNodePtr node, BSTR name, BSTR ur
     {
         if (xmlRemoveProp(attr) == -1)
             ERR("xmlRemoveProp failed\n");
+        xmlnode_tree_changed();
     }
 
     return S_OK;
@@ -252,6 +252,7 @@ HRESULT node_set_content(xmlnode *This, LPCWSTR value)
         return E_OUTOFMEMORY;
 
     xmlNodeSetContent(This->node, str);
+    xmlnode_tree_changed();
     heap_free(str);
     return S_OK;
 }
@@ -273,6 +274,7 @@ static HRESULT node_set_content_escaped(xmlnode *This, LPCWSTR value)
     }
 
     xmlNodeSetContent(This->node, escaped);
+    xmlnode_tree_changed();
 
     heap_free(str);
     xmlFree(escaped);
@@ -483,6 +485,7 @@ HRESULT node_insert_before(xmlnode *This, IXMLDOMNode *new_child, const VARIANT
 
         if (refcount) xmldoc_add_refs(before_node_obj->node->doc, refcount);
         xmlAddPrevSibling(before_node_obj->node, node_obj->node);
+        xmlnode_tree_changed();
         if (refcount) xmldoc_release_refs(doc, refcount);
         node_obj->parent = This->parent;
     }
@@ -503,6 +506,7 @@ HRESULT node_insert_before(xmlnode *This, IXMLDOMNode *new_child, const VARIANT
         /* xmlAddChild doesn't unlink node from previous parent */
         xmlUnlinkNode(node_obj->node);
         xmlAddChild(This->node, node_obj->node);
+        xmlnode_tree_changed();
         if (refcount) xmldoc_release_refs(doc, refcount);
         node_obj->parent = This->iface;
     }
@@ -567,6 +571,7 @@ HRESULT node_replace_child(xmlnode *This, IXMLDOMNode *newChild, IXMLDOMNode *ol
 
     if (refcount) xmldoc_add_refs(old_child->node->doc, refcount);
     xmlReplaceNode(old_child->node, new_child->node);
+    xmlnode_tree_changed();
     if (refcount) xmldoc_release_refs(leaving_doc, refcount);
     new_child->parent = old_child->parent;
     old_child->parent = NULL;
@@ -601,6 +606,7 @@ HRESULT node_remove_child(xmlnode *This, IXMLDOMNode* child, IXMLDOMNode** oldCh
     }
 
     xmlUnlinkNode(child_node->node);
+    xmlnode_tree_changed();
     child_node->parent = NULL;
     xmldoc_add_orphan(child_node->node->doc, child_node->node);
 
@@ -801,6 +807,7 @@ HRESULT node_put_text(xmlnode *This, BSTR text)
     heap_free(str);
 
     xmlNodeSetContent(This->node, str2);
+    xmlnode_tree_changed();
     xmlFree(str2);
 
     return S_OK;
@@ -1133,6 +1140,20 @@ HRESULT node_get_base_name(xmlnode *This, BSTR *name)
     return S_OK;
 }
 
+/* Incremented on every change to children lists of libxml2 nodes, so positions
+   cached by node lists can be checked before they are used. */
+static LONG tree_version;
+
+void xmlnode_tree_changed(void)
+{
+    InterlockedIncrement(&tree_version);
+}
+
+LONG xmlnode_get_tree_version(void)
+{
+    return tree_version;
+}
+
 /* _private field holds a number of COM instances spawned from this libxml2 node */
 static void xmlnode_add_ref(xmlNodePtr node)
 {
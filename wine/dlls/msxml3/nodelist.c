@@ -60,8 +60,25 @@ typedef struct
     xmlNodePtr parent;
     xmlNodePtr current;
     IEnumVARIANT *enumvariant;
+    /* last position looked up, valid while tree version matches */
+    LONG version;
+    LONG cursor_index;
+    xmlNodePtr cursor;
+    LONG length;
 } xmlnodelist;
 
+static void xmlnodelist_validate(xmlnodelist *This)
+{
+    LONG version = xmlnode_get_tree_version();
+
+    if (This->version == version) return;
+
+    This->version = version;
+    This->cursor = NULL;
+    This->cursor_index = 0;
+    This->length = -1;
+}
+
 static HRESULT nodelist_get_item(IUnknown *iface, LONG index, VARIANT *item)
 {
     V_VT(item) = VT_DISPATCH;
@@ -212,13 +229,37 @@ static HRESULT WINAPI xmlnodelist_get_item(
     if (index < 0)
         return S_FALSE;
 
+    xmlnodelist_validate(This);
+    if (This->length != -1 && index >= This->length)
+        return S_FALSE;
+
+    /* walk from the cached position when it is closer than the first child,
+       so that sequential access by index doesn't rescan the list */
     curr = This->parent->children;
-    while(curr)
+    if (This->cursor && This->cursor_index <= index * 2)
+    {
+        curr = This->cursor;
+        nodeIndex = This->cursor_index;
+        while (curr && nodeIndex > index)
+        {
+            curr = curr->prev;
+            nodeIndex--;
+        }
+    }
+
+    while(curr && nodeIndex < index)
     {
-        if(nodeIndex++ == index) break;
         curr = curr->next;
+        nodeIndex++;
     }
-    if(!curr) return S_FALSE;
+    if(!curr)
+    {
+        This->length = nodeIndex;
+        return S_FALSE;
+    }
+
+    This->cursor = curr;
+    This->cursor_index = index;
 
     *listItem = create_node( curr );
 
@@ -240,14 +281,26 @@ static HRESULT WINAPI xmlnodelist_get_length(
     if(!listLength)
         return E_INVALIDARG;
 
+    xmlnodelist_validate(This);
+    if (This->length != -1)
+    {
+        *listLength = This->length;
+        return S_OK;
+    }
+
     curr = This->parent->children;
+    if (This->cursor)
+    {
+        curr = This->cursor;
+        nodeCount = This->cursor_index;
+    }
     while (curr)
     {
         nodeCount++;
         curr = curr->next;
     }
 
-    *listLength = nodeCount;
+    *listLength = This->length = nodeCount;
     return S_OK;
 }
 
@@ -420,6 +473,10 @@ IXMLDOMNodeList* create_children_nodelist( xmlNodePtr node )
     This->parent = node;
     This->current = node->children;
     This->enumvariant = NULL;
+    This->version = xmlnode_get_tree_version() - 1;
+    This->cursor = NULL;
+    This->cursor_index = 0;
+    This->length = -1;
     xmldoc_add_ref( node->doc );
 
     init_dispex(&This->dispex, (IUnknown*)&This->IXMLDOMNodeList_iface, &xmlnodelist_dispex);
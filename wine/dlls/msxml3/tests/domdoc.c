@@ -11795,6 +11795,107 @@ static void test_url(void)
     IXMLDOMDocument_Release(doc);
 }
 
+static void check_child_text(IXMLDOMNodeList *list, LONG index, int expected, int line)
+{
+    IXMLDOMNode *node;
+    char buff[16];
+    HRESULT hr;
+    BSTR str;
+
+    hr = IXMLDOMNodeList_get_item(list, index, &node);
+    ok_(__FILE__,line)(hr == S_OK, "%d: got 0x%08x\n", index, hr);
+    if (hr != S_OK) return;
+
+    hr = IXMLDOMNode_get_text(node, &str);
+    ok_(__FILE__,line)(hr == S_OK, "%d: got 0x%08x\n", index, hr);
+    sprintf(buff, "%d", expected);
+    ok_(__FILE__,line)(!lstrcmpW(str, _bstr_(buff)), "%d: got %s, expected %s\n", index, wine_dbgstr_w(str), buff);
+    SysFreeString(str);
+    IXMLDOMNode_Release(node);
+}
+
+static void test_childnodes_large(void)
+{
+    static const int count = 5000;
+    IXMLDOMNodeList *list;
+    IXMLDOMDocument *doc;
+    IXMLDOMElement *root;
+    IXMLDOMNode *node, *removed;
+    VARIANT_BOOL b;
+    DWORD start;
+    char *xml, *ptr;
+    HRESULT hr;
+    LONG len, i;
+
+    xml = HeapAlloc(GetProcessHeap(), 0, count * 20 + 16);
+    ptr = xml + sprintf(xml, "<r>");
+    for (i = 0; i < count; i++)
+        ptr += sprintf(ptr, "<e>%d</e>", i);
+    strcpy(ptr, "</r>");
+
+    doc = create_document(&IID_IXMLDOMDocument);
+    hr = IXMLDOMDocument_loadXML(doc, _bstr_(xml), &b);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(b == VARIANT_TRUE, "failed to load XML string\n");
+    HeapFree(GetProcessHeap(), 0, xml);
+
+    hr = IXMLDOMDocument_get_documentElement(doc, &root);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = IXMLDOMElement_get_childNodes(root, &list);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        hr = IXMLDOMNodeList_get_length(list, &len);
+        ok(hr == S_OK, "got 0x%08x\n", hr);
+        ok(len == count, "got %d\n", len);
+
+        hr = IXMLDOMNodeList_get_item(list, i, &node);
+        ok(hr == S_OK, "%d: got 0x%08x\n", i, hr);
+        IXMLDOMNode_Release(node);
+    }
+    trace("indexed walk over %d children took %u ms\n", count, GetTickCount() - start);
+
+    hr = IXMLDOMNodeList_get_item(list, count, &node);
+    ok(hr == S_FALSE, "got 0x%08x\n", hr);
+
+    /* backward and random access */
+    check_child_text(list, count - 1, count - 1, __LINE__);
+    check_child_text(list, 10, 10, __LINE__);
+    check_child_text(list, count / 2, count / 2, __LINE__);
+    check_child_text(list, count / 2 - 1, count / 2 - 1, __LINE__);
+
+    /* list is live, changes are visible through a cached position */
+    hr = IXMLDOMNodeList_get_item(list, count / 2, &node);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = IXMLDOMElement_removeChild(root, node, &removed);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    IXMLDOMNode_Release(node);
+
+    hr = IXMLDOMNodeList_get_length(list, &len);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(len == count - 1, "got %d\n", len);
+    check_child_text(list, count / 2, count / 2 + 1, __LINE__);
+    check_child_text(list, count / 2 - 1, count / 2 - 1, __LINE__);
+    hr = IXMLDOMNodeList_get_item(list, count - 1, &node);
+    ok(hr == S_FALSE, "got 0x%08x\n", hr);
+
+    hr = IXMLDOMElement_appendChild(root, removed, NULL);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    IXMLDOMNode_Release(removed);
+
+    hr = IXMLDOMNodeList_get_length(list, &len);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(len == count, "got %d\n", len);
+    check_child_text(list, count - 1, count / 2, __LINE__);
+
+    IXMLDOMNodeList_Release(list);
+    IXMLDOMElement_Release(root);
+    IXMLDOMDocument_Release(doc);
+    free_bstrs();
+}
+
 START_TEST(domdoc)
 {
     HRESULT hr;
@@ -11874,6 +11975,7 @@ START_TEST(domdoc)
     test_namedmap_newenum();
     test_xmlns_attribute();
     test_url();
+    test_childnodes_large();
 
     test_xsltemplate();
     test_xsltext();
@@ -245,6 +245,7 @@ static HRESULT WINAPI xmlelem_setAttribute(IXMLElement *iface, BSTR strPropertyN
     name = xmlchar_from_wchar(strPropertyName);
     value = xmlchar_from_wchar(V_BSTR(&PropertyValue));
     attr = xmlSetProp(This->node, name, value);
+    xmlnode_tree_changed();
 
     heap_free(name);
     heap_free(value);
@@ -332,6 +333,7 @@ static HRESULT WINAPI xmlelem_removeAttribute(IXMLElement *iface, BSTR strProper
         goto done;
 
     res = xmlRemoveProp(attr);
+    xmlnode_tree_changed();
 
     if (res == 0)
         hr = S_OK;
@@ -421,6 +423,7 @@ static HRESULT WINAPI xmlelem_put_text(IXMLElement *iface, BSTR p)
 
     content = xmlchar_from_wchar(p);
     xmlNodeSetContent(This->node, content);
+    xmlnode_tree_changed();
 
     heap_free(content);
 
@@ -443,6 +446,7 @@ static HRESULT WINAPI xmlelem_addChild(IXMLElement *iface, IXMLElement *pChildEl
 
     /* parent is responsible for child data */
     if (child) childElem->own = FALSE;
+    xmlnode_tree_changed();
 
     return (child) ? S_OK : S_FALSE;
 }
@@ -462,6 +466,7 @@ static HRESULT WINAPI xmlelem_removeChild(IXMLElement *iface, IXMLElement *pChil
         return E_INVALIDARG;
 
     xmlUnlinkNode(childElem->node);
+    xmlnode_tree_changed();
     /* standalone element now */
     childElem->own = TRUE;
 
@@ -25,8 +25,17 @@
 #include "config.h"
 #include "wine/port.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <sys/types.h>
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
 
 #define NONAMELESSUNION
 #define NONAMELESSSTRUCT
@@ -37,6 +46,8 @@
 #include "ntdll_misc.h"
 #include "wine/exception.h"
 #include "wine/debug.h"
+#include "wine/library.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(actctx);
@@ -173,6 +184,32 @@ struct guid_index
     ULONG rosterindex;
 };
 
+/* sorted copies of the section indexes, built on first lookup so that the
+ * sections keep the layout applications see */
+struct string_lookup_entry
+{
+    ULONG hash;
+    ULONG pos;         /* position in the section index */
+};
+
+struct string_lookup
+{
+    ULONG count;
+    struct string_lookup_entry entries[1];
+};
+
+struct guid_lookup_entry
+{
+    GUID  guid;
+    ULONG pos;
+};
+
+struct guid_lookup
+{
+    ULONG count;
+    struct guid_lookup_entry entries[1];
+};
+
 struct wndclass_redirect_data
 {
     ULONG size;
@@ -530,14 +567,39 @@ typedef struct _ACTIVATION_CONTEXT
     struct guidsection_header *comserver_section;
     struct guidsection_header *ifaceps_section;
     struct guidsection_header *clrsurrogate_section;
+    /* section lookup tables */
+    struct string_lookup      *wndclass_lookup;
+    struct string_lookup      *dllredirect_lookup;
+    struct string_lookup      *progid_lookup;
+    struct guid_lookup        *tlib_lookup;
+    struct guid_lookup        *comserver_lookup;
+    struct guid_lookup        *ifaceps_lookup;
+    struct guid_lookup        *clrsurrogate_lookup;
 } ACTIVATION_CONTEXT;
 
+/* parsed shared assembly manifest, reused by the activation contexts
+ * created later in the process that depend on the same file */
+struct manifest_cache_entry
+{
+    struct list               entry;
+    WCHAR                    *path;         /* NT path of the manifest file */
+    LARGE_INTEGER             write_time;
+    LARGE_INTEGER             size;
+    struct assembly_version   version;      /* version the manifest was looked up with */
+    struct assembly           assembly;
+    struct assembly_identity *deps;         /* dependent assemblies declared by the manifest */
+    unsigned int              num_deps;
+    unsigned int              allocated_deps;
+    BOOL                      incomplete;   /* recording the dependencies failed */
+};
+
 struct actctx_loader
 {
     ACTIVATION_CONTEXT       *actctx;
     struct assembly_identity *dependencies;
     unsigned int              num_dependencies;
     unsigned int              allocated_dependencies;
+    struct manifest_cache_entry *cache_entry; /* records the manifest being parsed */
 };
 
 static const WCHAR asmv1W[] = {'a','s','m','v','1',':',0};
@@ -849,6 +911,7 @@ static void free_entity_array(struct entity_array *array)
         case ACTIVATION_CONTEXT_SECTION_COM_INTERFACE_REDIRECTION:
             RtlFreeHeap(GetProcessHeap(), 0, entity->u.ifaceps.iid);
             RtlFreeHeap(GetProcessHeap(), 0, entity->u.ifaceps.base);
+            RtlFreeHeap(GetProcessHeap(), 0, entity->u.ifaceps.tlib);
             RtlFreeHeap(GetProcessHeap(), 0, entity->u.ifaceps.ps32);
             RtlFreeHeap(GetProcessHeap(), 0, entity->u.ifaceps.name);
             break;
@@ -871,6 +934,184 @@ static void free_entity_array(struct entity_array *array)
     RtlFreeHeap( GetProcessHeap(), 0, array->base );
 }
 
+static BOOL copy_string( WCHAR **dst, const WCHAR *src )
+{
+    *dst = NULL;
+    return !src || (*dst = strdupW( src ));
+}
+
+static BOOL copy_assembly_identity( struct assembly_identity *dst, const struct assembly_identity *src )
+{
+    memset( dst, 0, sizeof(*dst) );
+    dst->version = src->version;
+    dst->optional = src->optional;
+    if (copy_string( &dst->name, src->name ) && copy_string( &dst->arch, src->arch ) &&
+        copy_string( &dst->public_key, src->public_key ) && copy_string( &dst->language, src->language ) &&
+        copy_string( &dst->type, src->type ))
+        return TRUE;
+    free_assembly_identity( dst );
+    return FALSE;
+}
+
+/* the destination array is freed by the caller on failure */
+static BOOL copy_entity_array( struct entity_array *dst, const struct entity_array *src )
+{
+    unsigned int i, j;
+
+    memset( dst, 0, sizeof(*dst) );
+    if (!src->num) return TRUE;
+    if (!(dst->base = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, src->num * sizeof(*dst->base) )))
+        return FALSE;
+    dst->allocated = src->num;
+
+    for (i = 0; i < src->num; i++)
+    {
+        const struct entity *from = &src->base[i];
+        struct entity *to = &dst->base[dst->num++];
+
+        to->kind = from->kind;
+        switch (from->kind)
+        {
+        case ACTIVATION_CONTEXT_SECTION_COM_SERVER_REDIRECTION:
+            to->u.comclass.model = from->u.comclass.model;
+            to->u.comclass.miscstatus = from->u.comclass.miscstatus;
+            to->u.comclass.miscstatuscontent = from->u.comclass.miscstatuscontent;
+            to->u.comclass.miscstatusthumbnail = from->u.comclass.miscstatusthumbnail;
+            to->u.comclass.miscstatusicon = from->u.comclass.miscstatusicon;
+            to->u.comclass.miscstatusdocprint = from->u.comclass.miscstatusdocprint;
+            if (!copy_string( &to->u.comclass.clsid, from->u.comclass.clsid ) ||
+                !copy_string( &to->u.comclass.tlbid, from->u.comclass.tlbid ) ||
+                !copy_string( &to->u.comclass.progid, from->u.comclass.progid ) ||
+                !copy_string( &to->u.comclass.name, from->u.comclass.name ) ||
+                !copy_string( &to->u.comclass.version, from->u.comclass.version ))
+                return FALSE;
+            if (!from->u.comclass.progids.num) break;
+            if (!(to->u.comclass.progids.progids = RtlAllocateHeap( GetProcessHeap(), 0,
+                      from->u.comclass.progids.num * sizeof(WCHAR *) )))
+                return FALSE;
+            to->u.comclass.progids.allocated = from->u.comclass.progids.num;
+            for (j = 0; j < from->u.comclass.progids.num; j++)
+            {
+                if (!(to->u.comclass.progids.progids[j] = strdupW( from->u.comclass.progids.progids[j] )))
+                    return FALSE;
+                to->u.comclass.progids.num++;
+            }
+            break;
+        case ACTIVATION_CONTEXT_SECTION_COM_INTERFACE_REDIRECTION:
+            to->u.ifaceps.mask = from->u.ifaceps.mask;
+            to->u.ifaceps.nummethods = from->u.ifaceps.nummethods;
+            if (!copy_string( &to->u.ifaceps.iid, from->u.ifaceps.iid ) ||
+                !copy_string( &to->u.ifaceps.base, from->u.ifaceps.base ) ||
+                !copy_string( &to->u.ifaceps.tlib, from->u.ifaceps.tlib ) ||
+                !copy_string( &to->u.ifaceps.name, from->u.ifaceps.name ) ||
+                !copy_string( &to->u.ifaceps.ps32, from->u.ifaceps.ps32 ))
+                return FALSE;
+            break;
+        case ACTIVATION_CONTEXT_SECTION_COM_TYPE_LIBRARY_REDIRECTION:
+            to->u.typelib.flags = from->u.typelib.flags;
+            to->u.typelib.major = from->u.typelib.major;
+            to->u.typelib.minor = from->u.typelib.minor;
+            if (!copy_string( &to->u.typelib.tlbid, from->u.typelib.tlbid ) ||
+                !copy_string( &to->u.typelib.helpdir, from->u.typelib.helpdir ))
+                return FALSE;
+            break;
+        case ACTIVATION_CONTEXT_SECTION_WINDOW_CLASS_REDIRECTION:
+            to->u.class.versioned = from->u.class.versioned;
+            if (!copy_string( &to->u.class.name, from->u.class.name )) return FALSE;
+            break;
+        case ACTIVATION_CONTEXT_SECTION_CLR_SURROGATES:
+            if (!copy_string( &to->u.clrsurrogate.name, from->u.clrsurrogate.name ) ||
+                !copy_string( &to->u.clrsurrogate.clsid, from->u.clrsurrogate.clsid ) ||
+                !copy_string( &to->u.clrsurrogate.version, from->u.clrsurrogate.version ))
+                return FALSE;
+            break;
+        }
+    }
+    return TRUE;
+}
+
+/* sections needed by the entities of a copied assembly, as set by the parser */
+static DWORD get_entity_sections( const struct entity_array *array )
+{
+    DWORD sections = 0;
+    unsigned int i;
+
+    for (i = 0; i < array->num; i++)
+    {
+        const struct entity *entity = &array->base[i];
+
+        switch (entity->kind)
+        {
+        case ACTIVATION_CONTEXT_SECTION_COM_SERVER_REDIRECTION:
+            sections |= SERVERREDIRECT_SECTION;
+            if (entity->u.comclass.progid || entity->u.comclass.progids.num)
+                sections |= PROGIDREDIRECT_SECTION;
+            break;
+        case ACTIVATION_CONTEXT_SECTION_COM_INTERFACE_REDIRECTION:
+            sections |= IFACEREDIRECT_SECTION;
+            break;
+        case ACTIVATION_CONTEXT_SECTION_COM_TYPE_LIBRARY_REDIRECTION:
+            sections |= TLIBREDIRECT_SECTION;
+            break;
+        case ACTIVATION_CONTEXT_SECTION_WINDOW_CLASS_REDIRECTION:
+            sections |= WINDOWCLASS_SECTION;
+            break;
+        case ACTIVATION_CONTEXT_SECTION_CLR_SURROGATES:
+            sections |= CLRSURROGATES_SECTION;
+            break;
+        }
+    }
+    return sections;
+}
+
+static void free_assembly( struct assembly *assembly )
+{
+    unsigned int i;
+
+    for (i = 0; i < assembly->num_dlls; i++)
+    {
+        struct dll_redirect *dll = &assembly->dlls[i];
+        free_entity_array( &dll->entities );
+        RtlFreeHeap( GetProcessHeap(), 0, dll->name );
+        RtlFreeHeap( GetProcessHeap(), 0, dll->hash );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, assembly->dlls );
+    RtlFreeHeap( GetProcessHeap(), 0, assembly->manifest.info );
+    RtlFreeHeap( GetProcessHeap(), 0, assembly->directory );
+    free_entity_array( &assembly->entities );
+    free_assembly_identity( &assembly->id );
+}
+
+/* the destination is zeroed and freed with free_assembly by the caller on failure */
+static BOOL copy_assembly( struct assembly *dst, const struct assembly *src )
+{
+    unsigned int i;
+
+    dst->type = src->type;
+    dst->manifest.type = src->manifest.type;
+    dst->no_inherit = src->no_inherit;
+    if (!copy_assembly_identity( &dst->id, &src->id ) ||
+        !copy_string( &dst->manifest.info, src->manifest.info ) ||
+        !copy_string( &dst->directory, src->directory ) ||
+        !copy_entity_array( &dst->entities, &src->entities ))
+        return FALSE;
+
+    if (!src->num_dlls) return TRUE;
+    if (!(dst->dlls = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, src->num_dlls * sizeof(*dst->dlls) )))
+        return FALSE;
+    dst->allocated_dlls = src->num_dlls;
+    for (i = 0; i < src->num_dlls; i++)
+    {
+        struct dll_redirect *dll = &dst->dlls[dst->num_dlls++];
+
+        if (!copy_string( &dll->name, src->dlls[i].name ) ||
+            !copy_string( &dll->hash, src->dlls[i].hash ) ||
+            !copy_entity_array( &dll->entities, &src->dlls[i].entities ))
+            return FALSE;
+    }
+    return TRUE;
+}
+
 static BOOL is_matching_string( const WCHAR *str1, const WCHAR *str2 )
 {
     if (!str1) return !str2;
@@ -954,6 +1195,490 @@ static void free_depend_manifests(struct actctx_loader* acl)
     RtlFreeHeap(GetProcessHeap(), 0, acl->dependencies);
 }
 
+#define MANIFEST_CACHE_MAX 32
+
+static struct list manifest_cache = LIST_INIT( manifest_cache );
+static unsigned int manifest_cache_size;
+
+static RTL_CRITICAL_SECTION manifest_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG manifest_cache_debug =
+{
+    0, 0, &manifest_cache_section,
+    { &manifest_cache_debug.ProcessLocksList, &manifest_cache_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": manifest_cache_section") }
+};
+static RTL_CRITICAL_SECTION manifest_cache_section = { &manifest_cache_debug, -1, 0, 0, 0, 0 };
+
+static void free_manifest_cache_entry( struct manifest_cache_entry *cache )
+{
+    unsigned int i;
+
+    for (i = 0; i < cache->num_deps; i++) free_assembly_identity( &cache->deps[i] );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->deps );
+    free_assembly( &cache->assembly );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->path );
+    RtlFreeHeap( GetProcessHeap(), 0, cache );
+}
+
+static struct manifest_cache_entry *alloc_manifest_cache_entry( const WCHAR *path, const struct assembly_identity *ai,
+                                                                const LARGE_INTEGER *write_time,
+                                                                const LARGE_INTEGER *size )
+{
+    struct manifest_cache_entry *cache;
+
+    if (!(cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache) ))) return NULL;
+    if (!(cache->path = strdupW( path )))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, cache );
+        return NULL;
+    }
+    cache->write_time = *write_time;
+    cache->size = *size;
+    cache->version = ai->version;
+    return cache;
+}
+
+/* remember a dependency declared by the manifest being parsed */
+static void record_dependency( struct actctx_loader *acl, const struct assembly_identity *ai )
+{
+    struct manifest_cache_entry *cache = acl->cache_entry;
+
+    if (!cache || cache->incomplete) return;
+
+    if (cache->num_deps == cache->allocated_deps)
+    {
+        unsigned int new_count = cache->deps ? cache->allocated_deps * 2 : 4;
+        void *ptr;
+
+        if (cache->deps)
+            ptr = RtlReAllocateHeap( GetProcessHeap(), 0, cache->deps, new_count * sizeof(*cache->deps) );
+        else
+            ptr = RtlAllocateHeap( GetProcessHeap(), 0, new_count * sizeof(*cache->deps) );
+        if (!ptr)
+        {
+            cache->incomplete = TRUE;
+            return;
+        }
+        cache->deps = ptr;
+        cache->allocated_deps = new_count;
+    }
+    if (copy_assembly_identity( &cache->deps[cache->num_deps], ai )) cache->num_deps++;
+    else cache->incomplete = TRUE;
+}
+
+/* add a complete entry to the cache, replacing the older parse of the same manifest and version */
+static void add_manifest_cache_entry( struct manifest_cache_entry *cache )
+{
+    struct manifest_cache_entry *old, *next;
+
+    RtlEnterCriticalSection( &manifest_cache_section );
+    LIST_FOR_EACH_ENTRY_SAFE( old, next, &manifest_cache, struct manifest_cache_entry, entry )
+    {
+        if (strcmpiW( old->path, cache->path ) ||
+            memcmp( &old->version, &cache->version, sizeof(old->version) )) continue;
+        list_remove( &old->entry );
+        free_manifest_cache_entry( old );
+        manifest_cache_size--;
+    }
+    list_add_head( &manifest_cache, &cache->entry );
+    if (++manifest_cache_size > MANIFEST_CACHE_MAX)
+    {
+        old = LIST_ENTRY( list_tail( &manifest_cache ), struct manifest_cache_entry, entry );
+        list_remove( &old->entry );
+        free_manifest_cache_entry( old );
+        manifest_cache_size--;
+    }
+    RtlLeaveCriticalSection( &manifest_cache_section );
+}
+
+/* The parsed manifests are also saved in the server directory, so that the
+ * other processes using the same prefix don't parse them again.  There is
+ * one file per manifest path and version, which is replaced when the
+ * manifest changes; it holds the same data as the cache entry. */
+
+#define MANIFEST_BLOB_MAGIC    0x31424d57  /* "WMB1" */
+#define MANIFEST_BLOB_MAX_SIZE (4 * 1024 * 1024)
+#define MANIFEST_BLOB_NAME_MAX 1024
+
+struct manifest_blob
+{
+    BYTE   *data;
+    SIZE_T  pos;
+    SIZE_T  size;
+    BOOL    writing;
+};
+
+/* append to the blob or read from it, depending on its direction */
+static BOOL blob_data( struct manifest_blob *blob, void *data, SIZE_T len )
+{
+    if (blob->writing)
+    {
+        if (len > blob->size - blob->pos)
+        {
+            SIZE_T new_size = max( blob->size * 2, blob->pos + len + 4096 );
+            void *ptr;
+
+            if (blob->data) ptr = RtlReAllocateHeap( GetProcessHeap(), 0, blob->data, new_size );
+            else ptr = RtlAllocateHeap( GetProcessHeap(), 0, new_size );
+            if (!ptr) return FALSE;
+            blob->data = ptr;
+            blob->size = new_size;
+        }
+        memcpy( blob->data + blob->pos, data, len );
+    }
+    else
+    {
+        if (len > blob->size - blob->pos) return FALSE;
+        memcpy( data, blob->data + blob->pos, len );
+    }
+    blob->pos += len;
+    return TRUE;
+}
+
+#define blob_value(blob,ptr) blob_data( (blob), (ptr), sizeof(*(ptr)) )
+
+/* strings are stored with their length plus one, 0 for a NULL string */
+static BOOL blob_string( struct manifest_blob *blob, WCHAR **str )
+{
+    ULONG len = 0;
+
+    if (blob->writing)
+    {
+        if (*str) len = strlenW( *str ) + 1;
+        return blob_value( blob, &len ) && (!len || blob_data( blob, *str, (len - 1) * sizeof(WCHAR) ));
+    }
+    *str = NULL;
+    if (!blob_value( blob, &len )) return FALSE;
+    if (!len) return TRUE;
+    if (len - 1 > (blob->size - blob->pos) / sizeof(WCHAR)) return FALSE;
+    if (!(*str = RtlAllocateHeap( GetProcessHeap(), 0, len * sizeof(WCHAR) ))) return FALSE;
+    (*str)[len - 1] = 0;
+    return blob_data( blob, *str, (len - 1) * sizeof(WCHAR) );
+}
+
+/* store the element count, or read it and allocate the array; when reading,
+ * the caller counts the elements in as they are read so that a partially
+ * read array can be freed */
+static BOOL blob_array( struct manifest_blob *blob, void **array, unsigned int num,
+                        unsigned int *allocated, SIZE_T elem_size, unsigned int *count )
+{
+    *count = num;
+    if (!blob_value( blob, count )) return FALSE;
+    if (blob->writing || !*count) return TRUE;
+    /* every element takes at least a length in the blob */
+    if (*count > (blob->size - blob->pos) / sizeof(ULONG)) return FALSE;
+    if (!(*array = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, *count * elem_size ))) return FALSE;
+    *allocated = *count;
+    return TRUE;
+}
+
+static BOOL blob_assembly_identity( struct manifest_blob *blob, struct assembly_identity *ai )
+{
+    return blob_string( blob, &ai->name ) && blob_string( blob, &ai->arch ) &&
+           blob_string( blob, &ai->public_key ) && blob_string( blob, &ai->language ) &&
+           blob_string( blob, &ai->type ) && blob_value( blob, &ai->version ) &&
+           blob_value( blob, &ai->optional );
+}
+
+static BOOL blob_entity_array( struct manifest_blob *blob, struct entity_array *array )
+{
+    unsigned int i, j, count, progids;
+
+    if (!blob_array( blob, (void **)&array->base, array->num, &array->allocated,
+                     sizeof(*array->base), &count ))
+        return FALSE;
+
+    for (i = 0; i < count; i++)
+    {
+        struct entity *entity = &array->base[i];
+
+        if (!blob_value( blob, &entity->kind )) return FALSE;
+        switch (entity->kind)
+        {
+        case ACTIVATION_CONTEXT_SECTION_COM_SERVER_REDIRECTION:
+        case ACTIVATION_CONTEXT_SECTION_COM_INTERFACE_REDIRECTION:
+        case ACTIVATION_CONTEXT_SECTION_COM_TYPE_LIBRARY_REDIRECTION:
+        case ACTIVATION_CONTEXT_SECTION_WINDOW_CLASS_REDIRECTION:
+        case ACTIVATION_CONTEXT_SECTION_CLR_SURROGATES:
+            break;
+        default:
+            return FALSE;
+        }
+        if (!blob->writing) array->num++;
+
+        switch (entity->kind)
+        {
+        case ACTIVATION_CONTEXT_SECTION_COM_SERVER_REDIRECTION:
+            if (!blob_string( blob, &entity->u.comclass.clsid ) ||
+                !blob_string( blob, &entity->u.comclass.tlbid ) ||
+                !blob_string( blob, &entity->u.comclass.progid ) ||
+                !blob_string( blob, &entity->u.comclass.name ) ||
+                !blob_string( blob, &entity->u.comclass.version ) ||
+                !blob_value( blob, &entity->u.comclass.model ) ||
+                !blob_value( blob, &entity->u.comclass.miscstatus ) ||
+                !blob_value( blob, &entity->u.comclass.miscstatuscontent ) ||
+                !blob_value( blob, &entity->u.comclass.miscstatusthumbnail ) ||
+                !blob_value( blob, &entity->u.comclass.miscstatusicon ) ||
+                !blob_value( blob, &entity->u.comclass.miscstatusdocprint ) ||
+                !blob_array( blob, (void **)&entity->u.comclass.progids.progids,
+                             entity->u.comclass.progids.num, &entity->u.comclass.progids.allocated,
+                             sizeof(WCHAR *), &progids ))
+                return FALSE;
+            for (j = 0; j < progids; j++)
+            {
+                if (!blob->writing) entity->u.comclass.progids.num++;
+                if (!blob_string( blob, &entity->u.comclass.progids.progids[j] )) return FALSE;
+            }
+            break;
+        case ACTIVATION_CONTEXT_SECTION_COM_INTERFACE_REDIRECTION:
+            if (!blob_string( blob, &entity->u.ifaceps.iid ) ||
+                !blob_string( blob, &entity->u.ifaceps.base ) ||
+                !blob_string( blob, &entity->u.ifaceps.tlib ) ||
+                !blob_string( blob, &entity->u.ifaceps.name ) ||
+                !blob_string( blob, &entity->u.ifaceps.ps32 ) ||
+                !blob_value( blob, &entity->u.ifaceps.mask ) ||
+                !blob_value( blob, &entity->u.ifaceps.nummethods ))
+                return FALSE;
+            break;
+        case ACTIVATION_CONTEXT_SECTION_COM_TYPE_LIBRARY_REDIRECTION:
+            if (!blob_string( blob, &entity->u.typelib.tlbid ) ||
+                !blob_string( blob, &entity->u.typelib.helpdir ) ||
+                !blob_value( blob, &entity->u.typelib.flags ) ||
+                !blob_value( blob, &entity->u.typelib.major ) ||
+                !blob_value( blob, &entity->u.typelib.minor ))
+                return FALSE;
+            break;
+        case ACTIVATION_CONTEXT_SECTION_WINDOW_CLASS_REDIRECTION:
+            if (!blob_string( blob, &entity->u.class.name ) ||
+                !blob_value( blob, &entity->u.class.versioned ))
+                return FALSE;
+            break;
+        case ACTIVATION_CONTEXT_SECTION_CLR_SURROGATES:
+            if (!blob_string( blob, &entity->u.clrsurrogate.name ) ||
+                !blob_string( blob, &entity->u.clrsurrogate.clsid ) ||
+                !blob_string( blob, &entity->u.clrsurrogate.version ))
+                return FALSE;
+            break;
+        }
+    }
+    return TRUE;
+}
+
+static BOOL blob_assembly( struct manifest_blob *blob, struct assembly *assembly )
+{
+    unsigned int i, count;
+
+    if (!blob_value( blob, &assembly->type ) ||
+        !blob_assembly_identity( blob, &assembly->id ) ||
+        !blob_value( blob, &assembly->manifest.type ) ||
+        !blob_string( blob, &assembly->manifest.info ) ||
+        !blob_string( blob, &assembly->directory ) ||
+        !blob_value( blob, &assembly->no_inherit ) ||
+        !blob_entity_array( blob, &assembly->entities ) ||
+        !blob_array( blob, (void **)&assembly->dlls, assembly->num_dlls, &assembly->allocated_dlls,
+                     sizeof(*assembly->dlls), &count ))
+        return FALSE;
+
+    for (i = 0; i < count; i++)
+    {
+        struct dll_redirect *dll = &assembly->dlls[i];
+
+        if (!blob->writing) assembly->num_dlls++;
+        if (!blob_string( blob, &dll->name ) ||
+            !blob_string( blob, &dll->hash ) ||
+            !blob_entity_array( blob, &dll->entities ))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static BOOL blob_manifest_cache_entry( struct manifest_blob *blob, struct manifest_cache_entry *cache )
+{
+    DWORD magic = MANIFEST_BLOB_MAGIC;
+    unsigned int i, count;
+
+    if (!blob_value( blob, &magic ) || magic != MANIFEST_BLOB_MAGIC ||
+        !blob_string( blob, &cache->path ) ||
+        !blob_value( blob, &cache->write_time ) ||
+        !blob_value( blob, &cache->size ) ||
+        !blob_value( blob, &cache->version ) ||
+        !blob_assembly( blob, &cache->assembly ) ||
+        !blob_array( blob, (void **)&cache->deps, cache->num_deps, &cache->allocated_deps,
+                     sizeof(*cache->deps), &count ))
+        return FALSE;
+
+    for (i = 0; i < count; i++)
+    {
+        if (!blob->writing) cache->num_deps++;
+        if (!blob_assembly_identity( blob, &cache->deps[i] )) return FALSE;
+    }
+    return blob->pos == blob->size || blob->writing;
+}
+
+/* the file name is a hash of the path, the path itself is checked when reading */
+static BOOL get_manifest_blob_name( char *name, size_t len, const WCHAR *path,
+                                    const struct assembly_version *version )
+{
+    const char *dir;
+    unsigned int hash = 2166136261u;
+    int ret;
+
+    if (!(dir = wine_get_server_dir())) return FALSE;
+    ret = snprintf( name, len, "%s/manifests", dir );
+    if (ret < 0 || ret >= len) return FALSE;
+    if (mkdir( name, 0700 ) == -1 && errno != EEXIST) return FALSE;
+
+    for ( ; *path; path++) hash = (hash ^ toupperW( *path )) * 16777619;
+    ret = snprintf( name, len, "%s/manifests/%08x-%u.%u.%u.%u", dir, hash, version->major,
+                    version->minor, version->build, version->revision );
+    return ret >= 0 && ret < len;
+}
+
+/* read the manifest parsed by another process, if it hasn't changed since */
+static struct manifest_cache_entry *load_manifest_blob( const WCHAR *path, const struct assembly_identity *ai,
+                                                        const LARGE_INTEGER *write_time,
+                                                        const LARGE_INTEGER *size )
+{
+    char name[MANIFEST_BLOB_NAME_MAX];
+    struct manifest_cache_entry *cache;
+    struct manifest_blob blob;
+    struct stat st;
+    SIZE_T pos = 0;
+    int fd, ret;
+
+    if (!get_manifest_blob_name( name, sizeof(name), path, &ai->version )) return NULL;
+    if ((fd = open( name, O_RDONLY )) == -1) return NULL;
+    if (fstat( fd, &st ) == -1 || st.st_size > MANIFEST_BLOB_MAX_SIZE)
+    {
+        close( fd );
+        return NULL;
+    }
+    memset( &blob, 0, sizeof(blob) );
+    blob.size = st.st_size;
+    if (!(blob.data = RtlAllocateHeap( GetProcessHeap(), 0, max( blob.size, 1 ) )))
+    {
+        close( fd );
+        return NULL;
+    }
+    while (pos < blob.size)
+    {
+        if ((ret = read( fd, blob.data + pos, blob.size - pos )) <= 0) break;
+        pos += ret;
+    }
+    close( fd );
+
+    cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache) );
+    if (cache && (pos < blob.size || !blob_manifest_cache_entry( &blob, cache ) ||
+                  !cache->path || strcmpiW( cache->path, path ) ||
+                  cache->write_time.QuadPart != write_time->QuadPart ||
+                  cache->size.QuadPart != size->QuadPart ||
+                  memcmp( &cache->version, &ai->version, sizeof(cache->version) )))
+    {
+        free_manifest_cache_entry( cache );
+        cache = NULL;
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, blob.data );
+    if (cache) TRACE( "using manifest %s parsed by another process\n", debugstr_w(path) );
+    return cache;
+}
+
+/* save a parsed manifest for the other processes */
+static void save_manifest_blob( struct manifest_cache_entry *cache )
+{
+    char name[MANIFEST_BLOB_NAME_MAX], tmp[MANIFEST_BLOB_NAME_MAX];
+    struct manifest_blob blob;
+    SIZE_T pos = 0;
+    int fd, ret;
+
+    if (!get_manifest_blob_name( name, sizeof(name), cache->path, &cache->version )) return;
+    ret = snprintf( tmp, sizeof(tmp), "%s.%x", name, GetCurrentThreadId() );
+    if (ret < 0 || ret >= sizeof(tmp)) return;
+
+    memset( &blob, 0, sizeof(blob) );
+    blob.writing = TRUE;
+    if (blob_manifest_cache_entry( &blob, cache ) &&
+        (fd = open( tmp, O_WRONLY | O_CREAT | O_EXCL, 0600 )) != -1)
+    {
+        while (pos < blob.pos)
+        {
+            if ((ret = write( fd, blob.data + pos, blob.pos - pos )) <= 0) break;
+            pos += ret;
+        }
+        close( fd );
+        /* rename is atomic, readers see either the old or the new file */
+        if (pos < blob.pos || rename( tmp, name ) == -1) unlink( tmp );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, blob.data );
+}
+
+/* add the assembly parsed last to the cache */
+static void store_manifest_cache_entry( struct actctx_loader *acl, struct manifest_cache_entry *cache )
+{
+    if (cache->incomplete ||
+        !copy_assembly( &cache->assembly, &acl->actctx->assemblies[acl->actctx->num_assemblies - 1] ))
+    {
+        free_manifest_cache_entry( cache );
+        return;
+    }
+    save_manifest_blob( cache );
+    add_manifest_cache_entry( cache );
+}
+
+/* add a copy of a cached manifest to the activation context;
+ * returns STATUS_NOT_FOUND if the file has not been parsed yet or has changed */
+static NTSTATUS load_cached_manifest( struct actctx_loader *acl, const struct assembly_identity *ai,
+                                      const WCHAR *path, const LARGE_INTEGER *write_time,
+                                      const LARGE_INTEGER *size )
+{
+    struct manifest_cache_entry *cache;
+    struct assembly *assembly;
+    NTSTATUS status = STATUS_SUCCESS;
+    unsigned int i;
+
+    RtlEnterCriticalSection( &manifest_cache_section );
+    LIST_FOR_EACH_ENTRY( cache, &manifest_cache, struct manifest_cache_entry, entry )
+    {
+        if (strcmpiW( cache->path, path ) ||
+            memcmp( &cache->version, &ai->version, sizeof(cache->version) )) continue;
+        if (cache->write_time.QuadPart != write_time->QuadPart || cache->size.QuadPart != size->QuadPart)
+            break;
+
+        TRACE( "reusing parsed manifest %s\n", debugstr_w(path) );
+        list_remove( &cache->entry );
+        list_add_head( &manifest_cache, &cache->entry );
+
+        if (!(assembly = add_assembly( acl->actctx, cache->assembly.type )))
+            status = STATUS_NO_MEMORY;
+        else if (!copy_assembly( assembly, &cache->assembly ))
+            status = STATUS_NO_MEMORY;
+        else
+        {
+            acl->actctx->sections |= get_entity_sections( &assembly->entities );
+            if (assembly->num_dlls) acl->actctx->sections |= DLLREDIRECT_SECTION;
+            for (i = 0; i < assembly->num_dlls; i++)
+                acl->actctx->sections |= get_entity_sections( &assembly->dlls[i].entities );
+        }
+
+        for (i = 0; !status && i < cache->num_deps; i++)
+        {
+            struct assembly_identity dep;
+            unsigned int count = acl->num_dependencies;
+
+            if (!copy_assembly_identity( &dep, &cache->deps[i] )) status = STATUS_NO_MEMORY;
+            else if (!add_dependent_assembly_id( acl, &dep ))
+            {
+                free_assembly_identity( &dep );
+                status = STATUS_NO_MEMORY;
+            }
+            else if (acl->num_dependencies == count) free_assembly_identity( &dep );
+        }
+        RtlLeaveCriticalSection( &manifest_cache_section );
+        return status;
+    }
+    RtlLeaveCriticalSection( &manifest_cache_section );
+    return STATUS_NOT_FOUND;
+}
+
 static WCHAR *build_assembly_dir(struct assembly_identity* ai)
 {
     static const WCHAR undW[] = {'_',0};
@@ -1058,24 +1783,10 @@ static void actctx_release( ACTIVATION_CONTEXT *actctx )
 {
     if (interlocked_xchg_add( &actctx->ref_count, -1 ) == 1)
     {
-        unsigned int i, j;
+        unsigned int i;
 
         for (i = 0; i < actctx->num_assemblies; i++)
-        {
-            struct assembly *assembly = &actctx->assemblies[i];
-            for (j = 0; j < assembly->num_dlls; j++)
-            {
-                struct dll_redirect *dll = &assembly->dlls[j];
-                free_entity_array( &dll->entities );
-                RtlFreeHeap( GetProcessHeap(), 0, dll->name );
-                RtlFreeHeap( GetProcessHeap(), 0, dll->hash );
-            }
-            RtlFreeHeap( GetProcessHeap(), 0, assembly->dlls );
-            RtlFreeHeap( GetProcessHeap(), 0, assembly->manifest.info );
-            RtlFreeHeap( GetProcessHeap(), 0, assembly->directory );
-            free_entity_array( &assembly->entities );
-            free_assembly_identity(&assembly->id);
-        }
+            free_assembly( &actctx->assemblies[i] );
         RtlFreeHeap( GetProcessHeap(), 0, actctx->config.info );
         RtlFreeHeap( GetProcessHeap(), 0, actctx->appdir.info );
         RtlFreeHeap( GetProcessHeap(), 0, actctx->assemblies );
@@ -1086,6 +1797,13 @@ static void actctx_release( ACTIVATION_CONTEXT *actctx )
         RtlFreeHeap( GetProcessHeap(), 0, actctx->ifaceps_section );
         RtlFreeHeap( GetProcessHeap(), 0, actctx->clrsurrogate_section );
         RtlFreeHeap( GetProcessHeap(), 0, actctx->progid_section );
+        RtlFreeHeap( GetProcessHeap(), 0, actctx->wndclass_lookup );
+        RtlFreeHeap( GetProcessHeap(), 0, actctx->dllredirect_lookup );
+        RtlFreeHeap( GetProcessHeap(), 0, actctx->progid_lookup );
+        RtlFreeHeap( GetProcessHeap(), 0, actctx->tlib_lookup );
+        RtlFreeHeap( GetProcessHeap(), 0, actctx->comserver_lookup );
+        RtlFreeHeap( GetProcessHeap(), 0, actctx->ifaceps_lookup );
+        RtlFreeHeap( GetProcessHeap(), 0, actctx->clrsurrogate_lookup );
         actctx->magic = 0;
         RtlFreeHeap( GetProcessHeap(), 0, actctx );
     }
@@ -2035,6 +2753,8 @@ static BOOL parse_dependent_assembly_elem(xmlbuf_t* xmlbuf, struct actctx_loader
     TRACE( "adding name=%s version=%s arch=%s\n",
            debugstr_w(ai.name), debugstr_version(&ai.version), debugstr_w(ai.arch) );
 
+    record_dependency(acl, &ai);
+
     /* store the newly found identity for later loading */
     if (!add_dependent_assembly_id(acl, &ai)) return FALSE;
 
@@ -2559,7 +3279,9 @@ static NTSTATUS get_manifest_in_manifest_file( struct actctx_loader* acl, struct
                                                LPCWSTR filename, LPCWSTR directory, BOOL shared, HANDLE file )
 {
     FILE_END_OF_FILE_INFORMATION info;
+    FILE_BASIC_INFORMATION basic;
     IO_STATUS_BLOCK io;
+    struct manifest_cache_entry *cache = NULL;
     HANDLE              mapping;
     OBJECT_ATTRIBUTES   attr;
     LARGE_INTEGER       size;
@@ -2570,6 +3292,23 @@ static NTSTATUS get_manifest_in_manifest_file( struct actctx_loader* acl, struct
 
     TRACE( "loading manifest file %s\n", debugstr_w(filename) );
 
+    status = NtQueryInformationFile( file, &io, &info, sizeof(info), FileEndOfFileInformation );
+    if (status != STATUS_SUCCESS) return status;
+
+    /* shared assemblies are looked up again by most activation contexts */
+    if (shared && !NtQueryInformationFile( file, &io, &basic, sizeof(basic), FileBasicInformation ))
+    {
+        status = load_cached_manifest( acl, ai, filename, &basic.LastWriteTime, &info.EndOfFile );
+        if (status == STATUS_NOT_FOUND &&
+            (cache = load_manifest_blob( filename, ai, &basic.LastWriteTime, &info.EndOfFile )))
+        {
+            add_manifest_cache_entry( cache );
+            status = load_cached_manifest( acl, ai, filename, &basic.LastWriteTime, &info.EndOfFile );
+        }
+        if (status != STATUS_NOT_FOUND) return status;
+        cache = alloc_manifest_cache_entry( filename, ai, &basic.LastWriteTime, &info.EndOfFile );
+    }
+
     attr.Length                   = sizeof(attr);
     attr.RootDirectory            = 0;
     attr.ObjectName               = NULL;
@@ -2580,19 +3319,30 @@ static NTSTATUS get_manifest_in_manifest_file( struct actctx_loader* acl, struct
     size.QuadPart = 0;
     status = NtCreateSection( &mapping, STANDARD_RIGHTS_REQUIRED | SECTION_QUERY | SECTION_MAP_READ,
                               &attr, &size, PAGE_READONLY, SEC_COMMIT, file );
-    if (status != STATUS_SUCCESS) return status;
+    if (status == STATUS_SUCCESS)
+    {
+        offset.QuadPart = 0;
+        count = 0;
+        base = NULL;
+        status = NtMapViewOfSection( mapping, GetCurrentProcess(), &base, 0, 0, &offset,
+                                     &count, ViewShare, 0, PAGE_READONLY );
+        NtClose( mapping );
+    }
+    if (status != STATUS_SUCCESS)
+    {
+        if (cache) free_manifest_cache_entry( cache );
+        return status;
+    }
 
-    offset.QuadPart = 0;
-    count = 0;
-    base = NULL;
-    status = NtMapViewOfSection( mapping, GetCurrentProcess(), &base, 0, 0, &offset,
-                                 &count, ViewShare, 0, PAGE_READONLY );
-    NtClose( mapping );
-    if (status != STATUS_SUCCESS) return status;
+    acl->cache_entry = cache;
+    status = parse_manifest(acl, ai, filename, directory, shared, base, info.EndOfFile.QuadPart);
+    acl->cache_entry = NULL;
 
-    status = NtQueryInformationFile( file, &io, &info, sizeof(info), FileEndOfFileInformation );
-    if (status == STATUS_SUCCESS)
-        status = parse_manifest(acl, ai, filename, directory, shared, base, info.EndOfFile.QuadPart);
+    if (cache)
+    {
+        if (status == STATUS_SUCCESS) store_manifest_cache_entry( acl, cache );
+        else free_manifest_cache_entry( cache );
+    }
 
     NtUnmapViewOfSection( GetCurrentProcess(), base );
     return status;
@@ -3037,52 +3787,127 @@ static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct str
     return STATUS_SUCCESS;
 }
 
-static struct string_index *find_string_index(const struct strsection_header *section, const UNICODE_STRING *name)
+static int string_lookup_cmp( const void *a, const void *b )
 {
-    struct string_index *iter, *index = NULL;
-    ULONG hash = 0, i;
+    const struct string_lookup_entry *e1 = a, *e2 = b;
 
-    RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
-    iter = (struct string_index*)((BYTE*)section + section->index_offset);
+    if (e1->hash != e2->hash) return e1->hash < e2->hash ? -1 : 1;
+    if (e1->pos != e2->pos) return e1->pos < e2->pos ? -1 : 1;
+    return 0;
+}
 
+static int guid_lookup_cmp( const void *a, const void *b )
+{
+    const struct guid_lookup_entry *e1 = a, *e2 = b;
+    int ret = memcmp( &e1->guid, &e2->guid, sizeof(GUID) );
+
+    if (ret) return ret;
+    if (e1->pos != e2->pos) return e1->pos < e2->pos ? -1 : 1;
+    return 0;
+}
+
+/* sort the index of a string section by hash, keeping the section order for equal hashes */
+static struct string_lookup *get_string_lookup(const struct strsection_header *section, struct string_lookup **lookup)
+{
+    const struct string_index *index = (const struct string_index *)((const BYTE *)section + section->index_offset);
+    struct string_lookup *ret;
+    ULONG i;
+
+    if (*lookup) return *lookup;
+
+    ret = RtlAllocateHeap(GetProcessHeap(), 0, FIELD_OFFSET(struct string_lookup, entries[section->count]));
+    if (!ret) return NULL;
+    ret->count = section->count;
     for (i = 0; i < section->count; i++)
     {
-        if (iter->hash == hash)
-        {
-            const WCHAR *nameW = (WCHAR*)((BYTE*)section + iter->name_offset);
-
-            if (!strcmpiW(nameW, name->Buffer))
-            {
-                index = iter;
-                break;
-            }
-            else
-                WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_w(nameW));
-        }
-        iter++;
+        ret->entries[i].hash = index[i].hash;
+        ret->entries[i].pos = i;
     }
+    qsort(ret->entries, ret->count, sizeof(ret->entries[0]), string_lookup_cmp);
 
-    return index;
+    if (interlocked_cmpxchg_ptr((void **)lookup, ret, NULL))
+        RtlFreeHeap(GetProcessHeap(), 0, ret);
+    return *lookup;
 }
 
-static struct guid_index *find_guid_index(const struct guidsection_header *section, const GUID *guid)
+static struct guid_lookup *get_guid_lookup(const struct guidsection_header *section, struct guid_lookup **lookup)
 {
-    struct guid_index *iter, *index = NULL;
+    const struct guid_index *index = (const struct guid_index *)((const BYTE *)section + section->index_offset);
+    struct guid_lookup *ret;
     ULONG i;
 
-    iter = (struct guid_index*)((BYTE*)section + section->index_offset);
+    if (*lookup) return *lookup;
 
+    ret = RtlAllocateHeap(GetProcessHeap(), 0, FIELD_OFFSET(struct guid_lookup, entries[section->count]));
+    if (!ret) return NULL;
+    ret->count = section->count;
     for (i = 0; i < section->count; i++)
     {
-        if (!memcmp(guid, &iter->guid, sizeof(*guid)))
-        {
-            index = iter;
-            break;
-        }
-        iter++;
+        ret->entries[i].guid = index[i].guid;
+        ret->entries[i].pos = i;
+    }
+    qsort(ret->entries, ret->count, sizeof(ret->entries[0]), guid_lookup_cmp);
+
+    if (interlocked_cmpxchg_ptr((void **)lookup, ret, NULL))
+        RtlFreeHeap(GetProcessHeap(), 0, ret);
+    return *lookup;
+}
+
+/* find the first entry of the section index matching a name, using the sorted lookup table */
+static struct string_index *find_string_index(const struct strsection_header *section, struct string_lookup **lookup,
+                                              const UNICODE_STRING *name, BOOL case_insensitive)
+{
+    struct string_index *index = (struct string_index*)((BYTE*)section + section->index_offset);
+    const struct string_lookup *table;
+    ULONG hash = 0, min, max;
+
+    if (!(table = get_string_lookup(section, lookup))) return NULL;
+
+    RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
+
+    min = 0;
+    max = table->count;
+    while (min < max)
+    {
+        ULONG pos = (min + max) / 2;
+        if (table->entries[pos].hash < hash) min = pos + 1;
+        else max = pos;
+    }
+
+    for (; min < table->count && table->entries[min].hash == hash; min++)
+    {
+        struct string_index *iter = &index[table->entries[min].pos];
+        const WCHAR *nameW = (WCHAR*)((BYTE*)section + iter->name_offset);
+
+        if (case_insensitive ? !strcmpiW(nameW, name->Buffer) : !strcmpW(nameW, name->Buffer))
+            return iter;
+        WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_w(nameW));
     }
 
-    return index;
+    return NULL;
+}
+
+static struct guid_index *find_guid_index(const struct guidsection_header *section, struct guid_lookup **lookup,
+                                          const GUID *guid)
+{
+    struct guid_index *index = (struct guid_index*)((BYTE*)section + section->index_offset);
+    const struct guid_lookup *table;
+    ULONG min, max;
+
+    if (!(table = get_guid_lookup(section, lookup))) return NULL;
+
+    min = 0;
+    max = table->count;
+    while (min < max)
+    {
+        ULONG pos = (min + max) / 2;
+        if (memcmp(&table->entries[pos].guid, guid, sizeof(*guid)) < 0) min = pos + 1;
+        else max = pos;
+    }
+
+    if (min < table->count && !memcmp(&table->entries[min].guid, guid, sizeof(*guid)))
+        return &index[table->entries[min].pos];
+    return NULL;
 }
 
 static inline struct dllredirect_data *get_dllredirect_data(ACTIVATION_CONTEXT *ctxt, struct string_index *index)
@@ -3109,7 +3934,7 @@ static NTSTATUS find_dll_redirection(ACTIVATION_CONTEXT* actctx, const UNICODE_S
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    index = find_string_index(actctx->dllredirect_section, name);
+    index = find_string_index(actctx->dllredirect_section, &actctx->dllredirect_lookup, name, TRUE);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     dll = get_dllredirect_data(actctx, index);
@@ -3129,11 +3954,6 @@ static NTSTATUS find_dll_redirection(ACTIVATION_CONTEXT* actctx, const UNICODE_S
     return STATUS_SUCCESS;
 }
 
-static inline struct string_index *get_wndclass_first_index(ACTIVATION_CONTEXT *actctx)
-{
-    return (struct string_index*)((BYTE*)actctx->wndclass_section + actctx->wndclass_section->index_offset);
-}
-
 static inline struct wndclass_redirect_data *get_wndclass_data(ACTIVATION_CONTEXT *ctxt, struct string_index *index)
 {
     return (struct wndclass_redirect_data*)((BYTE*)ctxt->wndclass_section + index->data_offset);
@@ -3280,10 +4100,8 @@ static NTSTATUS build_wndclass_section(ACTIVATION_CONTEXT* actctx, struct strsec
 static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRING *name,
                                   PACTCTX_SECTION_KEYED_DATA data)
 {
-    struct string_index *iter, *index = NULL;
+    struct string_index *index;
     struct wndclass_redirect_data *class;
-    ULONG hash;
-    int i;
 
     if (!(actctx->sections & WINDOWCLASS_SECTION)) return STATUS_SXS_KEY_NOT_FOUND;
 
@@ -3298,27 +4116,7 @@ static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRI
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    hash = 0;
-    RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
-    iter = get_wndclass_first_index(actctx);
-
-    for (i = 0; i < actctx->wndclass_section->count; i++)
-    {
-        if (iter->hash == hash)
-        {
-            const WCHAR *nameW = (WCHAR*)((BYTE*)actctx->wndclass_section + iter->name_offset);
-
-            if (!strcmpW(nameW, name->Buffer))
-            {
-                index = iter;
-                break;
-            }
-            else
-                WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_w(nameW));
-        }
-        iter++;
-    }
-
+    index = find_string_index(actctx->wndclass_section, &actctx->wndclass_lookup, name, FALSE);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     class = get_wndclass_data(actctx, index);
@@ -3486,7 +4284,7 @@ static NTSTATUS find_tlib_redirection(ACTIVATION_CONTEXT* actctx, const GUID *gu
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    index = find_guid_index(actctx->tlib_section, guid);
+    index = find_guid_index(actctx->tlib_section, &actctx->tlib_lookup, guid);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     tlib = get_tlib_data(actctx, index);
@@ -3821,7 +4619,7 @@ static NTSTATUS find_comserver_redirection(ACTIVATION_CONTEXT* actctx, const GUI
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    index = find_guid_index(actctx->comserver_section, guid);
+    index = find_guid_index(actctx->comserver_section, &actctx->comserver_lookup, guid);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     comclass = get_comclass_data(actctx, index);
@@ -4011,7 +4809,7 @@ static NTSTATUS find_cominterface_redirection(ACTIVATION_CONTEXT* actctx, const
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    index = find_guid_index(actctx->ifaceps_section, guid);
+    index = find_guid_index(actctx->ifaceps_section, &actctx->ifaceps_lookup, guid);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     iface = get_ifaceps_data(actctx, index);
@@ -4159,7 +4957,7 @@ static NTSTATUS find_clr_surrogate(ACTIVATION_CONTEXT* actctx, const GUID *guid,
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    index = find_guid_index(actctx->clrsurrogate_section, guid);
+    index = find_guid_index(actctx->clrsurrogate_section, &actctx->clrsurrogate_lookup, guid);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     surrogate = get_surrogate_data(actctx, index);
@@ -4270,7 +5068,7 @@ static void add_progid_record(ACTIVATION_CONTEXT* actctx, struct strsection_head
             RtlInitUnicodeString(&str, entity->u.comclass.clsid);
             RtlGUIDFromString(&str, &clsid);
 
-            guid_index = find_guid_index(actctx->comserver_section, &clsid);
+            guid_index = find_guid_index(actctx->comserver_section, &actctx->comserver_lookup, &clsid);
             comclass = get_comclass_data(actctx, guid_index);
 
             if (entity->u.comclass.progid)
@@ -4373,7 +5171,7 @@ static NTSTATUS find_progid_redirection(ACTIVATION_CONTEXT* actctx, const UNICOD
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    index = find_string_index(actctx->progid_section, name);
+    index = find_string_index(actctx->progid_section, &actctx->progid_lookup, name, TRUE);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     progid = get_progid_data(actctx, index);
@@ -540,6 +540,43 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
 }
 
 
+/*************************************************************************
+ *		is_import_bound
+ *
+ * Check if the import address table for a given dll was bound at link
+ * time (or by BindImage) against the module that got loaded, in which case
+ * it already holds the right addresses.
+ */
+static BOOL is_import_bound( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, const WINE_MODREF *wm_imp )
+{
+    const IMAGE_NT_HEADERS *imp_nt = RtlImageNtHeader( wm_imp->ldr.BaseAddress );
+    DWORD timestamp = descr->TimeDateStamp;
+
+    if (!timestamp || !descr->u.OriginalFirstThunk) return FALSE;
+    /* relay and snoop patch the export table, the bound addresses would bypass them */
+    if (TRACE_ON(relay) || TRACE_ON(snoop)) return FALSE;
+    if ((ULONG_PTR)wm_imp->ldr.BaseAddress != imp_nt->OptionalHeader.ImageBase) return FALSE;
+
+    if (timestamp == ~0u)  /* new style binding, look for the timestamp in the bound import directory */
+    {
+        const IMAGE_BOUND_IMPORT_DESCRIPTOR *bound, *first;
+        const char *name = get_rva( module, descr->Name );
+        DWORD size;
+
+        if (!(first = RtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT, &size )))
+            return FALSE;
+        for (bound = first; bound->OffsetModuleName; bound += 1 + bound->NumberOfModuleForwarderRefs)
+            if (!strcasecmp( (const char *)first + bound->OffsetModuleName, name )) break;
+        /* forwarded functions point into other modules, don't bother checking them */
+        if (!bound->OffsetModuleName || bound->NumberOfModuleForwarderRefs) return FALSE;
+        timestamp = bound->TimeDateStamp;
+    }
+    else if (descr->ForwarderChain != ~0u) return FALSE;
+
+    return timestamp == imp_nt->FileHeader.TimeDateStamp;
+}
+
+
 /*************************************************************************
  *		import_dll
  *
@@ -597,6 +634,12 @@ static WINE_MODREF *import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *d
         return NULL;
     }
 
+    if (is_import_bound( module, descr, wmImp ))
+    {
+        TRACE_(imports)( "using bound imports from %s\n", name );
+        return wmImp;
+    }
+
     /* unprotect the import address table since it can be located in
      * readonly section */
     while (import_list[protect_size].u1.Ordinal) protect_size++;
@@ -2509,6 +2552,8 @@ void WINAPI LdrShutdownProcess(void)
     TRACE("()\n");
     process_detaching = TRUE;
     process_detach();
+    RELAY_ProcessDetach();
+    reg_cache_process_detach();
 }
 
 
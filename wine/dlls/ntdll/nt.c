@@ -1691,123 +1691,100 @@ NTSTATUS WINAPI NtQuerySystemInformation(
         {
             SYSTEM_PROCESS_INFORMATION* spi = SystemInformation;
             SYSTEM_PROCESS_INFORMATION* last = NULL;
-            HANDLE hSnap = 0;
-            WCHAR procname[1024];
-            WCHAR* exename;
+            struct process_info *info;
+            struct thread_info *thread_info;
+            data_size_t buffer_size = 0x4000, pos = 0;
+            char *buffer = NULL;
+            const WCHAR *name, *exename;
             DWORD wlen = 0;
             DWORD procstructlen = 0;
+            int process_count = 0, i, j;
 
-            SERVER_START_REQ( create_snapshot )
+            /* fetch all the processes and threads at once, the server
+             * tells us how much room it needs if the buffer is too small */
+            do
             {
-                req->flags      = SNAP_PROCESS | SNAP_THREAD;
-                req->attributes = 0;
-                if (!(ret = wine_server_call( req )))
-                    hSnap = wine_server_ptr_handle( reply->handle );
-            }
-            SERVER_END_REQ;
-            len = 0;
-            while (ret == STATUS_SUCCESS)
-            {
-                SERVER_START_REQ( next_process )
+                RtlFreeHeap( GetProcessHeap(), 0, buffer );
+                if (!(buffer = RtlAllocateHeap( GetProcessHeap(), 0, buffer_size )))
                 {
-                    req->handle = wine_server_obj_handle( hSnap );
-                    req->reset = (len == 0);
-                    wine_server_set_reply( req, procname, sizeof(procname)-sizeof(WCHAR) );
-                    if (!(ret = wine_server_call( req )))
-                    {
-                        /* Make sure procname is 0 terminated */
-                        procname[wine_server_reply_size(reply) / sizeof(WCHAR)] = 0;
-
-                        /* Get only the executable name, not the path */
-                        if ((exename = strrchrW(procname, '\\')) != NULL) exename++;
-                        else exename = procname;
-
-                        wlen = (strlenW(exename) + 1) * sizeof(WCHAR);
-
-                        procstructlen = sizeof(*spi) + wlen + ((reply->threads - 1) * sizeof(SYSTEM_THREAD_INFORMATION));
-
-                        if (Length >= len + procstructlen)
-                        {
-                            /* ftCreationTime, ftUserTime, ftKernelTime;
-                             * vmCounters, ioCounters
-                             */
- 
-                            memset(spi, 0, sizeof(*spi));
+                    ret = STATUS_NO_MEMORY;
+                    break;
+                }
+                SERVER_START_REQ( list_processes )
+                {
+                    wine_server_set_reply( req, buffer, buffer_size );
+                    ret = wine_server_call( req );
+                    buffer_size = reply->info_size;
+                    process_count = reply->process_count;
+                }
+                SERVER_END_REQ;
+            } while (ret == STATUS_INFO_LENGTH_MISMATCH);
 
-                            spi->NextEntryOffset = procstructlen - wlen;
-                            spi->dwThreadCount = reply->threads;
+            len = 0;
+            for (i = 0; ret == STATUS_SUCCESS && i < process_count; i++)
+            {
+                info = (struct process_info *)(buffer + pos);
+                name = (const WCHAR *)(info + 1);
+                pos = (pos + sizeof(*info) + info->name_len + 7) & ~7;
+                thread_info = (struct thread_info *)(buffer + pos);
+                pos += info->thread_count * sizeof(*thread_info);
 
-                            /* spi->pszProcessName will be set later on */
+                /* Get only the executable name, not the path */
+                exename = name + info->name_len / sizeof(WCHAR);
+                while (exename > name && exename[-1] != '\\') exename--;
 
-                            spi->dwBasePriority = reply->priority;
-                            spi->UniqueProcessId = UlongToHandle(reply->pid);
-                            spi->ParentProcessId = UlongToHandle(reply->ppid);
-                            spi->HandleCount = reply->handles;
+                wlen = (name + info->name_len / sizeof(WCHAR) - exename + 1) * sizeof(WCHAR);
 
-                            /* spi->ti will be set later on */
+                procstructlen = sizeof(*spi) + wlen + ((info->thread_count - 1) * sizeof(SYSTEM_THREAD_INFORMATION));
 
-                        }
-                        len += procstructlen;
-                    }
-                }
-                SERVER_END_REQ;
- 
-                if (ret != STATUS_SUCCESS)
+                if (Length >= len + procstructlen)
                 {
-                    if (ret == STATUS_NO_MORE_FILES) ret = STATUS_SUCCESS;
-                    break;
-                }
+                    /* ftUserTime, ftKernelTime;
+                     * vmCounters, ioCounters
+                     */
 
-                if (Length >= len)
-                {
-                    int     i, j;
+                    memset(spi, 0, sizeof(*spi));
+
+                    spi->NextEntryOffset = procstructlen - wlen;
+                    spi->dwThreadCount = info->thread_count;
+                    spi->CreationTime.QuadPart = info->start_time;
+                    spi->dwBasePriority = info->priority;
+                    spi->UniqueProcessId = UlongToHandle(info->pid);
+                    spi->ParentProcessId = UlongToHandle(info->parent_pid);
+                    spi->HandleCount = info->handle_count;
 
                     /* set thread info */
-                    i = j = 0;
-                    while (ret == STATUS_SUCCESS)
+                    for (j = 0; j < info->thread_count; j++)
                     {
-                        SERVER_START_REQ( next_thread )
-                        {
-                            req->handle = wine_server_obj_handle( hSnap );
-                            req->reset = (j == 0);
-                            if (!(ret = wine_server_call( req )))
-                            {
-                                j++;
-                                if (UlongToHandle(reply->pid) == spi->UniqueProcessId)
-                                {
-                                    /* ftKernelTime, ftUserTime, ftCreateTime;
-                                     * dwTickCount, dwStartAddress
-                                     */
-
-                                    memset(&spi->ti[i], 0, sizeof(spi->ti));
-
-                                    spi->ti[i].CreateTime.QuadPart = 0xdeadbeef;
-                                    spi->ti[i].ClientId.UniqueProcess = UlongToHandle(reply->pid);
-                                    spi->ti[i].ClientId.UniqueThread  = UlongToHandle(reply->tid);
-                                    spi->ti[i].dwCurrentPriority = reply->base_pri + reply->delta_pri;
-                                    spi->ti[i].dwBasePriority = reply->base_pri;
-                                    i++;
-                                }
-                            }
-                        }
-                        SERVER_END_REQ;
+                        /* ftKernelTime, ftUserTime;
+                         * dwTickCount, dwStartAddress
+                         */
+
+                        memset(&spi->ti[j], 0, sizeof(spi->ti[j]));
+
+                        spi->ti[j].CreateTime.QuadPart = thread_info[j].start_time;
+                        spi->ti[j].ClientId.UniqueProcess = UlongToHandle(info->pid);
+                        spi->ti[j].ClientId.UniqueThread  = UlongToHandle(thread_info[j].tid);
+                        spi->ti[j].dwCurrentPriority = thread_info[j].current_priority;
+                        spi->ti[j].dwBasePriority = thread_info[j].base_priority;
                     }
-                    if (ret == STATUS_NO_MORE_FILES) ret = STATUS_SUCCESS;
 
                     /* now append process name */
                     spi->ProcessName.Buffer = (WCHAR*)((char*)spi + spi->NextEntryOffset);
                     spi->ProcessName.Length = wlen - sizeof(WCHAR);
                     spi->ProcessName.MaximumLength = wlen;
-                    memcpy( spi->ProcessName.Buffer, exename, wlen );
+                    memcpy( spi->ProcessName.Buffer, exename, wlen - sizeof(WCHAR) );
+                    spi->ProcessName.Buffer[wlen / sizeof(WCHAR) - 1] = 0;
                     spi->NextEntryOffset += wlen;
 
                     last = spi;
                     spi = (SYSTEM_PROCESS_INFORMATION*)((char*)spi + spi->NextEntryOffset);
                 }
+                len += procstructlen;
             }
             if (ret == STATUS_SUCCESS && last) last->NextEntryOffset = 0;
             if (len > Length) ret = STATUS_INFO_LENGTH_MISMATCH;
-            if (hSnap) NtClose(hSnap);
+            RtlFreeHeap( GetProcessHeap(), 0, buffer );
         }
         break;
     case SystemProcessorPerformanceInformation:
@@ -97,6 +97,10 @@ extern int server_get_unix_fd( HANDLE handle, unsigned int access, int *unix_fd,
                                int *needs_close, enum server_fd_type *type, unsigned int *options ) DECLSPEC_HIDDEN;
 extern int server_pipe( int fd[2] ) DECLSPEC_HIDDEN;
 
+/* registry */
+extern void reg_cache_remove_handle( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void reg_cache_process_detach(void) DECLSPEC_HIDDEN;
+
 /* security descriptors */
 NTSTATUS NTDLL_create_struct_sd(PSECURITY_DESCRIPTOR nt_sd, struct security_descriptor **server_sd,
                                 data_size_t *server_sd_len) DECLSPEC_HIDDEN;
@@ -110,6 +114,8 @@ extern FARPROC RELAY_GetProcAddress( HMODULE module, const IMAGE_EXPORT_DIRECTOR
 extern FARPROC SNOOP_GetProcAddress( HMODULE hmod, const IMAGE_EXPORT_DIRECTORY *exports, DWORD exp_size,
                                      FARPROC origfun, DWORD ordinal, const WCHAR *user ) DECLSPEC_HIDDEN;
 extern void RELAY_SetupDLL( HMODULE hmod ) DECLSPEC_HIDDEN;
+extern void RELAY_ThreadDetach(void) DECLSPEC_HIDDEN;
+extern void RELAY_ProcessDetach(void) DECLSPEC_HIDDEN;
 extern void SNOOP_SetupDLL( HMODULE hmod ) DECLSPEC_HIDDEN;
 extern UNICODE_STRING system_dir DECLSPEC_HIDDEN;
 
@@ -207,6 +213,7 @@ struct debug_info
     char *out_pos;       /* current position in output buffer */
     char  strings[1024]; /* buffer for temporary strings */
     char  output[1024];  /* current output line */
+    struct relay_log *relay_log; /* binary relay log buffer */
 };
 
 /* thread private data, stored in NtCurrentTeb()->SystemReserved2 */
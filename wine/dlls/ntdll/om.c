@@ -332,10 +332,13 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source,
         if (!(ret = wine_server_call( req )))
         {
             if (dest) *dest = wine_server_ptr_handle( reply->handle );
+            /* the new handle may reuse the value of a key handle closed by another process */
+            if (dest && dest_process == NtCurrentProcess()) reg_cache_remove_handle( *dest );
             if (reply->closed && reply->self)
             {
                 int fd = server_remove_fd_from_cache( source );
                 if (fd != -1) close( fd );
+                reg_cache_remove_handle( source );
             }
         }
     }
@@ -349,6 +352,7 @@ NTSTATUS close_handle( HANDLE handle )
     NTSTATUS ret;
     int fd = server_remove_fd_from_cache( handle );
 
+    reg_cache_remove_handle( handle );
     SERVER_START_REQ( close_handle )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -29,24 +29,237 @@
 #include "config.h"
 #include "wine/port.h"
 
+#include <fcntl.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
 #include "wine/library.h"
 #include "ntdll_misc.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(reg);
+WINE_DECLARE_DEBUG_CHANNEL(regcache);
 
 /* maximum length of a key name in bytes (without terminating null) */
 #define MAX_NAME_LENGTH  (255 * sizeof(WCHAR))
 /* maximum length of a value name in bytes (without terminating null) */
 #define MAX_VALUE_LENGTH (16383 * sizeof(WCHAR))
 
+/*
+ * Value queries are cached per key id, which the server returns when a key
+ * is opened with KEY_QUERY_VALUE access, so that the cache is shared by all
+ * the handles of a key and survives open/query/close sequences.  Entries
+ * are validated against the key generations that the unified kernel module
+ * bumps on each modification and publishes in a read-only mapping of
+ * /dev/syscall; the cache is disabled when that mapping isn't available or
+ * when WINE_REGCACHE is set to 0.  WINEDEBUG=+regcache prints the cache
+ * statistics when the process exits.
+ */
+
+#define REG_CACHE_HASH_SIZE  256               /* buckets of the handle and value tables */
+#define REG_CACHE_MAX_VALUES 1024              /* maximum number of cached values */
+#define REG_CACHE_MAX_BYTES  (256 * 1024)      /* maximum size of the cached names and data */
+#define REG_CACHE_MAX_DATA   4096              /* larger values aren't cached */
+#define REG_CACHE_MAX_NAME   (255 * sizeof(WCHAR))  /* longer value names aren't cached */
+
+struct reg_cache_handle
+{
+    struct list    entry;       /* entry in handle hash table */
+    HANDLE         handle;
+    unsigned int   key_id;      /* id of the key opened by the handle */
+};
+
+struct reg_cache_value
+{
+    struct list    entry;       /* entry in value hash table */
+    struct list    lru;         /* entry in LRU list, most recently used first */
+    unsigned int   key_id;
+    unsigned int   generation;  /* key generation when the value was read */
+    unsigned int   global;      /* global registry generation when the value was read */
+    NTSTATUS       status;      /* STATUS_SUCCESS or STATUS_OBJECT_NAME_NOT_FOUND */
+    ULONG          type;
+    DWORD          data_len;
+    USHORT         name_len;    /* in bytes */
+    WCHAR         *name;
+    BYTE          *data;        /* follows the name */
+};
+
+static const volatile unsigned int *reg_generations;  /* NULL if the cache is disabled */
+static struct list reg_cache_handles[REG_CACHE_HASH_SIZE];
+static struct list reg_cache_values[REG_CACHE_HASH_SIZE];
+static struct list reg_cache_lru = LIST_INIT( reg_cache_lru );
+static unsigned int reg_cache_count;
+static unsigned int reg_cache_bytes;
+static RTL_RUN_ONCE reg_cache_once = RTL_RUN_ONCE_INIT;
+
+static struct
+{
+    unsigned int hits;           /* values returned from the cache */
+    unsigned int negative_hits;  /* missing values returned from the cache */
+    unsigned int misses;         /* queries sent to the server */
+    unsigned int stale;          /* entries dropped because the key changed */
+    unsigned int evictions;      /* entries dropped because the cache was full */
+} reg_cache_stats;
+
+static RTL_CRITICAL_SECTION reg_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
+{
+    0, 0, &reg_cache_section,
+    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": reg_cache_section") }
+};
+static RTL_CRITICAL_SECTION reg_cache_section = { &critsect_debug, -1, 0, 0, 0, 0 };
+
+static DWORD CALLBACK init_reg_cache( RTL_RUN_ONCE *once, void *param, void **context )
+{
+#if defined(CONFIG_UNIFIED_KERNEL) && defined(HAVE_SYS_MMAN_H)
+    const char *env = getenv( "WINE_REGCACHE" );
+    unsigned int i;
+    void *ptr;
+    int fd;
+
+    if (env && !atoi( env )) return TRUE;
+
+    for (i = 0; i < REG_CACHE_HASH_SIZE; i++)
+    {
+        list_init( &reg_cache_handles[i] );
+        list_init( &reg_cache_values[i] );
+    }
+    if ((fd = open( SYSCALL_FILE, O_RDONLY )) == -1) return TRUE;
+    ptr = mmap( NULL, REG_GENERATION_SLOTS * sizeof(*reg_generations), PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+    if (ptr != MAP_FAILED) reg_generations = ptr;
+    else WARN_(regcache)( "cannot map the registry generations, cache disabled\n" );
+#endif
+    return TRUE;
+}
+
+static inline unsigned int handle_hash( HANDLE handle )
+{
+    return (HandleToULong( handle ) >> 2) % REG_CACHE_HASH_SIZE;
+}
+
+static unsigned int value_hash( unsigned int key_id, const UNICODE_STRING *name )
+{
+    unsigned int i, hash = key_id;
+
+    for (i = 0; i < name->Length / sizeof(WCHAR); i++) hash = hash * 31 + toupperW( name->Buffer[i] );
+    return hash % REG_CACHE_HASH_SIZE;
+}
+
+/* caller must hold reg_cache_section */
+static struct reg_cache_handle *find_cached_handle( HANDLE handle )
+{
+    struct reg_cache_handle *entry;
+
+    LIST_FOR_EACH_ENTRY( entry, &reg_cache_handles[handle_hash( handle )], struct reg_cache_handle, entry )
+        if (entry->handle == handle) return entry;
+    return NULL;
+}
+
+/* remember the key opened by a handle returned from the server */
+static void reg_cache_set_handle( HANDLE handle, unsigned int key_id )
+{
+    struct reg_cache_handle *entry;
+
+    RtlRunOnceExecuteOnce( &reg_cache_once, init_reg_cache, NULL, NULL );
+    if (!reg_generations) return;
+
+    RtlEnterCriticalSection( &reg_cache_section );
+    if ((entry = find_cached_handle( handle )))
+    {
+        if (key_id) entry->key_id = key_id;
+        else
+        {
+            list_remove( &entry->entry );
+            RtlFreeHeap( GetProcessHeap(), 0, entry );
+        }
+    }
+    else if (key_id && (entry = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*entry) )))
+    {
+        entry->handle = handle;
+        entry->key_id = key_id;
+        list_add_head( &reg_cache_handles[handle_hash( handle )], &entry->entry );
+    }
+    RtlLeaveCriticalSection( &reg_cache_section );
+}
+
+/* forget a handle that is being closed; called for all handles */
+void reg_cache_remove_handle( HANDLE handle )
+{
+    struct reg_cache_handle *entry;
+
+    if (!reg_generations) return;
+
+    RtlEnterCriticalSection( &reg_cache_section );
+    if ((entry = find_cached_handle( handle )))
+    {
+        list_remove( &entry->entry );
+        RtlFreeHeap( GetProcessHeap(), 0, entry );
+    }
+    RtlLeaveCriticalSection( &reg_cache_section );
+}
+
+static unsigned int reg_cache_get_key( HANDLE handle )
+{
+    struct reg_cache_handle *entry;
+    unsigned int ret = 0;
+
+    if (!reg_generations) return 0;
+
+    RtlEnterCriticalSection( &reg_cache_section );
+    if ((entry = find_cached_handle( handle ))) ret = entry->key_id;
+    RtlLeaveCriticalSection( &reg_cache_section );
+    return ret;
+}
+
+/* report the cache statistics of the process */
+void reg_cache_process_detach(void)
+{
+    if (!reg_generations) return;
+
+    TRACE_(regcache)( "%u hits, %u negative hits, %u misses, %u stale, %u evictions, %u values (%u bytes)\n",
+                      reg_cache_stats.hits, reg_cache_stats.negative_hits, reg_cache_stats.misses,
+                      reg_cache_stats.stale, reg_cache_stats.evictions, reg_cache_count, reg_cache_bytes );
+}
+
+/* caller must hold reg_cache_section */
+static void free_cached_value( struct reg_cache_value *value )
+{
+    list_remove( &value->entry );
+    list_remove( &value->lru );
+    reg_cache_count--;
+    reg_cache_bytes -= value->name_len + value->data_len;
+    RtlFreeHeap( GetProcessHeap(), 0, value );
+}
+
+/* caller must hold reg_cache_section */
+static struct reg_cache_value *find_cached_value( unsigned int key_id, const UNICODE_STRING *name,
+                                                  unsigned int hash )
+{
+    struct reg_cache_value *value;
+
+    LIST_FOR_EACH_ENTRY( value, &reg_cache_values[hash], struct reg_cache_value, entry )
+    {
+        if (value->key_id != key_id || value->name_len != name->Length) continue;
+        if (!strncmpiW( value->name, name->Buffer, name->Length / sizeof(WCHAR) )) return value;
+    }
+    return NULL;
+}
+
+
 /******************************************************************************
  * NtCreateKey [NTDLL.@]
  * ZwCreateKey [NTDLL.@]
@@ -77,6 +290,7 @@ NTSTATUS WINAPI NtCreateKey( PHANDLE retkey, ACCESS_MASK access, const OBJECT_AT
         {
             *retkey = wine_server_ptr_handle( reply->hkey );
             if (dispos) *dispos = reply->created ? REG_CREATED_NEW_KEY : REG_OPENED_EXISTING_KEY;
+            reg_cache_set_handle( *retkey, reply->key_id );
         }
     }
     SERVER_END_REQ;
@@ -134,6 +348,7 @@ NTSTATUS WINAPI NtOpenKey( PHANDLE retkey, ACCESS_MASK access, const OBJECT_ATTR
         wine_server_add_data( req, attr->ObjectName->Buffer, len );
         ret = wine_server_call( req );
         *retkey = wine_server_ptr_handle( reply->hkey );
+        if (!ret) reg_cache_set_handle( *retkey, reply->key_id );
     }
     SERVER_END_REQ;
     TRACE("<- %p\n", *retkey);
@@ -466,6 +681,105 @@ NTSTATUS WINAPI NtEnumerateValueKey( HANDLE handle, ULONG index,
 }
 
 
+/******************************************************************************
+ *     reg_cache_query_value
+ *
+ * Fill a NtQueryValueKey result from the cache.  On a miss, return FALSE and
+ * the generations to store along with the value read from the server.
+ */
+static BOOL reg_cache_query_value( unsigned int key_id, const UNICODE_STRING *name,
+                                   KEY_VALUE_INFORMATION_CLASS info_class, void *info, DWORD length,
+                                   unsigned int fixed_size, unsigned int min_size, UCHAR *data_ptr,
+                                   DWORD *result_len, NTSTATUS *status,
+                                   unsigned int *generation, unsigned int *global )
+{
+    unsigned int hash = value_hash( key_id, name );
+    struct reg_cache_value *value;
+
+    RtlEnterCriticalSection( &reg_cache_section );
+    *generation = reg_generations[REG_GENERATION_SLOT( key_id )];
+    *global = reg_generations[0];
+    if (name->Length > REG_CACHE_MAX_NAME)
+    {
+        RtlLeaveCriticalSection( &reg_cache_section );
+        return FALSE;
+    }
+    if ((value = find_cached_value( key_id, name, hash )))
+    {
+        if (value->generation != *generation || value->global != *global)
+        {
+            free_cached_value( value );
+            reg_cache_stats.stale++;
+            value = NULL;
+        }
+    }
+    if (!value)
+    {
+        reg_cache_stats.misses++;
+        RtlLeaveCriticalSection( &reg_cache_section );
+        return FALSE;
+    }
+
+    list_remove( &value->lru );
+    list_add_head( &reg_cache_lru, &value->lru );
+    if (value->status)
+    {
+        reg_cache_stats.negative_hits++;
+        *status = value->status;
+    }
+    else
+    {
+        reg_cache_stats.hits++;
+        copy_key_value_info( info_class, info, length, value->type, name->Length, value->data_len );
+        if (data_ptr && length > fixed_size)
+            memcpy( data_ptr, value->data, min( length - fixed_size, value->data_len ));
+        *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : value->data_len);
+        if (length < min_size) *status = STATUS_BUFFER_TOO_SMALL;
+        else if (length < *result_len) *status = STATUS_BUFFER_OVERFLOW;
+        else *status = STATUS_SUCCESS;
+    }
+    RtlLeaveCriticalSection( &reg_cache_section );
+    return TRUE;
+}
+
+/* store the result of a value query; data is NULL for a missing value */
+static void reg_cache_add_value( unsigned int key_id, const UNICODE_STRING *name,
+                                 unsigned int generation, unsigned int global,
+                                 ULONG type, const void *data, DWORD data_len )
+{
+    unsigned int hash = value_hash( key_id, name );
+    struct reg_cache_value *value, *old;
+
+    if (data_len > REG_CACHE_MAX_DATA || name->Length > REG_CACHE_MAX_NAME) return;
+    if (!(value = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*value) + name->Length + data_len ))) return;
+
+    value->key_id     = key_id;
+    value->generation = generation;
+    value->global     = global;
+    value->status     = data ? STATUS_SUCCESS : STATUS_OBJECT_NAME_NOT_FOUND;
+    value->type       = type;
+    value->data_len   = data_len;
+    value->name_len   = name->Length;
+    value->name       = (WCHAR *)(value + 1);
+    value->data       = (BYTE *)value->name + name->Length;
+    memcpy( value->name, name->Buffer, name->Length );
+    if (data) memcpy( value->data, data, data_len );
+
+    RtlEnterCriticalSection( &reg_cache_section );
+    if ((old = find_cached_value( key_id, name, hash ))) free_cached_value( old );
+    list_add_head( &reg_cache_values[hash], &value->entry );
+    list_add_head( &reg_cache_lru, &value->lru );
+    reg_cache_count++;
+    reg_cache_bytes += name->Length + data_len;
+    while (reg_cache_count > REG_CACHE_MAX_VALUES || reg_cache_bytes > REG_CACHE_MAX_BYTES)
+    {
+        old = LIST_ENTRY( list_tail( &reg_cache_lru ), struct reg_cache_value, lru );
+        free_cached_value( old );
+        reg_cache_stats.evictions++;
+    }
+    RtlLeaveCriticalSection( &reg_cache_section );
+}
+
 /******************************************************************************
  * NtQueryValueKey [NTDLL.@]
  * ZwQueryValueKey [NTDLL.@]
@@ -479,7 +793,7 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
 {
     NTSTATUS ret;
     UCHAR *data_ptr;
-    unsigned int fixed_size = 0, min_size = 0;
+    unsigned int fixed_size = 0, min_size = 0, key_id, generation = 0, global = 0;
 
     TRACE( "(%p,%s,%d,%p,%d)\n", handle, debugstr_us(name), info_class, info, length );
 
@@ -517,6 +831,11 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
         return STATUS_INVALID_PARAMETER;
     }
 
+    if ((key_id = reg_cache_get_key( handle )) &&
+        reg_cache_query_value( key_id, name, info_class, info, length, fixed_size, min_size,
+                               data_ptr, result_len, &ret, &generation, &global ))
+        return ret;
+
     SERVER_START_REQ( get_key_value )
     {
         req->hkey = wine_server_obj_handle( handle );
@@ -529,7 +848,15 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
             *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : reply->total);
             if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
             else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
+            /* only complete values can be cached */
+            else if (key_id && data_ptr)
+                reg_cache_add_value( key_id, name, generation, global, reply->type, data_ptr, reply->total );
         }
+        else if (key_id && ret == STATUS_OBJECT_NAME_NOT_FOUND)
+            reg_cache_add_value( key_id, name, generation, global, REG_NONE, NULL, 0 );
+        /* the handle was closed behind our back, e.g. by another process */
+        else if (key_id && (ret == STATUS_INVALID_HANDLE || ret == STATUS_OBJECT_TYPE_MISMATCH))
+            reg_cache_remove_handle( handle );
     }
     SERVER_END_REQ;
     return ret;
@@ -26,6 +26,10 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -324,6 +328,263 @@ static void print_timestamp(void)
     DPRINTF( "%3u.%03u:", ticks / 1000, ticks % 1000 );
 }
 
+/***********************************************************************/
+/* binary relay log */
+/***********************************************************************/
+
+/* When WINE_RELAY_LOG is set in addition to +relay, calls and returns are
+ * stored as binary records in a per-thread buffer instead of being
+ * formatted, and the buffer is written to <WINE_RELAY_LOG>.<pid> with a
+ * single write() when it is full and when the thread or process exits.
+ * tools/relay-log turns the file back into the usual +relay output, or
+ * aggregates it into per-function call counts and times; keep it in sync
+ * with the record layout below.
+ *
+ * A RELAY_LOG_MODULE record is written directly when a dll is set up, so
+ * that it always precedes the calls into that dll.  It is followed by
+ * 'count' argument type masks, the dll name, and 'count' entry point names,
+ * all null-terminated.  A RELAY_LOG_CALL record is followed by 'count'
+ * arguments and, for each string argument, a WORD holding the number of
+ * characters recorded (RELAY_LOG_TRUNCATED if there were more) and the
+ * characters themselves. */
+
+#define RELAY_LOG_MODULE     1  /* descr, ordinal = ordinal base, count = entry points */
+#define RELAY_LOG_CALL       2  /* count = number of arguments */
+#define RELAY_LOG_RET        3  /* count = relay flags */
+
+#define RELAY_LOG_STRING_MAX 80      /* characters recorded per string argument */
+#define RELAY_LOG_TRUNCATED  0x8000
+#define RELAY_LOG_SIZE       0x10000 /* size of the per-thread buffers */
+
+struct relay_log_record
+{
+    unsigned int   size;      /* size of the whole record, padded to 8 bytes */
+    unsigned short type;      /* RELAY_LOG_* */
+    unsigned short count;
+    unsigned int   tid;       /* thread id (process id for modules) */
+    unsigned int   ordinal;   /* entry point index */
+    ULONGLONG      time;      /* performance counter, in 100ns units */
+    ULONGLONG      descr;     /* relay descriptor of the module */
+    ULONGLONG      ret_addr;  /* return address of the call */
+    ULONGLONG      retval;    /* return value */
+};
+
+struct relay_log
+{
+    struct relay_log *next;      /* next buffer in relay_logs */
+    LONG              in_use;    /* owned by a running thread */
+    unsigned int      used;      /* bytes of complete records in data */
+    char              data[RELAY_LOG_SIZE];
+};
+
+static int relay_log_fd = -1;
+static struct relay_log *relay_logs;  /* all the thread buffers, never freed */
+static RTL_RUN_ONCE relay_log_once = RTL_RUN_ONCE_INIT;
+
+/* open the log file, called once before the first dll is set up */
+static DWORD WINAPI init_relay_log( RTL_RUN_ONCE *once, void *param, void **context )
+{
+    const char *name = getenv( "WINE_RELAY_LOG" );
+    char *path;
+
+    if (!name || !*name) return TRUE;
+    if (!(path = RtlAllocateHeap( GetProcessHeap(), 0, strlen(name) + 12 ))) return TRUE;
+    sprintf( path, "%s.%u", name, (unsigned int)getpid() );
+    relay_log_fd = open( path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0666 );
+    if (relay_log_fd == -1) ERR( "cannot open relay log %s\n", debugstr_a(path) );
+    else fcntl( relay_log_fd, F_SETFD, FD_CLOEXEC );
+    RtlFreeHeap( GetProcessHeap(), 0, path );
+    return TRUE;
+}
+
+static void write_relay_log( const char *data, unsigned int size )
+{
+    while (size)
+    {
+        int ret = write( relay_log_fd, data, size );
+        if (ret <= 0) break;
+        data += ret;
+        size -= ret;
+    }
+}
+
+static void flush_relay_log( struct relay_log *log )
+{
+    write_relay_log( log->data, log->used );
+    log->used = 0;
+}
+
+/* get the buffer of the current thread, reusing one left by an exited thread if possible */
+static struct relay_log *get_relay_log(void)
+{
+    struct debug_info *info = ntdll_get_thread_data()->debug_info;
+    struct relay_log *log;
+    SIZE_T size = sizeof(*log);
+    void *ptr = NULL;
+
+    if ((log = info->relay_log)) return log;
+
+    for (log = relay_logs; log; log = log->next)
+        if (!interlocked_cmpxchg( &log->in_use, 1, 0 )) return info->relay_log = log;
+
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), &ptr, 0, &size, MEM_COMMIT, PAGE_READWRITE ))
+        return NULL;
+    log = ptr;
+    log->in_use = 1;
+    do log->next = relay_logs;
+    while (interlocked_cmpxchg_ptr( (void **)&relay_logs, log, log->next ) != log->next);
+    return info->relay_log = log;
+}
+
+/* return the log with at least size bytes free */
+static struct relay_log *reserve_relay_log( unsigned int size )
+{
+    struct relay_log *log = get_relay_log();
+
+    if (log && log->used + size > RELAY_LOG_SIZE) flush_relay_log( log );
+    return log;
+}
+
+static void init_relay_record( struct relay_log_record *rec, unsigned short type, unsigned short count,
+                               struct relay_descr *descr, unsigned int ordinal )
+{
+    LARGE_INTEGER now;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    rec->type     = type;
+    rec->count    = count;
+    rec->tid      = GetCurrentThreadId();
+    rec->ordinal  = ordinal;
+    rec->time     = now.QuadPart;
+    rec->descr    = (ULONG_PTR)descr;
+    rec->ret_addr = 0;
+    rec->retval   = 0;
+}
+
+/* store the characters of a string argument, return the end of the stored data */
+static char *log_string_arg( char *pos, const void *str, BOOL unicode )
+{
+    unsigned int char_size = unicode ? sizeof(WCHAR) : sizeof(char);
+    WORD len, stored;
+
+    if (unicode)
+    {
+        const WCHAR *strW = str;
+        for (len = 0; len < RELAY_LOG_STRING_MAX && strW[len]; len++) ;
+        stored = strW[len] ? len | RELAY_LOG_TRUNCATED : len;
+    }
+    else
+    {
+        const char *strA = str;
+        for (len = 0; len < RELAY_LOG_STRING_MAX && strA[len]; len++) ;
+        stored = strA[len] ? len | RELAY_LOG_TRUNCATED : len;
+    }
+    memcpy( pos, &stored, sizeof(stored) );
+    memcpy( pos + sizeof(stored), str, len * char_size );
+    return pos + sizeof(stored) + len * char_size;
+}
+
+static void log_relay_call( struct relay_descr *descr, unsigned int idx, const INT_PTR *args, ULONG_PTR ret_addr )
+{
+    WORD ordinal = LOWORD(idx);
+    BYTE nb_args = LOBYTE(HIWORD(idx));
+    unsigned int i, size, typemask = descr->arg_types[ordinal];
+    struct relay_log_record *rec;
+    struct relay_log *log;
+    ULONGLONG *values;
+    char *pos;
+
+    size = sizeof(*rec) + nb_args * (sizeof(ULONGLONG) + sizeof(WORD) + RELAY_LOG_STRING_MAX * sizeof(WCHAR));
+    if (!(log = reserve_relay_log( size ))) return;
+
+    rec = (struct relay_log_record *)(log->data + log->used);
+    init_relay_record( rec, RELAY_LOG_CALL, nb_args, descr, ordinal );
+    rec->ret_addr = ret_addr;
+    values = (ULONGLONG *)(rec + 1);
+    for (i = 0; i < nb_args; i++) values[i] = (ULONG_PTR)args[i];
+
+    pos = (char *)(values + nb_args);
+    for (i = 0; i < nb_args; i++, typemask >>= 2)
+        if ((typemask & 3) && !IS_INTARG(args[i]))
+            pos = log_string_arg( pos, (const void *)args[i], typemask & 2 );
+
+    rec->size = (pos - (char *)rec + 7) & ~7;
+    log->used += rec->size;
+}
+
+static void log_relay_ret( struct relay_descr *descr, unsigned int idx, ULONG_PTR ret_addr, LONGLONG retval )
+{
+    struct relay_log_record *rec;
+    struct relay_log *log;
+
+    if (!(log = reserve_relay_log( sizeof(*rec) ))) return;
+
+    rec = (struct relay_log_record *)(log->data + log->used);
+    init_relay_record( rec, RELAY_LOG_RET, HIBYTE(HIWORD(idx)), descr, LOWORD(idx) );
+    rec->ret_addr = ret_addr;
+    rec->retval   = retval;
+    rec->size     = sizeof(*rec);
+    log->used += rec->size;
+}
+
+/* describe a newly relayed dll in the log */
+static void log_relay_module( struct relay_descr *descr, unsigned int count )
+{
+    struct relay_private_data *data = descr->private;
+    struct relay_log_record *rec;
+    unsigned int i, size = sizeof(*rec) + count * sizeof(DWORD) + strlen( data->dllname ) + 1;
+    char *pos;
+
+    for (i = 0; i < count; i++)
+        size += (data->entry_points[i].name ? strlen( data->entry_points[i].name ) : 0) + 1;
+    size = (size + 7) & ~7;
+    if (!(rec = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, size ))) return;
+
+    init_relay_record( rec, RELAY_LOG_MODULE, count, descr, data->base );
+    rec->tid  = getpid();
+    rec->size = size;
+    memcpy( rec + 1, descr->arg_types, count * sizeof(DWORD) );
+    pos = (char *)(rec + 1) + count * sizeof(DWORD);
+    strcpy( pos, data->dllname );
+    pos += strlen( pos ) + 1;
+    for (i = 0; i < count; i++)
+    {
+        if (data->entry_points[i].name) strcpy( pos, data->entry_points[i].name );
+        pos += strlen( pos ) + 1;
+    }
+    write_relay_log( (char *)rec, size );
+    RtlFreeHeap( GetProcessHeap(), 0, rec );
+}
+
+/***********************************************************************
+ *           RELAY_ThreadDetach
+ *
+ * Write the log of the exiting thread and give its buffer back.
+ */
+void RELAY_ThreadDetach(void)
+{
+    struct debug_info *info = ntdll_get_thread_data()->debug_info;
+    struct relay_log *log = info->relay_log;
+
+    if (!log) return;
+    flush_relay_log( log );
+    info->relay_log = NULL;
+    interlocked_xchg( &log->in_use, 0 );
+}
+
+/***********************************************************************
+ *           RELAY_ProcessDetach
+ *
+ * Write the logs of all threads; the other threads have been killed by now.
+ */
+void RELAY_ProcessDetach(void)
+{
+    struct relay_log *log;
+
+    if (relay_log_fd == -1) return;
+    for (log = relay_logs; log; log = log->next) flush_relay_log( log );
+}
+
 /***********************************************************************
  *           relay_trace_entry
  *
@@ -336,7 +597,8 @@ void * WINAPI relay_trace_entry( struct relay_descr *descr, unsigned int idx, co
     struct relay_private_data *data = descr->private;
     struct relay_entry_point *entry_point = data->entry_points + ordinal;
 
-    if (TRACE_ON(relay))
+    if (relay_log_fd != -1) log_relay_call( descr, idx, stack + 1, stack[0] );
+    else if (TRACE_ON(relay))
     {
         if (TRACE_ON(timestamp)) print_timestamp();
 
@@ -361,6 +623,11 @@ void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
     struct relay_private_data *data = descr->private;
     struct relay_entry_point *entry_point = data->entry_points + ordinal;
 
+    if (relay_log_fd != -1)
+    {
+        log_relay_ret( descr, idx, stack[0], retval );
+        return;
+    }
     if (!TRACE_ON(relay)) return;
 
     if (TRACE_ON(timestamp)) print_timestamp();
@@ -490,7 +757,8 @@ void WINAPI __regs_relay_call_regs( struct relay_descr *descr, unsigned int idx,
     context->Eip = ret_addr;
     context->Esp += nb_args * sizeof(int);
 
-    if (TRACE_ON(relay))
+    if (relay_log_fd != -1) log_relay_call( descr, idx, args, ret_addr );
+    else if (TRACE_ON(relay))
     {
         if (entry_point->name)
             DPRINTF( "%04x:Call %s.%s(", GetCurrentThreadId(), data->dllname, entry_point->name );
@@ -517,7 +785,8 @@ void WINAPI __regs_relay_call_regs( struct relay_descr *descr, unsigned int idx,
 
     call_entry_point( orig_func + 12 + *(int *)(orig_func + 1), nb_args, args_copy, 0 );
 
-    if (TRACE_ON(relay))
+    if (relay_log_fd != -1) log_relay_ret( descr, idx, context->Eip, context->Eax );
+    else if (TRACE_ON(relay))
     {
         if (entry_point->name)
             DPRINTF( "%04x:Ret  %s.%s() retval=%08x ret=%08x\n",
@@ -697,6 +966,7 @@ void RELAY_SetupDLL( HMODULE module )
     const WORD *ordptr;
 
     RtlRunOnceExecuteOnce( &init_once, init_debug_lists, NULL, NULL );
+    RtlRunOnceExecuteOnce( &relay_log_once, init_relay_log, NULL, NULL );
 
     exports = RtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &size );
     if (!exports) return;
@@ -742,6 +1012,8 @@ void RELAY_SetupDLL( HMODULE module )
         data->entry_points[i].orig_func = (char *)module + *funcs;
         *funcs = entry_point_rva + descr->entry_point_offsets[i];
     }
+
+    if (relay_log_fd != -1) log_relay_module( descr, exports->NumberOfFunctions );
 }
 
 #else  /* __i386__ || __x86_64__ || __arm__ */
@@ -756,6 +1028,14 @@ void RELAY_SetupDLL( HMODULE module )
 {
 }
 
+void RELAY_ThreadDetach(void)
+{
+}
+
+void RELAY_ProcessDetach(void)
+{
+}
+
 #endif  /* __i386__ || __x86_64__ || __arm__ */
 
 
@@ -259,7 +259,8 @@ static void test_query_process(void)
     DWORD last_pid;
     ULONG ReturnLength;
     int i = 0, k = 0;
-    BOOL is_nt = FALSE;
+    BOOL is_nt = FALSE, found_process = FALSE, found_thread = FALSE;
+    DWORD start;
     SYSTEM_BASIC_INFORMATION sbi;
 
     /* Copy of our winternl.h structure turned into a private one */
@@ -352,9 +353,17 @@ static void test_query_process(void)
                 ok ( spi->ti[j].ClientId.UniqueProcess == spi->UniqueProcessId,
                      "The owning pid of the thread (%p) doesn't equal the pid (%p) of the process\n",
                      spi->ti[j].ClientId.UniqueProcess, spi->UniqueProcessId);
+                if (spi->ti[j].ClientId.UniqueThread == ULongToHandle(GetCurrentThreadId()))
+                    found_thread = TRUE;
             }
         }
 
+        if (spi->UniqueProcessId == ULongToHandle(GetCurrentProcessId()))
+        {
+            found_process = TRUE;
+            ok( spi->ProcessName.Length && spi->ProcessName.Buffer, "Expected a process name\n");
+        }
+
         if (!spi->NextEntryOffset) break;
 
         one_before_last_pid = last_pid;
@@ -366,6 +375,19 @@ static void test_query_process(void)
 
     if (one_before_last_pid == 0) one_before_last_pid = last_pid;
 
+    ok( found_process, "Current process not found\n");
+    if (!is_nt) ok( found_thread, "Current thread not found\n");
+
+    /* monitoring tools query this repeatedly, make sure it stays cheap */
+    start = GetTickCount();
+    for (i = 0; i < 100; i++)
+    {
+        status = pNtQuerySystemInformation(SystemProcessInformation, spi_buf, SystemInformationLength, &ReturnLength);
+        if (status != STATUS_SUCCESS) break;
+    }
+    ok( status == STATUS_SUCCESS || status == STATUS_INFO_LENGTH_MISMATCH, "Expected STATUS_SUCCESS, got %08x\n", status);
+    trace("100 process queries took %u ms\n", GetTickCount() - start);
+
     HeapFree( GetProcessHeap(), 0, spi_buf);
 }
 
@@ -1242,6 +1242,214 @@ static void test_redirection(void)
     pNtClose( key64 );
 }
 
+/* open a key and return its value, 0 if the key doesn't exist */
+static DWORD get_open_key_value( HANDLE root, const WCHAR *name, DWORD flags )
+{
+    char tmp[32];
+    KEY_VALUE_PARTIAL_INFORMATION *info = (KEY_VALUE_PARTIAL_INFORMATION *)tmp;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING str;
+    NTSTATUS status;
+    HANDLE key;
+    DWORD dw, len = sizeof(tmp);
+
+    pRtlInitUnicodeString( &str, name );
+    InitializeObjectAttributes( &attr, &str, OBJ_CASE_INSENSITIVE, root, NULL );
+    status = pNtOpenKey( &key, flags | KEY_READ, &attr );
+    if (status == STATUS_OBJECT_NAME_NOT_FOUND) return 0;
+    ok( status == STATUS_SUCCESS, "%08x: NtOpenKey failed: 0x%08x\n", flags, status );
+    if (status) return 0;
+
+    status = pNtQueryValueKey( key, &value_str, KeyValuePartialInformation, info, len, &len );
+    ok( status == STATUS_SUCCESS, "%08x: NtQueryValueKey failed: 0x%08x\n", flags, status );
+    dw = status ? 0 : *(DWORD *)info->Data;
+    pNtClose( key );
+    return dw;
+}
+
+static void _check_open_key_value( int line, HANDLE root, const WCHAR *name, DWORD flags, DWORD expect )
+{
+    DWORD dw = get_open_key_value( root, name, flags );
+    ok_(__FILE__,line)( dw == expect, "%s %08x: wrong value %u/%u\n", wine_dbgstr_w(name), flags, dw, expect );
+}
+#define check_open_key_value(root,name,flags,expect) _check_open_key_value( __LINE__, root, name, flags, expect )
+
+/* create a key and set its value, unless it is 0 */
+static HANDLE create_key_value( HANDLE root, const WCHAR *name, DWORD flags, DWORD value )
+{
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING str;
+    NTSTATUS status;
+    HANDLE key;
+
+    pRtlInitUnicodeString( &str, name );
+    InitializeObjectAttributes( &attr, &str, OBJ_CASE_INSENSITIVE, root, NULL );
+    status = pNtCreateKey( &key, flags | KEY_ALL_ACCESS, &attr, 0, 0, 0, 0 );
+    ok( status == STATUS_SUCCESS, "%s: NtCreateKey failed: 0x%08x\n", wine_dbgstr_w(name), status );
+    if (status) return 0;
+    if (!value) return key;
+    status = pNtSetValueKey( key, &value_str, 0, REG_DWORD, &value, sizeof(value) );
+    ok( status == STATUS_SUCCESS, "%s: NtSetValueKey failed: 0x%08x\n", wine_dbgstr_w(name), status );
+    return key;
+}
+
+/* the server remembers the keys that paths were opened to, opening a path
+ * again must still see the keys deleted, created or redirected since */
+static void test_open_key_cache(void)
+{
+    static const WCHAR deepW[] = {'d','e','e','p',0};
+    static const WCHAR deep_subW[] = {'d','e','e','p','\\','s','u','b',0};
+    static const WCHAR deep_sub_upperW[] = {'D','E','E','P','\\','S','U','B',0};
+    static const WCHAR target1W[] = {'t','a','r','g','e','t','1',0};
+    static const WCHAR target1_subW[] = {'t','a','r','g','e','t','1','\\','s','u','b',0};
+    static const WCHAR target2W[] = {'t','a','r','g','e','t','2',0};
+    static const WCHAR target2_subW[] = {'t','a','r','g','e','t','2','\\','s','u','b',0};
+    static const WCHAR linkW[] = {'l','i','n','k',0};
+    static const WCHAR link_subW[] = {'l','i','n','k','\\','s','u','b',0};
+    static const WCHAR symlinkW[] = {'S','y','m','b','o','l','i','c','L','i','n','k','V','a','l','u','e',0};
+    static const WCHAR softwareW[] = {'\\','R','e','g','i','s','t','r','y','\\',
+                                      'M','a','c','h','i','n','e','\\',
+                                      'S','o','f','t','w','a','r','e',0};
+    static const WCHAR wine64W[] = {'\\','R','e','g','i','s','t','r','y','\\',
+                                    'M','a','c','h','i','n','e','\\',
+                                    'S','o','f','t','w','a','r','e','\\',
+                                    'W','i','n','e',0};
+    static const WCHAR wine32W[] = {'\\','R','e','g','i','s','t','r','y','\\',
+                                    'M','a','c','h','i','n','e','\\',
+                                    'S','o','f','t','w','a','r','e','\\',
+                                    'W','o','w','6','4','3','2','N','o','d','e','\\',
+                                    'W','i','n','e',0};
+    static const WCHAR cachetestW[] = {'C','a','c','h','e','t','e','s','t',0};
+    static const WCHAR wine_cachetestW[] = {'W','i','n','e','\\','C','a','c','h','e','t','e','s','t',0};
+    UNICODE_STRING symlink_str, str;
+    OBJECT_ATTRIBUTES attr;
+    NTSTATUS status;
+    HANDLE root, deep, sub, target1, target2, link, key, root32, root64, key32, key64;
+    WCHAR *target;
+    DWORD target_len, i;
+    ULONG is_wow64, len;
+
+    InitializeObjectAttributes( &attr, &winetestpath, 0, 0, 0 );
+    status = pNtCreateKey( &root, KEY_ALL_ACCESS, &attr, 0, 0, 0, 0 );
+    ok( status == STATUS_SUCCESS, "NtCreateKey failed: 0x%08x\n", status );
+
+    /* a deleted key is gone, and a new one takes its place */
+    deep = create_key_value( root, deepW, 0, 1 );
+    sub = create_key_value( root, deep_subW, 0, 2 );
+    for (i = 0; i < 2; i++)
+    {
+        check_open_key_value( root, deep_subW, 0, 2 );
+        check_open_key_value( root, deep_sub_upperW, 0, 2 );
+    }
+    status = pNtDeleteKey( sub );
+    ok( status == STATUS_SUCCESS, "NtDeleteKey failed: 0x%08x\n", status );
+    pNtClose( sub );
+    check_open_key_value( root, deep_subW, 0, 0 );
+    check_open_key_value( root, deep_sub_upperW, 0, 0 );
+    sub = create_key_value( root, deep_subW, 0, 3 );
+    check_open_key_value( root, deep_subW, 0, 3 );
+    check_open_key_value( root, deep_sub_upperW, 0, 3 );
+    pNtDeleteKey( sub );
+    pNtClose( sub );
+    pNtDeleteKey( deep );
+    pNtClose( deep );
+
+    /* a path through a symlink follows the link when it changes */
+    target1 = create_key_value( root, target1W, 0, 1 );
+    sub = create_key_value( root, target1_subW, 0, 10 );
+    pNtClose( sub );
+    target2 = create_key_value( root, target2W, 0, 2 );
+    sub = create_key_value( root, target2_subW, 0, 20 );
+    pNtClose( sub );
+
+    pRtlInitUnicodeString( &str, linkW );
+    InitializeObjectAttributes( &attr, &str, 0, root, NULL );
+    status = pNtCreateKey( &link, KEY_ALL_ACCESS, &attr, 0, 0, REG_OPTION_CREATE_LINK, 0 );
+    ok( status == STATUS_SUCCESS, "NtCreateKey failed: 0x%08x\n", status );
+
+    pRtlInitUnicodeString( &symlink_str, symlinkW );
+    target_len = winetestpath.Length + sizeof(WCHAR) + sizeof(target1W) - sizeof(WCHAR);
+    target = pRtlAllocateHeap( GetProcessHeap(), 0, target_len );
+    memcpy( target, winetestpath.Buffer, winetestpath.Length );
+    target[winetestpath.Length / sizeof(WCHAR)] = '\\';
+    memcpy( target + winetestpath.Length / sizeof(WCHAR) + 1, target1W, sizeof(target1W) - sizeof(WCHAR) );
+    status = pNtSetValueKey( link, &symlink_str, 0, REG_LINK, target, target_len );
+    ok( status == STATUS_SUCCESS, "NtSetValueKey failed: 0x%08x\n", status );
+    for (i = 0; i < 2; i++) check_open_key_value( root, link_subW, 0, 10 );
+
+    memcpy( target + winetestpath.Length / sizeof(WCHAR) + 1, target2W, sizeof(target2W) - sizeof(WCHAR) );
+    status = pNtSetValueKey( link, &symlink_str, 0, REG_LINK, target, target_len );
+    ok( status == STATUS_SUCCESS, "NtSetValueKey failed: 0x%08x\n", status );
+    check_open_key_value( root, link_subW, 0, 20 );
+
+    /* and when its target is deleted */
+    pRtlInitUnicodeString( &str, target2_subW );
+    InitializeObjectAttributes( &attr, &str, 0, root, NULL );
+    status = pNtOpenKey( &sub, KEY_ALL_ACCESS, &attr );
+    ok( status == STATUS_SUCCESS, "NtOpenKey failed: 0x%08x\n", status );
+    pNtDeleteKey( sub );
+    pNtClose( sub );
+    check_open_key_value( root, link_subW, 0, 0 );
+
+    pNtDeleteKey( link );
+    pNtClose( link );
+    pRtlFreeHeap( GetProcessHeap(), 0, target );
+    pRtlInitUnicodeString( &str, target1_subW );
+    status = pNtOpenKey( &sub, KEY_ALL_ACCESS, &attr );
+    ok( status == STATUS_SUCCESS, "NtOpenKey failed: 0x%08x\n", status );
+    pNtDeleteKey( sub );
+    pNtClose( sub );
+    pNtDeleteKey( target1 );
+    pNtClose( target1 );
+    pNtDeleteKey( target2 );
+    pNtClose( target2 );
+    pNtDeleteKey( root );
+    pNtClose( root );
+
+    /* the same path opened in the 32-bit and 64-bit views of a Wow64 process */
+    if (ptr_size != 32 || pNtQueryInformationProcess( GetCurrentProcess(), ProcessWow64Information,
+                                                      &is_wow64, sizeof(is_wow64), &len ) || !is_wow64)
+    {
+        trace( "Not on Wow64, no redirection\n" );
+        return;
+    }
+
+    root64 = create_key_value( 0, wine64W, KEY_WOW64_64KEY, 0 );
+    root32 = create_key_value( 0, wine32W, KEY_WOW64_32KEY, 0 );
+    key64 = create_key_value( root64, cachetestW, KEY_WOW64_64KEY, 64 );
+    key32 = create_key_value( root32, cachetestW, KEY_WOW64_32KEY, 32 );
+
+    pRtlInitUnicodeString( &str, softwareW );
+    InitializeObjectAttributes( &attr, &str, 0, 0, NULL );
+    status = pNtOpenKey( &key, KEY_WOW64_64KEY | KEY_READ, &attr );
+    ok( status == STATUS_SUCCESS, "NtOpenKey failed: 0x%08x\n", status );
+    for (i = 0; i < 2; i++)
+    {
+        check_open_key_value( key, wine_cachetestW, KEY_WOW64_32KEY, 32 );
+        check_open_key_value( key, wine_cachetestW, KEY_WOW64_64KEY, 64 );
+    }
+
+    status = pNtDeleteKey( key32 );
+    ok( status == STATUS_SUCCESS, "NtDeleteKey failed: 0x%08x\n", status );
+    pNtClose( key32 );
+    check_open_key_value( key, wine_cachetestW, KEY_WOW64_32KEY, 0 );
+    check_open_key_value( key, wine_cachetestW, KEY_WOW64_64KEY, 64 );
+
+    key32 = create_key_value( root32, cachetestW, KEY_WOW64_32KEY, 33 );
+    check_open_key_value( key, wine_cachetestW, KEY_WOW64_32KEY, 33 );
+    check_open_key_value( key, wine_cachetestW, KEY_WOW64_64KEY, 64 );
+    pNtClose( key );
+
+    pNtDeleteKey( key32 );
+    pNtClose( key32 );
+    pNtDeleteKey( key64 );
+    pNtClose( key64 );
+    pNtDeleteKey( root32 );
+    pNtClose( root32 );
+    pNtDeleteKey( root64 );
+    pNtClose( root64 );
+}
+
 static void test_long_value_name(void)
 {
     HANDLE key;
@@ -1277,6 +1485,110 @@ static void test_long_value_name(void)
     pNtClose(key);
 }
 
+static void test_cached_values(void)
+{
+    static const WCHAR cachedW[] = {'c','a','c','h','e','d',0};
+    static const WCHAR upperW[] = {'C','A','C','H','E','D',0};
+    static const WCHAR subkeyW[] = {'s','u','b','k','e','y',0};
+    char buffer[FIELD_OFFSET(KEY_VALUE_PARTIAL_INFORMATION, Data[16])];
+    KEY_VALUE_PARTIAL_INFORMATION *info = (KEY_VALUE_PARTIAL_INFORMATION *)buffer;
+    HANDLE key, key2;
+    NTSTATUS status;
+    OBJECT_ATTRIBUTES attr, subattr;
+    UNICODE_STRING name, upper, subkey, long_name;
+    DWORD i, len, value, start;
+
+    pRtlInitUnicodeString(&name, cachedW);
+    pRtlInitUnicodeString(&upper, upperW);
+    pRtlInitUnicodeString(&subkey, subkeyW);
+    InitializeObjectAttributes(&attr, &winetestpath, 0, 0, 0);
+    status = pNtOpenKey(&key, KEY_READ, &attr);
+    ok(status == STATUS_SUCCESS, "NtOpenKey Failed: 0x%08x\n", status);
+    status = pNtOpenKey(&key2, KEY_READ|KEY_WRITE, &attr);
+    ok(status == STATUS_SUCCESS, "NtOpenKey Failed: 0x%08x\n", status);
+
+    /* changes made through another handle must be seen through the first one */
+    status = pNtQueryValueKey(key, &name, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_OBJECT_NAME_NOT_FOUND, "NtQueryValueKey returned 0x%08x\n", status);
+    for (value = 1; value <= 3; value++)
+    {
+        status = pNtSetValueKey(key2, &name, 0, REG_DWORD, &value, sizeof(value));
+        ok(status == STATUS_SUCCESS, "NtSetValueKey Failed: 0x%08x\n", status);
+        for (i = 0; i < 2; i++)
+        {
+            memset(buffer, 0, sizeof(buffer));
+            status = pNtQueryValueKey(key, i ? &upper : &name, KeyValuePartialInformation,
+                                      buffer, sizeof(buffer), &len);
+            ok(status == STATUS_SUCCESS, "NtQueryValueKey returned 0x%08x\n", status);
+            ok(info->Type == REG_DWORD, "wrong type %u\n", info->Type);
+            ok(info->DataLength == sizeof(value), "wrong length %u\n", info->DataLength);
+            ok(*(DWORD *)info->Data == value, "got %u, expected %u\n", *(DWORD *)info->Data, value);
+        }
+    }
+
+    /* a cached value must still honor the buffer size */
+    status = pNtQueryValueKey(key, &name, KeyValuePartialInformation, buffer,
+                              FIELD_OFFSET(KEY_VALUE_PARTIAL_INFORMATION, Data), &len);
+    ok(status == STATUS_BUFFER_OVERFLOW, "NtQueryValueKey returned 0x%08x\n", status);
+    ok(len == FIELD_OFFSET(KEY_VALUE_PARTIAL_INFORMATION, Data[sizeof(value)]), "wrong len %u\n", len);
+
+    /* the cache is shared by the handles of a key */
+    pNtClose(key);
+    status = pNtOpenKey(&key, KEY_READ, &attr);
+    ok(status == STATUS_SUCCESS, "NtOpenKey Failed: 0x%08x\n", status);
+    status = pNtQueryValueKey(key, &name, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_SUCCESS, "NtQueryValueKey returned 0x%08x\n", status);
+    ok(*(DWORD *)info->Data == 3, "got %u\n", *(DWORD *)info->Data);
+
+    status = pNtDeleteValueKey(key2, &name);
+    ok(status == STATUS_SUCCESS, "NtDeleteValueKey Failed: 0x%08x\n", status);
+    status = pNtQueryValueKey(key, &name, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_OBJECT_NAME_NOT_FOUND, "NtQueryValueKey returned 0x%08x\n", status);
+
+    value = 4;
+    status = pNtSetValueKey(key2, &name, 0, REG_DWORD, &value, sizeof(value));
+    ok(status == STATUS_SUCCESS, "NtSetValueKey Failed: 0x%08x\n", status);
+    start = GetTickCount();
+    for (i = 0; i < 10000; i++)
+    {
+        status = pNtQueryValueKey(key, &name, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+        if (status || *(DWORD *)info->Data != 4) break;
+    }
+    ok(i == 10000, "NtQueryValueKey returned 0x%08x\n", status);
+    trace("10000 value queries took %u ms\n", GetTickCount() - start);
+
+    /* a closed handle reused for another key must not return the values of the first one */
+    pNtClose(key);
+    InitializeObjectAttributes(&subattr, &subkey, 0, key2, 0);
+    status = pNtCreateKey(&key, KEY_ALL_ACCESS, &subattr, 0, 0, 0, 0);
+    ok(status == STATUS_SUCCESS, "NtCreateKey Failed: 0x%08x\n", status);
+    status = pNtQueryValueKey(key, &name, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_OBJECT_NAME_NOT_FOUND, "NtQueryValueKey returned 0x%08x\n", status);
+    pNtDeleteKey(key);
+    pNtClose(key);
+
+    /* names too long for the cache are still read from the server */
+    long_name.MaximumLength = 300 * sizeof(WCHAR);
+    long_name.Length = long_name.MaximumLength - sizeof(WCHAR);
+    long_name.Buffer = HeapAlloc(GetProcessHeap(), 0, long_name.MaximumLength);
+    for (i = 0; i < long_name.Length / sizeof(WCHAR); i++) long_name.Buffer[i] = 'a';
+    long_name.Buffer[i] = 0;
+    for (i = 0; i < 2; i++)
+    {
+        status = pNtQueryValueKey(key2, &long_name, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+        ok(status == STATUS_OBJECT_NAME_NOT_FOUND, "NtQueryValueKey returned 0x%08x\n", status);
+    }
+    status = pNtSetValueKey(key2, &long_name, 0, REG_DWORD, &value, sizeof(value));
+    ok(status == STATUS_SUCCESS, "NtSetValueKey Failed: 0x%08x\n", status);
+    status = pNtQueryValueKey(key2, &long_name, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_SUCCESS, "NtQueryValueKey returned 0x%08x\n", status);
+    pNtDeleteValueKey(key2, &long_name);
+    HeapFree(GetProcessHeap(), 0, long_name.Buffer);
+
+    pNtDeleteValueKey(key2, &name);
+    pNtClose(key2);
+}
+
 START_TEST(reg)
 {
     static const WCHAR winetest[] = {'\\','W','i','n','e','T','e','s','t',0};
@@ -1299,9 +1611,11 @@ START_TEST(reg)
     test_NtFlushKey();
     test_NtQueryValueKey();
     test_long_value_name();
+    test_cached_values();
     test_NtDeleteKey();
     test_symlinks();
     test_redirection();
+    test_open_key_cache();
 
     pRtlFreeUnicodeString(&winetestpath);
 
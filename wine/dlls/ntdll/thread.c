@@ -377,6 +377,7 @@ void exit_thread( int status )
     }
 
     LdrShutdownThread();
+    RELAY_ThreadDetach();
 
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
 
@@ -417,6 +418,7 @@ static void start_thread( struct startup_info *info )
 
     debug_info.str_pos = debug_info.strings;
     debug_info.out_pos = debug_info.output;
+    debug_info.relay_log = NULL;
     thread_data->debug_info = &debug_info;
     thread_data->pthread_id = pthread_self();
 
@@ -35,6 +35,12 @@
 #ifdef HAVE_SYS_STAT_H
 # include <sys/stat.h>
 #endif
+#ifdef HAVE_SYS_TIME_H
+# include <sys/time.h>
+#endif
+#ifdef HAVE_DIRENT_H
+# include <dirent.h>
+#endif
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
@@ -1051,6 +1057,205 @@ static NTSTATUS stat_mapping_file( struct file_view *view, struct stat *st )
 }
 
 
+/* Images that have to be relocated are saved once relocated in the server
+ * directory, keyed by file identity, a hash of the headers and load address.
+ * Other processes that load the same image at the same address map that copy
+ * instead of relocating their own, so that the relocated pages are shared
+ * copy-on-write through the page cache.  The least recently used copies are
+ * removed once the directory grows beyond RELOC_CACHE_MAX_SIZE. */
+
+#define RELOC_CACHE_NAME_MAX 1024
+#define RELOC_CACHE_MAX_SIZE (256 * 1024 * 1024)
+
+static int reloc_cache_disabled;
+static int reloc_cache_checked;
+
+/***********************************************************************
+ *           check_reloc_cache_exec
+ *
+ * Check that code can be mapped from the cache directory, the server
+ * directory lives in /tmp which is often mounted noexec.
+ */
+static BOOL check_reloc_cache_exec( const char *dir )
+{
+    char name[RELOC_CACHE_NAME_MAX];
+    void *ptr;
+    int fd, ret;
+
+    ret = snprintf( name, sizeof(name), "%s/probe.%x", dir, GetCurrentThreadId() );
+    if (ret < 0 || ret >= sizeof(name)) return FALSE;
+    if ((fd = open( name, O_RDWR | O_CREAT | O_TRUNC, 0600 )) == -1) return FALSE;
+    unlink( name );
+    ret = (write( fd, "", 1 ) == 1);
+    if (ret && (ptr = mmap( NULL, 1, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0 )) != MAP_FAILED)
+        munmap( ptr, 1 );
+    else
+        ret = FALSE;
+    close( fd );
+    return ret;
+}
+
+/***********************************************************************
+ *           get_reloc_cache_name
+ *
+ * Build the name of the relocated copy of an image; helper for map_image.
+ */
+static BOOL get_reloc_cache_name( char *name, size_t len, const struct stat *st, void *ptr, SIZE_T size,
+                                  SIZE_T header_size )
+{
+    const unsigned char *p = ptr;
+    const char *dir;
+    unsigned long nsec = 0;
+    unsigned int hash = 2166136261u;
+    SIZE_T i;
+    int ret;
+
+    if (reloc_cache_disabled) return FALSE;
+    if (!(dir = wine_get_server_dir())) return FALSE;
+    ret = snprintf( name, len, "%s/relocs", dir );
+    if (ret < 0 || ret >= len) return FALSE;
+    if (mkdir( name, 0700 ) == -1 && errno != EEXIST)
+    {
+        TRACE_(module)( "cannot create %s, not caching relocated images\n", name );
+        reloc_cache_disabled = 1;
+        return FALSE;
+    }
+    if (!reloc_cache_checked)
+    {
+        reloc_cache_checked = 1;
+        if (!check_reloc_cache_exec( name ))
+        {
+            TRACE_(module)( "cannot map code from %s, not caching relocated images\n", name );
+            reloc_cache_disabled = 1;
+            return FALSE;
+        }
+    }
+
+    /* the file time isn't precise enough to notice an image replaced in place,
+     * the headers include the link time stamp and checksum */
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    nsec = st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    nsec = st->st_mtimespec.tv_nsec;
+#endif
+    for (i = 0; i < header_size; i++) hash = (hash ^ p[i]) * 16777619;
+
+    ret = snprintf( name, len, "%s/relocs/%lx-%lx-%lx.%lx-%lx-%08x-%p-%lx", dir, (unsigned long)st->st_dev,
+                    (unsigned long)st->st_ino, (unsigned long)st->st_mtime, nsec, (unsigned long)st->st_size,
+                    hash, ptr, (unsigned long)size );
+    return ret >= 0 && ret < len;
+}
+
+/***********************************************************************
+ *           trim_reloc_cache
+ *
+ * Remove the least recently used relocated images until the cache fits
+ * in RELOC_CACHE_MAX_SIZE; helper for save_relocated_image.
+ */
+static void trim_reloc_cache( const char *dir )
+{
+#ifdef HAVE_DIRENT_H
+    char name[RELOC_CACHE_NAME_MAX], oldest[RELOC_CACHE_NAME_MAX];
+    unsigned long long total;
+    struct dirent *de;
+    struct stat st;
+    time_t oldest_time;
+    off_t oldest_size;
+    DIR *d;
+    int ret;
+
+    for (;;)
+    {
+        if (!(d = opendir( dir ))) return;
+        total = 0;
+        oldest[0] = 0;
+        oldest_time = 0;
+        oldest_size = 0;
+        while ((de = readdir( d )))
+        {
+            if (de->d_name[0] == '.') continue;
+            ret = snprintf( name, sizeof(name), "%s/%s", dir, de->d_name );
+            if (ret < 0 || ret >= sizeof(name)) continue;
+            if (stat( name, &st ) == -1 || !S_ISREG( st.st_mode )) continue;
+            total += st.st_size;
+            if (!oldest[0] || st.st_mtime < oldest_time)
+            {
+                strcpy( oldest, name );
+                oldest_time = st.st_mtime;
+                oldest_size = st.st_size;
+            }
+        }
+        closedir( d );
+        if (total <= RELOC_CACHE_MAX_SIZE || !oldest[0]) return;
+        TRACE_(module)( "removing relocated image %s\n", oldest );
+        if (unlink( oldest ) == -1) return;
+        if (total - oldest_size <= RELOC_CACHE_MAX_SIZE) return;
+    }
+#endif
+}
+
+/***********************************************************************
+ *           map_relocated_image
+ *
+ * Map the cached relocated copy of an image over the whole view.
+ */
+static BOOL map_relocated_image( struct file_view *view, const char *name )
+{
+    struct stat st;
+    BOOL ret = FALSE;
+    int fd;
+
+    if ((fd = open( name, O_RDONLY )) == -1) return FALSE;
+    if (!fstat( fd, &st ) && st.st_size == view->size)
+        ret = !map_file_into_view( view, fd, 0, view->size, 0,
+                                   VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY, FALSE );
+#ifdef HAVE_FUTIMES
+    /* the modification time orders the copies for trim_reloc_cache */
+    if (ret) futimes( fd, NULL );
+#endif
+    close( fd );
+    if (ret) TRACE_(module)( "using relocated image %s\n", name );
+    return ret;
+}
+
+/***********************************************************************
+ *           save_relocated_image
+ *
+ * Store a freshly relocated image for the other processes.
+ */
+static void save_relocated_image( const char *name, const char *ptr, SIZE_T size )
+{
+    char tmp[RELOC_CACHE_NAME_MAX];
+    SIZE_T pos = 0;
+    char *p;
+    int fd, ret;
+
+    ret = snprintf( tmp, sizeof(tmp), "%s.%x", name, GetCurrentThreadId() );
+    if (ret < 0 || ret >= sizeof(tmp)) return;
+    if ((fd = open( tmp, O_WRONLY | O_CREAT | O_EXCL, 0600 )) == -1) return;
+    while (pos < size)
+    {
+        if ((ret = write( fd, ptr + pos, size - pos )) <= 0) break;
+        pos += ret;
+    }
+    close( fd );
+    /* rename is atomic, readers see either nothing or the complete image */
+    if (pos < size || rename( tmp, name ) == -1)
+    {
+        unlink( tmp );
+        return;
+    }
+    TRACE_(module)( "saved relocated image %s\n", name );
+
+    strcpy( tmp, name );
+    if ((p = strrchr( tmp, '/' )))
+    {
+        *p = 0;
+        trim_reloc_cache( tmp );
+    }
+}
+
+
 /***********************************************************************
  *           map_image
  *
@@ -1071,6 +1276,8 @@ static NTSTATUS map_image( HANDLE hmapping, int fd, char *base, SIZE_T total_siz
     struct stat st;
     struct file_view *view = NULL;
     char *ptr, *header_end, *header_start;
+    char reloc_name[RELOC_CACHE_NAME_MAX];
+    BOOL reloc_cache = FALSE;
     INT_PTR delta = 0;
 
     /* zero-map the whole range */
@@ -1145,6 +1352,27 @@ static NTSTATUS map_image( HANDLE hmapping, int fd, char *base, SIZE_T total_siz
     }
 
 
+    /* use the relocated copy of another process if there is one */
+
+    if (ptr != base &&
+        ((nt->FileHeader.Characteristics & IMAGE_FILE_DLL) ||
+          !NtCurrentTeb()->Peb->ImageBaseAddress) &&
+        !(nt->FileHeader.Characteristics & IMAGE_FILE_RELOCS_STRIPPED))
+    {
+        reloc_cache = TRUE;
+        for (i = 0; i < nt->FileHeader.NumberOfSections; i++)
+            if ((sec[i].Characteristics & IMAGE_SCN_MEM_SHARED) &&
+                (sec[i].Characteristics & IMAGE_SCN_MEM_WRITE)) reloc_cache = FALSE;
+        if (reloc_cache)
+            reloc_cache = get_reloc_cache_name( reloc_name, sizeof(reloc_name), &st, ptr, total_size,
+                                                header_size );
+        if (reloc_cache && map_relocated_image( view, reloc_name ))
+        {
+            delta = ptr - base;
+            goto set_prot;
+        }
+    }
+
     /* map all the sections */
 
     for (i = pos = 0; i < nt->FileHeader.NumberOfSections; i++, sec++)
@@ -1275,10 +1503,12 @@ static NTSTATUS map_image( HANDLE hmapping, int fd, char *base, SIZE_T total_siz
                                              (USHORT *)(rel + 1), delta );
             if (!rel) goto error;
         }
+        if (reloc_cache) save_relocated_image( reloc_name, ptr, total_size );
     }
 
     /* set the image protections */
 
+ set_prot:
     VIRTUAL_SetProt( view, ptr, ROUND_SIZE( 0, header_size ), VPROT_COMMITTED | VPROT_READ );
 
     sec = sections;
@@ -151,6 +151,25 @@ struct progidredirect_data
     ULONG clsid_offset;
 };
 
+/* registry data of an in-process server or handler, cached per process */
+struct class_cache_entry
+{
+    struct list entry;
+    CLSID clsid;
+    DWORD context;                       /* CLSCTX_INPROC_SERVER or CLSCTX_INPROC_HANDLER */
+    HRESULT hr;                          /* result of opening the key */
+    enum comclass_threadingmodel model;
+    DWORD path_ret;                      /* result of reading the dll path */
+    WCHAR dllpath[MAX_PATH+1];
+};
+
+enum class_reg_data_origin
+{
+    CLASS_REG_ACTCTX,
+    CLASS_REG_REGISTRY,
+    CLASS_REG_CACHE
+};
+
 struct class_reg_data
 {
     union
@@ -162,8 +181,9 @@ struct class_reg_data
             HANDLE hactctx;
         } actctx;
         HKEY hkey;
+        const struct class_cache_entry *cache;
     } u;
-    BOOL hkey;
+    enum class_reg_data_origin origin;
 };
 
 struct registered_psclsid
@@ -1372,7 +1392,13 @@ static DWORD COM_RegReadPath(const struct class_reg_data *regdata, WCHAR *dst, D
 {
     DWORD ret;
 
-    if (regdata->hkey)
+    if (regdata->origin == CLASS_REG_CACHE)
+    {
+        if (!(ret = regdata->u.cache->path_ret))
+            lstrcpynW(dst, regdata->u.cache->dllpath, dstlen);
+        return ret;
+    }
+    else if (regdata->origin == CLASS_REG_REGISTRY)
     {
 	DWORD keytype;
 	WCHAR src[MAX_PATH];
@@ -2792,7 +2818,9 @@ HRESULT WINAPI CoRegisterClassObject(
 
 static enum comclass_threadingmodel get_threading_model(const struct class_reg_data *data)
 {
-    if (data->hkey)
+    if (data->origin == CLASS_REG_CACHE)
+        return data->u.cache->model;
+    else if (data->origin == CLASS_REG_REGISTRY)
     {
         static const WCHAR wszThreadingModel[] = {'T','h','r','e','a','d','i','n','g','M','o','d','e','l',0};
         static const WCHAR wszApartment[] = {'A','p','a','r','t','m','e','n','t',0};
@@ -2819,6 +2847,149 @@ static enum comclass_threadingmodel get_threading_model(const struct class_reg_d
         return data->u.actctx.data->model;
 }
 
+/* the registry data of in-process classes is cached until HKCR\CLSID changes */
+#define CLASS_CACHE_MAX 512
+
+static struct list class_cache = LIST_INIT(class_cache);
+static unsigned int class_cache_count;
+static unsigned int class_cache_flushes;  /* number of flushes, to detect races with readers */
+static HKEY class_cache_hkey;             /* HKCR\CLSID, watched for changes */
+static HANDLE class_cache_event;          /* signaled when HKCR\CLSID changes */
+static BOOL class_cache_disabled;
+
+static CRITICAL_SECTION csClassCache;
+static CRITICAL_SECTION_DEBUG class_cache_cs_debug =
+{
+    0, 0, &csClassCache,
+    { &class_cache_cs_debug.ProcessLocksList, &class_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": csClassCache") }
+};
+static CRITICAL_SECTION csClassCache = { &class_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+/* must be called with csClassCache held */
+static void flush_class_cache(void)
+{
+    struct class_cache_entry *entry, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &class_cache, struct class_cache_entry, entry)
+    {
+        list_remove(&entry->entry);
+        HeapFree(GetProcessHeap(), 0, entry);
+    }
+    class_cache_count = 0;
+    class_cache_flushes++;
+}
+
+/* flushes the cache if HKCR\CLSID changed since the last call, returns
+ * FALSE if the key can't be watched, must be called with csClassCache held */
+static BOOL check_class_cache(void)
+{
+    static const WCHAR clsidW[] = {'C','L','S','I','D',0};
+    static const DWORD filter = REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET;
+
+    if (class_cache_disabled) return FALSE;
+
+    if (!class_cache_event)
+    {
+        if (!(class_cache_event = CreateEventW(NULL, FALSE, FALSE, NULL)) ||
+            open_classes_key(HKEY_CLASSES_ROOT, clsidW, KEY_NOTIFY, &class_cache_hkey) ||
+            RegNotifyChangeKeyValue(class_cache_hkey, TRUE, filter, class_cache_event, TRUE))
+        {
+            WARN("can't watch HKCR\\CLSID, not caching class registrations\n");
+            class_cache_disabled = TRUE;
+        }
+        return !class_cache_disabled;
+    }
+
+    if (WaitForSingleObject(class_cache_event, 0) == WAIT_OBJECT_0)
+    {
+        TRACE("HKCR\\CLSID changed, flushing the class cache\n");
+        if (RegNotifyChangeKeyValue(class_cache_hkey, TRUE, filter, class_cache_event, TRUE))
+            class_cache_disabled = TRUE;
+        flush_class_cache();
+    }
+    return !class_cache_disabled;
+}
+
+/* reads the registry data of an in-process class from HKCR\CLSID */
+static void read_class_cache_entry(struct class_cache_entry *entry)
+{
+    static const WCHAR wszInprocServer32[] = {'I','n','p','r','o','c','S','e','r','v','e','r','3','2',0};
+    static const WCHAR wszInprocHandler32[] = {'I','n','p','r','o','c','H','a','n','d','l','e','r','3','2',0};
+    struct class_reg_data regdata;
+    HKEY hkey;
+
+    entry->model = ThreadingModel_No;
+    entry->path_ret = ERROR_FILE_NOT_FOUND;
+    entry->dllpath[0] = 0;
+
+    entry->hr = COM_OpenKeyForCLSID(&entry->clsid, entry->context == CLSCTX_INPROC_SERVER ?
+                                    wszInprocServer32 : wszInprocHandler32, KEY_READ, &hkey);
+    if (FAILED(entry->hr)) return;
+
+    regdata.u.hkey = hkey;
+    regdata.origin = CLASS_REG_REGISTRY;
+    entry->model = get_threading_model(&regdata);
+    entry->path_ret = COM_RegReadPath(&regdata, entry->dllpath, ARRAYSIZE(entry->dllpath));
+    RegCloseKey(hkey);
+}
+
+/* gets a copy of the registry data of an in-process server or handler,
+ * returns the result of opening its key */
+static HRESULT get_class_cache_entry(REFCLSID rclsid, DWORD context, struct class_cache_entry *ret)
+{
+    struct class_cache_entry *entry;
+    unsigned int flushes;
+    BOOL cache;
+
+    EnterCriticalSection(&csClassCache);
+    if ((cache = check_class_cache()))
+    {
+        LIST_FOR_EACH_ENTRY(entry, &class_cache, struct class_cache_entry, entry)
+        {
+            if (entry->context != context || !IsEqualCLSID(&entry->clsid, rclsid)) continue;
+            list_remove(&entry->entry);
+            list_add_head(&class_cache, &entry->entry);
+            *ret = *entry;
+            LeaveCriticalSection(&csClassCache);
+            return ret->hr;
+        }
+    }
+    flushes = class_cache_flushes;
+    LeaveCriticalSection(&csClassCache);
+
+    ret->clsid = *rclsid;
+    ret->context = context;
+    read_class_cache_entry(ret);
+    if (!cache) return ret->hr;
+
+    EnterCriticalSection(&csClassCache);
+    /* don't add the entry if the cache was flushed while we read the registry */
+    if (flushes == class_cache_flushes && (entry = HeapAlloc(GetProcessHeap(), 0, sizeof(*entry))))
+    {
+        *entry = *ret;
+        list_add_head(&class_cache, &entry->entry);
+        if (++class_cache_count > CLASS_CACHE_MAX)
+        {
+            entry = LIST_ENTRY(list_tail(&class_cache), struct class_cache_entry, entry);
+            list_remove(&entry->entry);
+            HeapFree(GetProcessHeap(), 0, entry);
+            class_cache_count--;
+        }
+    }
+    LeaveCriticalSection(&csClassCache);
+    return ret->hr;
+}
+
+/* frees the class cache on process detach */
+static void free_class_cache(void)
+{
+    flush_class_cache();
+    if (class_cache_hkey) RegCloseKey(class_cache_hkey);
+    if (class_cache_event) CloseHandle(class_cache_event);
+    DeleteCriticalSection(&csClassCache);
+}
+
 static HRESULT get_inproc_class_object(APARTMENT *apt, const struct class_reg_data *regdata,
                                        REFCLSID rclsid, REFIID riid,
                                        BOOL hostifnecessary, void **ppv)
@@ -2952,7 +3123,7 @@ HRESULT WINAPI CoGetClassObject(
             clsreg.u.actctx.hactctx = data.hActCtx;
             clsreg.u.actctx.data = data.lpData;
             clsreg.u.actctx.section = data.lpSectionBase;
-            clsreg.hkey = FALSE;
+            clsreg.origin = CLASS_REG_ACTCTX;
 
             hres = get_inproc_class_object(apt, &clsreg, &comclass->clsid, iid, !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
             ReleaseActCtx(data.hActCtx);
@@ -2984,10 +3155,9 @@ HRESULT WINAPI CoGetClassObject(
     /* First try in-process server */
     if (CLSCTX_INPROC_SERVER & dwClsContext)
     {
-        static const WCHAR wszInprocServer32[] = {'I','n','p','r','o','c','S','e','r','v','e','r','3','2',0};
-        HKEY hkey;
+        struct class_cache_entry cached;
 
-        hres = COM_OpenKeyForCLSID(rclsid, wszInprocServer32, KEY_READ, &hkey);
+        hres = get_class_cache_entry(rclsid, CLSCTX_INPROC_SERVER, &cached);
         if (FAILED(hres))
         {
             if (hres == REGDB_E_CLASSNOTREG)
@@ -3001,11 +3171,10 @@ HRESULT WINAPI CoGetClassObject(
 
         if (SUCCEEDED(hres))
         {
-            clsreg.u.hkey = hkey;
-            clsreg.hkey = TRUE;
+            clsreg.u.cache = &cached;
+            clsreg.origin = CLASS_REG_CACHE;
 
             hres = get_inproc_class_object(apt, &clsreg, rclsid, iid, !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
-            RegCloseKey(hkey);
         }
 
         /* return if we got a class, otherwise fall through to one of the
@@ -3020,10 +3189,9 @@ HRESULT WINAPI CoGetClassObject(
     /* Next try in-process handler */
     if (CLSCTX_INPROC_HANDLER & dwClsContext)
     {
-        static const WCHAR wszInprocHandler32[] = {'I','n','p','r','o','c','H','a','n','d','l','e','r','3','2',0};
-        HKEY hkey;
+        struct class_cache_entry cached;
 
-        hres = COM_OpenKeyForCLSID(rclsid, wszInprocHandler32, KEY_READ, &hkey);
+        hres = get_class_cache_entry(rclsid, CLSCTX_INPROC_HANDLER, &cached);
         if (FAILED(hres))
         {
             if (hres == REGDB_E_CLASSNOTREG)
@@ -3037,11 +3205,10 @@ HRESULT WINAPI CoGetClassObject(
 
         if (SUCCEEDED(hres))
         {
-            clsreg.u.hkey = hkey;
-            clsreg.hkey = TRUE;
+            clsreg.u.cache = &cached;
+            clsreg.origin = CLASS_REG_CACHE;
 
             hres = get_inproc_class_object(apt, &clsreg, rclsid, iid, !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
-            RegCloseKey(hkey);
         }
 
         /* return if we got a class, otherwise fall through to one of the
@@ -4807,7 +4974,7 @@ HRESULT Handler_DllGetClassObject(REFCLSID rclsid, REFIID riid, LPVOID *ppv)
         WCHAR dllpath[MAX_PATH+1];
 
         regdata.u.hkey = hkey;
-        regdata.hkey = TRUE;
+        regdata.origin = CLASS_REG_REGISTRY;
 
         if (COM_RegReadPath(&regdata, dllpath, ARRAYSIZE(dllpath)) == ERROR_SUCCESS)
         {
@@ -4844,6 +5011,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID reserved)
         UnregisterClassW( wszAptWinClass, hProxyDll );
         RPC_UnregisterAllChannelHooks();
         COMPOBJ_DllList_Free();
+        free_class_cache();
         DeleteCriticalSection(&csRegisteredClassList);
         DeleteCriticalSection(&csApartment);
 	break;
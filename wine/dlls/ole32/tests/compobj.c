@@ -54,6 +54,7 @@ static void   (WINAPI *pReleaseActCtx)(HANDLE);
 #define ok_no_locks() ok(cLocks == 0, "Number of locks should be 0, but actually is %d\n", cLocks)
 
 static const CLSID CLSID_non_existent =   { 0x12345678, 0x1234, 0x1234, { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0 } };
+static const CLSID CLSID_cache_test =     { 0x12345678, 0x1234, 0x1234, { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf1 } };
 static const CLSID CLSID_StdFont = { 0x0be35203, 0x8f91, 0x11ce, { 0x9d, 0xe3, 0x00, 0xaa, 0x00, 0x4b, 0xb8, 0x51 } };
 static const GUID IID_Testiface = { 0x22222222, 0x1234, 0x1234, { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0 } };
 static const GUID IID_Testiface2 = { 0x32222222, 0x1234, 0x1234, { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0 } };
@@ -586,6 +587,79 @@ static void test_CoCreateInstance(void)
     CloseHandle(info.stop);
 }
 
+static void test_CoCreateInstance_cache(void)
+{
+    static const char keyA[] = "CLSID\\{12345678-1234-1234-1234-56789abcdef1}";
+    static const char ole32A[] = "ole32.dll";
+    IUnknown *pUnk;
+    DWORD start, i;
+    HRESULT hr;
+    HKEY hkey;
+    LONG res;
+
+    CoInitialize(NULL);
+
+    /* registry changes must be seen by the next activation */
+    hr = CoCreateInstance(&CLSID_cache_test, NULL, CLSCTX_INPROC_SERVER, &IID_IUnknown, (void **)&pUnk);
+    ok(hr == REGDB_E_CLASSNOTREG, "expected REGDB_E_CLASSNOTREG, got 0x%08x\n", hr);
+
+    res = RegCreateKeyExA(HKEY_CLASSES_ROOT, keyA, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &hkey, NULL);
+    if (res == ERROR_ACCESS_DENIED)
+    {
+        skip("not enough rights to register a class\n");
+        CoUninitialize();
+        return;
+    }
+    ok(!res, "RegCreateKeyEx returned %d\n", res);
+    RegCloseKey(hkey);
+
+    hr = CoCreateInstance(&CLSID_cache_test, NULL, CLSCTX_INPROC_SERVER, &IID_IUnknown, (void **)&pUnk);
+    ok(hr == REGDB_E_CLASSNOTREG, "expected REGDB_E_CLASSNOTREG, got 0x%08x\n", hr);
+
+    res = RegCreateKeyExA(HKEY_CLASSES_ROOT, "CLSID\\{12345678-1234-1234-1234-56789abcdef1}\\InprocServer32",
+                          0, NULL, 0, KEY_ALL_ACCESS, NULL, &hkey, NULL);
+    ok(!res, "RegCreateKeyEx returned %d\n", res);
+    res = RegSetValueExA(hkey, NULL, 0, REG_SZ, (const BYTE *)ole32A, sizeof(ole32A));
+    ok(!res, "RegSetValueEx returned %d\n", res);
+    RegCloseKey(hkey);
+
+    pUnk = NULL;
+    hr = CoCreateInstance(&CLSID_cache_test, NULL, CLSCTX_INPROC_SERVER, &IID_IUnknown, (void **)&pUnk);
+    ok(hr != REGDB_E_CLASSNOTREG, "new registration was not seen\n");
+    if (SUCCEEDED(hr)) IUnknown_Release(pUnk);
+
+    res = RegDeleteKeyA(HKEY_CLASSES_ROOT, "CLSID\\{12345678-1234-1234-1234-56789abcdef1}\\InprocServer32");
+    ok(!res, "RegDeleteKey returned %d\n", res);
+    res = RegDeleteKeyA(HKEY_CLASSES_ROOT, keyA);
+    ok(!res, "RegDeleteKey returned %d\n", res);
+
+    hr = CoCreateInstance(&CLSID_cache_test, NULL, CLSCTX_INPROC_SERVER, &IID_IUnknown, (void **)&pUnk);
+    ok(hr == REGDB_E_CLASSNOTREG, "expected REGDB_E_CLASSNOTREG, got 0x%08x\n", hr);
+
+    /* activation throughput */
+    hr = CoCreateInstance(&CLSID_InternetZoneManager, NULL, CLSCTX_INPROC_SERVER, &IID_IUnknown, (void **)&pUnk);
+    if (hr == REGDB_E_CLASSNOTREG)
+    {
+        skip("IE not installed so can't time CoCreateInstance\n");
+        CoUninitialize();
+        return;
+    }
+    ok_ole_success(hr, "CoCreateInstance");
+    IUnknown_Release(pUnk);
+
+    start = GetTickCount();
+    for (i = 0; i < 10000; i++)
+    {
+        hr = CoCreateInstance(&CLSID_InternetZoneManager, NULL, CLSCTX_INPROC_SERVER, &IID_IUnknown, (void **)&pUnk);
+        if (FAILED(hr)) break;
+        IUnknown_Release(pUnk);
+    }
+    ok_ole_success(hr, "CoCreateInstance");
+    trace("%u CoCreateInstance calls took %u ms\n", i, GetTickCount() - start);
+
+    CoUninitialize();
+}
+
 static void test_CoGetClassObject(void)
 {
     HRESULT hr;
@@ -1946,6 +2020,7 @@ START_TEST(compobj)
     test_CLSIDFromString();
     test_StringFromGUID2();
     test_CoCreateInstance();
+    test_CoCreateInstance_cache();
     test_ole_menu();
     test_CoGetClassObject();
     test_CoRegisterMessageFilter();
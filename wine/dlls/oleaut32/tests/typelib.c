@@ -4356,6 +4356,90 @@ static void test_SetFuncAndParamNames(void)
     DeleteFileA(filenameA);
 }
 
+static void test_GetIDsOfNames_many(void)
+{
+    static OLECHAR nameW[] = {'n','a','m','e',0};
+    CHAR filenameA[MAX_PATH];
+    WCHAR filenameW[MAX_PATH], func[16];
+    OLECHAR *names[1];
+    ICreateTypeLib2 *ctl;
+    ICreateTypeInfo *cti;
+    ITypeLib *tl;
+    ITypeInfo *ti;
+    FUNCDESC funcdesc;
+    MEMBERID memid;
+    DWORD start;
+    HRESULT hr;
+    int i, j;
+
+    GetTempFileNameA(".", "tlb", 0, filenameA);
+    MultiByteToWideChar(CP_ACP, 0, filenameA, -1, filenameW, MAX_PATH);
+
+    hr = CreateTypeLib2(SYS_WIN32, filenameW, &ctl);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    hr = ICreateTypeLib2_CreateTypeInfo(ctl, nameW, TKIND_DISPATCH, &cti);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    memset(&funcdesc, 0, sizeof(FUNCDESC));
+    funcdesc.funckind = FUNC_DISPATCH;
+    funcdesc.invkind = INVOKE_FUNC;
+    funcdesc.callconv = CC_STDCALL;
+    funcdesc.elemdescFunc.tdesc.vt = VT_VOID;
+
+    /* enough members for the names to be indexed */
+    names[0] = func;
+    for (i = 0; i < 40; i++)
+    {
+        static const WCHAR fmtW[] = {'f','u','n','c','%','d',0};
+
+        funcdesc.memid = 0x100 + i;
+        hr = ICreateTypeInfo_AddFuncDesc(cti, i, &funcdesc);
+        ok(hr == S_OK, "%d: got 0x%08x\n", i, hr);
+        wsprintfW(func, fmtW, i);
+        hr = ICreateTypeInfo_SetFuncAndParamNames(cti, i, names, 1);
+        ok(hr == S_OK, "%d: got 0x%08x\n", i, hr);
+    }
+
+    hr = ICreateTypeLib2_SaveAllChanges(ctl);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ICreateTypeInfo_Release(cti);
+    ICreateTypeLib2_Release(ctl);
+
+    hr = LoadTypeLibEx(filenameW, REGKIND_NONE, &tl);
+    ok(hr == S_OK, "got %08x\n", hr);
+    hr = ITypeLib_GetTypeInfo(tl, 0, &ti);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    for (i = 0; i < 40; i++)
+    {
+        static const WCHAR fmtW[] = {'F','u','N','c','%','d',0};
+
+        wsprintfW(func, fmtW, i);
+        memid = MEMBERID_NIL;
+        hr = ITypeInfo_GetIDsOfNames(ti, names, 1, &memid);
+        ok(hr == S_OK, "%d: got 0x%08x\n", i, hr);
+        ok(memid == 0x100 + i, "%d: got memid 0x%x\n", i, memid);
+    }
+
+    start = GetTickCount();
+    for (i = 0; i < 2500; i++)
+    {
+        static const WCHAR fmtW[] = {'f','u','n','c','%','d',0};
+
+        for (j = 0; j < 40; j++)
+        {
+            wsprintfW(func, fmtW, j);
+            ITypeInfo_GetIDsOfNames(ti, names, 1, &memid);
+        }
+    }
+    trace("100000 GetIDsOfNames calls took %u ms\n", GetTickCount() - start);
+
+    ITypeInfo_Release(ti);
+    ITypeLib_Release(tl);
+    DeleteFileA(filenameA);
+}
+
 static void test_SetDocString(void)
 {
     static OLECHAR nameW[] = {'n','a','m','e',0};
@@ -5240,6 +5324,7 @@ START_TEST(typelib)
     test_inheritance();
     test_SetVarHelpContext();
     test_SetFuncAndParamNames();
+    test_GetIDsOfNames_many();
     test_SetDocString();
     test_FindName();
 
@@ -1104,6 +1104,11 @@ typedef struct tagITypeLibImpl
     struct list ref_list;       /* list of ref types in this typelib */
     HREFTYPE dispatch_href;     /* reference to IDispatch, -1 if unused */
 
+    /* MSFT typelibs read the functions and variables of a typeinfo on first use */
+    IUnknown *file;             /* keeps the typelib data mapped */
+    void *data;                 /* typelib data */
+    DWORD data_length;
+    MSFT_SegDir segdir;
 
     /* typelibs are cached, keyed by path and index, so store the linked list info within them */
     struct list entry;
@@ -1136,7 +1141,7 @@ static inline ITypeLibImpl *impl_from_ICreateTypeLib2( ICreateTypeLib2 *iface )
 }
 
 /* ITypeLib methods */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength);
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *file);
 static ITypeLib2* ITypeLib2_Constructor_SLTG(LPVOID pLib, DWORD dwTLBLength);
 
 /*======================= ITypeInfo implementation =======================*/
@@ -1205,6 +1210,17 @@ typedef struct tagTLBImplType
     struct list custdata_list;
 } TLBImplType;
 
+/* hash index of the function and variable names, for GetIDsOfNames */
+typedef struct tagTLBNameIndex
+{
+    UINT mask;              /* number of slots - 1 */
+    struct
+    {
+        ULONG hash;
+        int member;         /* function index, cFuncs + variable index, or -1 if free */
+    } slots[1];
+} TLBNameIndex;
+
 /* internal TypeInfo data */
 typedef struct tagITypeInfoImpl
 {
@@ -1255,6 +1271,10 @@ typedef struct tagITypeInfoImpl
     /* Implemented Interfaces  */
     TLBImplType *impltypes;
 
+    LONG members_offset;        /* offset of the MSFT functions and variables not read yet, or -1 */
+    TLBNameIndex *name_index;   /* built on first GetIDsOfNames */
+    BOOL no_name_index;         /* the typeinfo may be modified through ICreateTypeInfo */
+
     struct list *pcustdata_list;
     struct list custdata_list;
 } ITypeInfoImpl;
@@ -1618,9 +1638,12 @@ static void dump_TypeInfo(const ITypeInfoImpl * pty)
     TRACE("wTypeFlags: 0x%04x\n", pty->wTypeFlags);
     TRACE("parent tlb:%p index in TLB:%u\n",pty->pTypeLib, pty->index);
     if (pty->typekind == TKIND_MODULE) TRACE("dllname:%s\n", debugstr_w(TLB_get_bstr(pty->DllName)));
-    if (TRACE_ON(ole))
-        dump_TLBFuncDesc(pty->funcdescs, pty->cFuncs);
-    dump_TLBVarDesc(pty->vardescs, pty->cVars);
+    if (pty->members_offset == -1)
+    {
+        if (TRACE_ON(ole))
+            dump_TLBFuncDesc(pty->funcdescs, pty->cFuncs);
+        dump_TLBVarDesc(pty->vardescs, pty->cVars);
+    }
     dump_TLBImplType(pty->impltypes, pty->cImplTypes);
 }
 
@@ -2789,16 +2812,20 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
 /* note: InfoType's Help file and HelpStringDll come from the containing
  * library. Further HelpString and Docstring appear to be the same thing :(
  */
-    /* functions */
-    if(ptiRet->cFuncs >0 )
-        MSFT_DoFuncs(pcx, ptiRet, ptiRet->cFuncs,
-		    ptiRet->cVars,
-		    tiBase.memoffset, &ptiRet->funcdescs);
-    /* variables */
-    if(ptiRet->cVars >0 )
-        MSFT_DoVars(pcx, ptiRet, ptiRet->cFuncs,
-		   ptiRet->cVars,
-		   tiBase.memoffset, &ptiRet->vardescs);
+    /* functions and variables, read on first use when the data stays mapped */
+    if(pLibInfo->file && (ptiRet->cFuncs || ptiRet->cVars))
+        ptiRet->members_offset = tiBase.memoffset;
+    else
+    {
+        if(ptiRet->cFuncs >0 )
+            MSFT_DoFuncs(pcx, ptiRet, ptiRet->cFuncs,
+                        ptiRet->cVars,
+                        tiBase.memoffset, &ptiRet->funcdescs);
+        if(ptiRet->cVars >0 )
+            MSFT_DoVars(pcx, ptiRet, ptiRet->cFuncs,
+                       ptiRet->cVars,
+                       tiBase.memoffset, &ptiRet->vardescs);
+    }
     if(ptiRet->cImplTypes >0 ) {
         switch(ptiRet->typekind)
         {
@@ -2837,6 +2864,140 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
     return ptiRet;
 }
 
+static CRITICAL_SECTION members_section;
+static CRITICAL_SECTION_DEBUG members_section_debug =
+{
+    0, 0, &members_section,
+    { &members_section_debug.ProcessLocksList, &members_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": members_section") }
+};
+static CRITICAL_SECTION members_section = { &members_section_debug, -1, 0, 0, 0, 0 };
+
+/* read the functions and variables of an MSFT typeinfo if not done yet */
+static void TLB_load_members(ITypeInfoImpl *info)
+{
+    ITypeLibImpl *lib = info->pTypeLib;
+    TLBContext cx;
+
+    if (info->members_offset == -1) return;
+
+    EnterCriticalSection(&members_section);
+    if (info->members_offset != -1)
+    {
+        TRACE_(typelib)("reading members of %s\n", debugstr_w(TLB_get_bstr(info->Name)));
+        cx.oStart = 0;
+        cx.pos = 0;
+        cx.length = lib->data_length;
+        cx.mapping = lib->data;
+        cx.pTblDir = &lib->segdir;
+        cx.pLibInfo = lib;
+        if (info->cFuncs)
+            MSFT_DoFuncs(&cx, info, info->cFuncs, info->cVars, info->members_offset, &info->funcdescs);
+        if (info->cVars)
+            MSFT_DoVars(&cx, info, info->cFuncs, info->cVars, info->members_offset, &info->vardescs);
+        InterlockedExchange(&info->members_offset, -1);
+    }
+    LeaveCriticalSection(&members_section);
+}
+
+/* read the members of all the typeinfos before the typelib is modified,
+ * the file is no longer needed then and can be written by SaveAllChanges */
+static void TLB_load_all_members(ITypeLibImpl *lib)
+{
+    IUnknown *file;
+    int i;
+
+    if (!lib->file) return;
+
+    for (i = 0; i < lib->TypeInfoCount; i++)
+        TLB_load_members(lib->typeinfos[i]);
+
+    EnterCriticalSection(&members_section);
+    file = lib->file;
+    lib->file = NULL;
+    lib->data = NULL;
+    LeaveCriticalSection(&members_section);
+
+    if (file) IUnknown_Release(file);
+}
+
+static ULONG TLB_hash_name(const WCHAR *name)
+{
+    ULONG hash = 0;
+
+    while (*name) hash = hash * 31 + toupperW(*name++);
+    return hash;
+}
+
+static const TLBString *TLB_get_member_name(const ITypeInfoImpl *info, int member)
+{
+    if (member < info->cFuncs) return info->funcdescs[member].Name;
+    return info->vardescs[member - info->cFuncs].Name;
+}
+
+/* build the name index of a typeinfo, small typeinfos are searched linearly */
+static TLBNameIndex *TLB_get_name_index(ITypeInfoImpl *info)
+{
+    TLBNameIndex *index;
+    UINT i, size = 32, count = info->cFuncs + info->cVars;
+    int member;
+
+    if (info->name_index || info->no_name_index || count < 16) return info->name_index;
+
+    while (size < 2 * count) size *= 2;
+    if (!(index = heap_alloc(FIELD_OFFSET(TLBNameIndex, slots[size])))) return NULL;
+    index->mask = size - 1;
+    for (i = 0; i < size; i++) index->slots[i].member = -1;
+
+    /* only the first member with a given name is indexed, functions come first */
+    for (member = 0; member < count; member++)
+    {
+        const WCHAR *name = TLB_get_bstr(TLB_get_member_name(info, member));
+        ULONG hash;
+
+        if (!name) continue;
+        hash = TLB_hash_name(name);
+        for (i = hash & index->mask; index->slots[i].member != -1; i = (i + 1) & index->mask)
+            if (index->slots[i].hash == hash &&
+                !lstrcmpiW(TLB_get_bstr(TLB_get_member_name(info, index->slots[i].member)), name))
+                break;
+        if (index->slots[i].member != -1) continue;
+        index->slots[i].hash = hash;
+        index->slots[i].member = member;
+    }
+
+    if (InterlockedCompareExchangePointer((void **)&info->name_index, index, NULL))
+        heap_free(index);
+    return info->name_index;
+}
+
+/* find the first function, or else variable, with a given name; returns the
+ * function index, cFuncs + the variable index, or -1 */
+static int TLB_find_member_by_name(ITypeInfoImpl *info, const WCHAR *name)
+{
+    const TLBFuncDesc *func;
+    const TLBVarDesc *var;
+    TLBNameIndex *index;
+    ULONG hash;
+    UINT i;
+
+    if (!name || !(index = TLB_get_name_index(info)))
+    {
+        if ((func = TLB_get_funcdesc_by_name(info->funcdescs, info->cFuncs, name)))
+            return func - info->funcdescs;
+        if ((var = TLB_get_vardesc_by_name(info->vardescs, info->cVars, name)))
+            return info->cFuncs + (var - info->vardescs);
+        return -1;
+    }
+
+    hash = TLB_hash_name(name);
+    for (i = hash & index->mask; index->slots[i].member != -1; i = (i + 1) & index->mask)
+        if (index->slots[i].hash == hash &&
+            !lstrcmpiW(TLB_get_bstr(TLB_get_member_name(info, index->slots[i].member)), name))
+            return index->slots[i].member;
+    return -1;
+}
+
 static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
 {
     char *string;
@@ -3331,7 +3492,9 @@ static HRESULT TLB_Mapping_Open(LPCWSTR path, LPVOID *ppBase, DWORD *pdwTLBLengt
     This->mapping = NULL;
     This->typelib_base = NULL;
 
-    This->file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0);
+    /* MSFT typelibs keep the file mapped until their members are read, let
+     * it be deleted or replaced by renaming in the meantime */
+    This->file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, 0);
     if (INVALID_HANDLE_VALUE != This->file)
     {
         This->mapping = CreateFileMappingW(This->file, NULL, PAGE_READONLY | SEC_COMMIT, 0, 0, NULL);
@@ -3452,7 +3615,7 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
         {
             DWORD dwSignature = FromLEDWord(*((DWORD*) pBase));
             if (dwSignature == MSFT_SIGNATURE)
-                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength);
+                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength, pFile);
             else if (dwSignature == SLTG_SIGNATURE)
                 *ppTypeLib = ITypeLib2_Constructor_SLTG(pBase, dwTLBLength);
             else
@@ -3523,7 +3686,7 @@ static ITypeLibImpl* TypeLibImpl_Constructor(void)
  *
  * loading an MSFT typelib from an in-memory image
  */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *file)
 {
     TLBContext cx;
     LONG lPSegDir;
@@ -3712,6 +3875,17 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
 
     pTypeLibImpl->dispatch_href = tlbHeader.dispatchpos;
 
+    /* the members of the type infos are read on first use, the file stays
+     * open for reading until then, or until ICreateTypeLib2 is requested */
+    if (file && tlbHeader.nrtypeinfos > 0)
+    {
+        IUnknown_AddRef(file);
+        pTypeLibImpl->file = file;
+        pTypeLibImpl->data = pLib;
+        pTypeLibImpl->data_length = dwTLBLength;
+        pTypeLibImpl->segdir = tlbSegDir;
+    }
+
     /* type infos */
     if(tlbHeader.nrtypeinfos >= 0 )
     {
@@ -4775,6 +4949,7 @@ static HRESULT WINAPI ITypeLib2_fnQueryInterface(ITypeLib2 *iface, REFIID riid,
     else if(IsEqualIID(riid, &IID_ICreateTypeLib) ||
              IsEqualIID(riid, &IID_ICreateTypeLib2))
     {
+        TLB_load_all_members(This);
         *ppv = &This->ICreateTypeLib2_iface;
     }
     else
@@ -4851,6 +5026,9 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
 
       heap_free(This->pTypeDesc);
 
+      if (This->file)
+          IUnknown_Release(This->file);
+
       LIST_FOR_EACH_ENTRY_SAFE(pImpLib, pImpLibNext, &This->implib_list, TLBImpLib, entry)
       {
           if (pImpLib->pImpTypeLib)
@@ -5126,6 +5304,7 @@ static HRESULT WINAPI ITypeLib2_fnIsName(
     *pfName=TRUE;
     for(tic = 0; tic < This->TypeInfoCount; ++tic){
         ITypeInfoImpl *pTInfo = This->typeinfos[tic];
+        TLB_load_members(pTInfo);
         if(!TLB_str_memcmp(szNameBuf, pTInfo->Name, nNameBufLen)) goto ITypeLib2_fnIsName_exit;
         for(fdc = 0; fdc < pTInfo->cFuncs; ++fdc) {
             TLBFuncDesc *pFInfo = &pTInfo->funcdescs[fdc];
@@ -5181,6 +5360,7 @@ static HRESULT WINAPI ITypeLib2_fnFindName(
         TLBVarDesc *var;
         UINT fdc;
 
+        TLB_load_members(pTInfo);
         if(!TLB_str_memcmp(name, pTInfo->Name, len)) goto ITypeLib2_fnFindName_exit;
         for(fdc = 0; fdc < pTInfo->cFuncs; ++fdc) {
             TLBFuncDesc *func = &pTInfo->funcdescs[fdc];
@@ -5612,6 +5792,7 @@ static ITypeInfoImpl* ITypeInfoImpl_Constructor(void)
       pTypeInfoImpl->hreftype = -1;
       pTypeInfoImpl->memidConstructor = MEMBERID_NIL;
       pTypeInfoImpl->memidDestructor = MEMBERID_NIL;
+      pTypeInfoImpl->members_offset = -1;
       pTypeInfoImpl->pcustdata_list = &pTypeInfoImpl->custdata_list;
       list_init(pTypeInfoImpl->pcustdata_list);
     }
@@ -5637,7 +5818,12 @@ static HRESULT WINAPI ITypeInfo_fnQueryInterface(
         *ppvObject = This;
     else if(IsEqualIID(riid, &IID_ICreateTypeInfo) ||
              IsEqualIID(riid, &IID_ICreateTypeInfo2))
+    {
+        TLB_load_members(This);
+        This->no_name_index = TRUE;
+        heap_free(InterlockedExchangePointer((void **)&This->name_index, NULL));
         *ppvObject = &This->ICreateTypeInfo2_iface;
+    }
 
     if(*ppvObject){
         ITypeInfo2_AddRef(iface);
@@ -5669,7 +5855,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TRACE("destroying ITypeInfo(%p)\n",This);
 
-    for (i = 0; i < This->cFuncs; ++i)
+    for (i = 0; This->funcdescs && i < This->cFuncs; ++i)
     {
         int j;
         TLBFuncDesc *pFInfo = &This->funcdescs[i];
@@ -5686,7 +5872,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
     }
     heap_free(This->funcdescs);
 
-    for(i = 0; i < This->cVars; ++i)
+    for(i = 0; This->vardescs && i < This->cVars; ++i)
     {
         TLBVarDesc *pVInfo = &This->vardescs[i];
         if (pVInfo->vardesc_create) {
@@ -5709,6 +5895,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TLB_FreeCustData(&This->custdata_list);
 
+    heap_free(This->name_index);
     heap_free(This);
 }
 
@@ -5975,6 +6162,7 @@ HRESULT ITypeInfoImpl_GetInternalFuncDesc( ITypeInfo *iface, UINT index, const F
     if (index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
     *ppFuncDesc = &This->funcdescs[index].funcdesc;
     return S_OK;
 }
@@ -6164,13 +6352,16 @@ static HRESULT WINAPI ITypeInfo_fnGetVarDesc( ITypeInfo2 *iface, UINT index,
         LPVARDESC  *ppVarDesc)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    const TLBVarDesc *pVDesc = &This->vardescs[index];
+    const TLBVarDesc *pVDesc;
 
     TRACE("(%p) index %d\n", This, index);
 
     if(index >= This->cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pVDesc = &This->vardescs[index];
+
     if (This->needs_layout)
         ICreateTypeInfo2_LayOut(&This->ICreateTypeInfo2_iface);
 
@@ -6197,6 +6388,7 @@ static HRESULT WINAPI ITypeInfo_fnGetNames( ITypeInfo2 *iface, MEMBERID memid,
 
     *pcNames = 0;
 
+    TLB_load_members(This);
     pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
     if(pFDesc)
     {
@@ -6345,9 +6537,9 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
         LPOLESTR  *rgszNames, UINT cNames, MEMBERID  *pMemId)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    const TLBVarDesc *pVDesc;
     HRESULT ret=S_OK;
-    UINT i, fdc;
+    UINT i;
+    int member;
 
     TRACE("(%p) Name %s cNames %d\n", This, debugstr_w(*rgszNames),
             cNames);
@@ -6356,28 +6548,27 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
-    for (fdc = 0; fdc < This->cFuncs; ++fdc) {
+    TLB_load_members(This);
+    member = TLB_find_member_by_name(This, *rgszNames);
+    if (member != -1 && member < This->cFuncs) {
         int j;
-        const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
-        if(!lstrcmpiW(*rgszNames, TLB_get_bstr(pFDesc->Name))) {
-            if(cNames) *pMemId=pFDesc->funcdesc.memid;
-            for(i=1; i < cNames; i++){
-                for(j=0; j<pFDesc->funcdesc.cParams; j++)
-                    if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
-                            break;
-                if( j<pFDesc->funcdesc.cParams)
-                    pMemId[i]=j;
-                else
-                   ret=DISP_E_UNKNOWNNAME;
-            };
-            TRACE("-- 0x%08x\n", ret);
-            return ret;
-        }
+        const TLBFuncDesc *pFDesc = &This->funcdescs[member];
+        if(cNames) *pMemId=pFDesc->funcdesc.memid;
+        for(i=1; i < cNames; i++){
+            for(j=0; j<pFDesc->funcdesc.cParams; j++)
+                if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
+                        break;
+            if( j<pFDesc->funcdesc.cParams)
+                pMemId[i]=j;
+            else
+               ret=DISP_E_UNKNOWNNAME;
+        };
+        TRACE("-- 0x%08x\n", ret);
+        return ret;
     }
-    pVDesc = TLB_get_vardesc_by_name(This->vardescs, This->cVars, *rgszNames);
-    if(pVDesc){
+    if (member != -1) {
         if(cNames)
-            *pMemId = pVDesc->vardesc.memid;
+            *pMemId = This->vardescs[member - This->cFuncs].vardesc.memid;
         return ret;
     }
     /* not found, see if it can be found in an inherited interface */
@@ -6972,6 +7163,8 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
         return E_INVALIDARG;
     }
 
+    TLB_load_members(This);
+
     /* we do this instead of using GetFuncDesc since it will return a fake
      * FUNCDESC for dispinterfaces and we want the real function description */
     for (fdc = 0; fdc < This->cFuncs; ++fdc){
@@ -7490,6 +7683,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDocumentation( ITypeInfo2 *iface,
             *pBstrHelpFile=SysAllocString(TLB_get_bstr(This->pTypeLib->HelpFile));
         return S_OK;
     }else {/* for a member */
+        TLB_load_members(This);
         pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
         if(pFDesc){
             if(pBstrName)
@@ -7556,6 +7750,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDllEntry( ITypeInfo2 *iface, MEMBERID memid
     if (This->typekind != TKIND_MODULE)
         return TYPE_E_BADMODULEKIND;
 
+    TLB_load_members(This);
     pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
     if(pFDesc){
 	    dump_TypeInfo(This);
@@ -7642,8 +7837,11 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
         */
         pTypeInfoImpl = ITypeInfoImpl_Constructor();
 
+        TLB_load_members(This);
         *pTypeInfoImpl = *This;
         pTypeInfoImpl->ref = 0;
+        pTypeInfoImpl->name_index = NULL;
+        pTypeInfoImpl->no_name_index = TRUE;
         list_init(&pTypeInfoImpl->custdata_list);
 
         if (This->typekind == TKIND_INTERFACE)
@@ -7982,6 +8180,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncIndexOfMemId( ITypeInfo2 * iface,
     UINT fdc;
     HRESULT result;
 
+    TLB_load_members(This);
     for (fdc = 0; fdc < This->cFuncs; ++fdc){
         const TLBFuncDesc *pFuncInfo = &This->funcdescs[fdc];
         if(memid == pFuncInfo->funcdesc.memid && (invKind & pFuncInfo->funcdesc.invkind))
@@ -8012,6 +8211,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetVarIndexOfMemId( ITypeInfo2 * iface,
 
     TRACE("%p %d %p\n", iface, memid, pVarIndex);
 
+    TLB_load_members(This);
     pVarInfo = TLB_get_vardesc_by_memberid(This->vardescs, This->cVars, memid);
     if(!pVarInfo)
         return TYPE_E_ELEMENTNOTFOUND;
@@ -8060,13 +8260,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBFuncDesc *pFDesc = &This->funcdescs[index];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %s %p\n", This, index, debugstr_guid(guid), pVarVal);
 
     if(index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pFDesc = &This->funcdescs[index];
+
     pCData = TLB_get_custdata_by_guid(&pFDesc->custdata_list, guid);
     if(!pCData)
         return TYPE_E_ELEMENTNOTFOUND;
@@ -8090,7 +8293,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetParamCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBFuncDesc *pFDesc = &This->funcdescs[indexFunc];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %u %s %p\n", This, indexFunc, indexParam,
             debugstr_guid(guid), pVarVal);
@@ -8098,6 +8301,9 @@ static HRESULT WINAPI ITypeInfo2_fnGetParamCustData(
     if(indexFunc >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pFDesc = &This->funcdescs[indexFunc];
+
     if(indexParam >= pFDesc->funcdesc.cParams)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -8123,13 +8329,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetVarCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBVarDesc *pVDesc = &This->vardescs[index];
+    TLBVarDesc *pVDesc;
 
     TRACE("%p %s %p\n", This, debugstr_guid(guid), pVarVal);
 
     if(index >= This->cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pVDesc = &This->vardescs[index];
+
     pCData = TLB_get_custdata_by_guid(&pVDesc->custdata_list, guid);
     if(!pCData)
         return TYPE_E_ELEMENTNOTFOUND;
@@ -8205,6 +8414,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetDocumentation2(
                 SysAllocString(TLB_get_bstr(This->pTypeLib->HelpStringDll));/* FIXME */
         return S_OK;
     }else {/* for a member */
+        TLB_load_members(This);
         pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
         if(pFDesc){
             if(pbstrHelpString)
@@ -8258,13 +8468,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllFuncCustData(
 	CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBFuncDesc *pFDesc = &This->funcdescs[index];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %p\n", This, index, pCustData);
 
     if(index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pFDesc = &This->funcdescs[index];
+
     return TLB_copy_all_custdata(&pFDesc->custdata_list, pCustData);
 }
 
@@ -8277,13 +8490,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllParamCustData( ITypeInfo2 * iface,
     UINT indexFunc, UINT indexParam, CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBFuncDesc *pFDesc = &This->funcdescs[indexFunc];
+    TLBFuncDesc *pFDesc;
 
     TRACE("%p %u %u %p\n", This, indexFunc, indexParam, pCustData);
 
     if(indexFunc >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pFDesc = &This->funcdescs[indexFunc];
+
     if(indexParam >= pFDesc->funcdesc.cParams)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -8299,13 +8515,16 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllVarCustData( ITypeInfo2 * iface,
     UINT index, CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBVarDesc * pVDesc = &This->vardescs[index];
+    TLBVarDesc * pVDesc;
 
     TRACE("%p %u %p\n", This, index, pCustData);
 
     if(index >= This->cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_load_members(This);
+    pVDesc = &This->vardescs[index];
+
     return TLB_copy_all_custdata(&pVDesc->custdata_list, pCustData);
 }
 
@@ -8539,6 +8758,7 @@ static HRESULT WINAPI ITypeComp_fnBind(
     pBindPtr->lpfuncdesc = NULL;
     *ppTInfo = NULL;
 
+    TLB_load_members(This);
     for(fdc = 0; fdc < This->cFuncs; ++fdc){
         pFDesc = &This->funcdescs[fdc];
         if (!lstrcmpiW(TLB_get_bstr(pFDesc->Name), szName)) {
@@ -8720,6 +8940,7 @@ static HRESULT WINAPI ICreateTypeLib2_fnCreateTypeInfo(ICreateTypeLib2 *iface,
     info->index = This->TypeInfoCount;
     info->typekind = kind;
     info->cbAlignment = 4;
+    info->no_name_index = TRUE;
 
     switch(info->typekind) {
     case TKIND_ENUM:
@@ -9913,6 +10134,9 @@ static HRESULT WINAPI ICreateTypeLib2_fnSaveAllChanges(ICreateTypeLib2 *iface)
 
     TRACE("%p\n", This);
 
+    for(i = 0; i < This->TypeInfoCount; ++i)
+        TLB_load_members(This->typeinfos[i]);
+
     for(i = 0; i < This->TypeInfoCount; ++i)
         if(This->typeinfos[i]->needs_layout)
             ICreateTypeInfo2_LayOut(&This->typeinfos[i]->ICreateTypeInfo2_iface);
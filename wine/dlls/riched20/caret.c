@@ -371,7 +371,7 @@ BOOL ME_InternalDeleteText(ME_TextEditor *editor, ME_Cursor *start,
 
       c.nOffset -= nCharsToDelete;
 
-      ME_FindItemBack(c.pRun, diParagraph)->member.para.nFlags |= MEPF_REWRAP;
+      ME_MarkForWrapping(editor, ME_FindItemBack(c.pRun, diParagraph));
 
       cursor = c;
       /* nChars is the number of characters that should be deleted from the
@@ -931,7 +931,7 @@ static BOOL ME_FindRunInRow(ME_TextEditor *editor, ME_DisplayItem *pRow,
 static BOOL ME_FindPixelPos(ME_TextEditor *editor, int x, int y,
                             ME_Cursor *result, BOOL *is_eol)
 {
-  ME_DisplayItem *p = editor->pBuffer->pFirst->member.para.next_para;
+  ME_DisplayItem *p;
   BOOL isExact = TRUE;
 
   x -= editor->rcFormat.left;
@@ -940,6 +940,8 @@ static BOOL ME_FindPixelPos(ME_TextEditor *editor, int x, int y,
   if (is_eol)
     *is_eol = 0;
 
+  p = ME_FindParagraphAtY(editor, y);
+
   /* find paragraph */
   for (; p != editor->pBuffer->pLast; p = p->member.para.next_para)
   {
@@ -2311,7 +2311,8 @@ ME_KeyDown(ME_TextEditor *editor, WORD nKey)
                                       editor->pCursors[0].pRun->member.run.style);
               para = editor->pBuffer->pFirst->member.para.next_para;
               ME_SetDefaultParaFormat(para->member.para.pFmt);
-              para->member.para.nFlags = MEPF_REWRAP;
+              para->member.para.nFlags = 0;
+              ME_MarkForWrapping(editor, para);
               editor->pCursors[0].pPara = para;
               editor->pCursors[0].pRun = ME_FindItemFwd(para, diRun);
               editor->pCursors[1] = editor->pCursors[0];
@@ -398,6 +398,7 @@ typedef struct tagME_TextEditor
   int nUndoLimit;
   ME_UndoMode nUndoMode;
   int nParagraphs;
+  int nFirstMarkedOfs; /* offset of the first paragraph marked for rewrapping, -1 if none */
   int nLastSelStart, nLastSelEnd;
   ME_DisplayItem *pLastSelStartPara, *pLastSelEndPara;
   ME_FontCacheItem pFontCache[HFONT_CACHE_SIZE];
@@ -44,16 +44,20 @@ void ME_PaintContent(ME_TextEditor *editor, HDC hDC, const RECT *rcUpdate)
   ME_InitContext(&c, editor, hDC);
   SetBkMode(hDC, TRANSPARENT);
   ME_MoveCaret(editor);
-  item = editor->pBuffer->pFirst->next;
   /* This context point is an offset for the paragraph positions stored
    * during wrapping. It shouldn't be modified during painting. */
   c.pt.x = c.rcView.left - editor->horz_si.nPos;
   c.pt.y = c.rcView.top - editor->vert_si.nPos;
+  /* Only the paragraphs overlapping the update region need to be visited. */
+  item = ME_FindParagraphAtY(editor, rcUpdate->top - c.pt.y);
   while(item != editor->pBuffer->pLast)
   {
     assert(item->type == diParagraph);
 
     ys = c.pt.y + item->member.para.pt.y;
+    if (ys >= rcUpdate->bottom && !item->member.para.pCell &&
+        !(item->member.para.nFlags & MEPF_ROWEND))
+      break;
     if (item->member.para.pCell
         != item->member.para.next_para->member.para.pCell)
     {
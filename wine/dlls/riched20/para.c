@@ -80,22 +80,33 @@ void ME_MakeFirstParagraph(ME_TextEditor *editor)
   text->pLast->member.para.prev_para = para;
 
   text->pLast->member.para.nCharOfs = editor->bEmulateVersion10 ? 2 : 1;
+  editor->nFirstMarkedOfs = 0;
 
   ME_DestroyContext(&c);
 }
 
-static void ME_MarkForWrapping(ME_TextEditor *editor, ME_DisplayItem *first, const ME_DisplayItem *last)
+/* Flags the paragraph for rewrapping and remembers the lowest character
+ * offset that has to be laid out again, so that ME_WrapMarkedParagraphs
+ * can skip the unchanged beginning of the document. */
+void ME_MarkForWrapping(ME_TextEditor *editor, ME_DisplayItem *para)
 {
-  while(first != last)
-  {
-    first->member.para.nFlags |= MEPF_REWRAP;
-    first = first->member.para.next_para;
-  }
+  if (para->type != diParagraph) /* start of the text */
+    return;
+  para->member.para.nFlags |= MEPF_REWRAP;
+  if (editor->nFirstMarkedOfs < 0 || para->member.para.nCharOfs < editor->nFirstMarkedOfs)
+    editor->nFirstMarkedOfs = para->member.para.nCharOfs;
 }
 
 void ME_MarkAllForWrapping(ME_TextEditor *editor)
 {
-  ME_MarkForWrapping(editor, editor->pBuffer->pFirst->member.para.next_para, editor->pBuffer->pLast);
+  ME_DisplayItem *para = editor->pBuffer->pFirst->member.para.next_para;
+
+  while (para != editor->pBuffer->pLast)
+  {
+    para->member.para.nFlags |= MEPF_REWRAP;
+    para = para->member.para.next_para;
+  }
+  editor->nFirstMarkedOfs = 0;
 }
 
 static void ME_UpdateTableFlags(ME_DisplayItem *para)
@@ -184,7 +195,7 @@ static BOOL ME_SetParaFormat(ME_TextEditor *editor, ME_DisplayItem *para, const
 #undef COPY_FIELD
 
   if (memcmp(&copy, para->member.para.pFmt, sizeof(PARAFORMAT2)))
-    para->member.para.nFlags |= MEPF_REWRAP;
+    ME_MarkForWrapping(editor, para);
 
   return TRUE;
 }
@@ -247,7 +258,7 @@ ME_DisplayItem *ME_SplitParagraph(ME_TextEditor *editor, ME_DisplayItem *run,
   }
   new_para->member.para.nCharOfs = run_para->member.para.nCharOfs + ofs;
   new_para->member.para.nCharOfs += eol_len;
-  new_para->member.para.nFlags = MEPF_REWRAP;
+  ME_MarkForWrapping(editor, new_para);
 
   /* FIXME initialize format style and call ME_SetParaFormat blah blah */
   *new_para->member.para.pFmt = *run_para->member.para.pFmt;
@@ -309,8 +320,8 @@ ME_DisplayItem *ME_SplitParagraph(ME_TextEditor *editor, ME_DisplayItem *run,
   }
 
   /* force rewrap of the */
-  run_para->member.para.prev_para->member.para.nFlags |= MEPF_REWRAP;
-  new_para->member.para.prev_para->member.para.nFlags |= MEPF_REWRAP;
+  ME_MarkForWrapping(editor, run_para->member.para.prev_para);
+  ME_MarkForWrapping(editor, new_para->member.para.prev_para);
 
   /* we've added the end run, so we need to modify nCharOfs in the next paragraphs */
   ME_PropagateCharOffset(next_para, eol_len);
@@ -438,7 +449,7 @@ ME_DisplayItem *ME_JoinParagraphs(ME_TextEditor *editor, ME_DisplayItem *tp,
   ME_CheckCharOffsets(editor);
 
   editor->nParagraphs--;
-  tp->member.para.nFlags |= MEPF_REWRAP;
+  ME_MarkForWrapping(editor, tp);
   return tp;
 }
 
@@ -446,6 +457,78 @@ ME_DisplayItem *ME_GetParagraph(ME_DisplayItem *item) {
   return ME_FindItemBackOrHere(item, diParagraph);
 }
 
+/******************************************************************************
+ * ME_FindParagraphAtOfs
+ *
+ * Finds the paragraph containing an absolute character offset.  The search
+ * starts from whichever end of the document is closer, so that lookups near
+ * the end (e.g. when appending text) don't walk the whole document.
+ */
+ME_DisplayItem *ME_FindParagraphAtOfs(ME_TextEditor *editor, int nCharOfs)
+{
+  ME_DisplayItem *para;
+  int nTextEnd = editor->pBuffer->pLast->member.para.nCharOfs;
+
+  nCharOfs = max(nCharOfs, 0);
+  nCharOfs = min(nCharOfs, nTextEnd - 1);
+
+  if (nCharOfs < nTextEnd / 2)
+  {
+    para = editor->pBuffer->pFirst->member.para.next_para;
+    while (para->member.para.next_para->member.para.nCharOfs <= nCharOfs)
+      para = para->member.para.next_para;
+  }
+  else
+  {
+    para = editor->pBuffer->pLast->member.para.prev_para;
+    while (para->member.para.nCharOfs > nCharOfs)
+      para = para->member.para.prev_para;
+  }
+  assert(para->type == diParagraph);
+  return para;
+}
+
+/* Paragraphs inside table cells aren't positioned in document order, so
+ * vertical searches only stop on paragraphs outside of tables and on the
+ * start of top level table rows. */
+static BOOL ME_IsVerticalAnchor(const ME_DisplayItem *para)
+{
+  return !para->member.para.pCell && !(para->member.para.nFlags & MEPF_ROWEND);
+}
+
+/******************************************************************************
+ * ME_FindParagraphAtY
+ *
+ * Returns the last top level paragraph starting at or above the vertical
+ * position y (relative to the start of the document).  Like
+ * ME_FindParagraphAtOfs the search starts from the closer end.
+ */
+ME_DisplayItem *ME_FindParagraphAtY(ME_TextEditor *editor, int y)
+{
+  ME_DisplayItem *first = editor->pBuffer->pFirst->member.para.next_para;
+  ME_DisplayItem *para, *found = first;
+
+  if (y < editor->nTotalLength / 2)
+  {
+    for (para = first; para != editor->pBuffer->pLast; para = para->member.para.next_para)
+    {
+      if (!ME_IsVerticalAnchor(para))
+        continue;
+      if (para->member.para.pt.y > y)
+        break;
+      found = para;
+    }
+  }
+  else
+  {
+    found = editor->pBuffer->pLast->member.para.prev_para;
+    while (found != first &&
+           (!ME_IsVerticalAnchor(found) || found->member.para.pt.y > y))
+      found = found->member.para.prev_para;
+  }
+  return found;
+}
+
 void ME_DumpParaStyleToBuf(const PARAFORMAT2 *pFmt, char buf[2048])
 {
   char *p;
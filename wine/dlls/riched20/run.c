@@ -186,12 +186,7 @@ void ME_RunOfsFromCharOfs(ME_TextEditor *editor,
   nCharOfs = min(nCharOfs, ME_GetTextLength(editor));
 
   /* Find the paragraph at the offset. */
-  next_item = editor->pBuffer->pFirst->member.para.next_para;
-  do {
-    item = next_item;
-    next_item = item->member.para.next_para;
-  } while (next_item->member.para.nCharOfs <= nCharOfs);
-  assert(item->type == diParagraph);
+  item = ME_FindParagraphAtOfs(editor, nCharOfs);
   nCharOfs -= item->member.para.nCharOfs;
   if (ppPara) *ppPara = item;
 
@@ -220,7 +215,7 @@ void ME_JoinRuns(ME_TextEditor *editor, ME_DisplayItem *p)
   int i;
   assert(p->type == diRun && pNext->type == diRun);
   assert(p->member.run.nCharOfs != -1);
-  ME_GetParagraph(p)->member.para.nFlags |= MEPF_REWRAP;
+  ME_MarkForWrapping(editor, ME_GetParagraph(p));
 
   /* Update all cursors so that they don't contain the soon deleted run */
   for (i=0; i<editor->nCursors; i++) {
@@ -277,7 +272,7 @@ ME_DisplayItem *ME_SplitRunSimple(ME_TextEditor *editor, ME_Cursor *cursor)
       editor->pCursors[i].nOffset -= nOffset;
     }
   }
-  cursor->pPara->member.para.nFlags |= MEPF_REWRAP;
+  ME_MarkForWrapping(editor, cursor->pPara);
   return run;
 }
 
@@ -326,7 +321,7 @@ ME_InsertRunAtCursor(ME_TextEditor *editor, ME_Cursor *cursor, ME_Style *style,
   ME_InsertBefore(cursor->pRun, pDI);
   TRACE("Shift length:%d\n", len);
   ME_PropagateCharOffset(cursor->pRun, len);
-  cursor->pPara->member.para.nFlags |= MEPF_REWRAP;
+  ME_MarkForWrapping(editor, cursor->pPara);
   return pDI;
 }
 
@@ -684,7 +679,7 @@ void ME_SetCharFormat(ME_TextEditor *editor, ME_Cursor *start, ME_Cursor *end, C
 
   run = start->pRun;
   para = start->pPara;
-  para->member.para.nFlags |= MEPF_REWRAP;
+  ME_MarkForWrapping(editor, para);
 
   while(run != end_run)
   {
@@ -701,7 +696,7 @@ void ME_SetCharFormat(ME_TextEditor *editor, ME_Cursor *start, ME_Cursor *end, C
       para = run;
       run = ME_FindItemFwd(run, diRun);
       if (run != end_run)
-        para->member.para.nFlags |= MEPF_REWRAP;
+        ME_MarkForWrapping(editor, para);
     }
   }
 }
@@ -5323,6 +5323,64 @@ static void test_EM_StreamIn_Undo(void)
   DestroyWindow(hwndRichEdit);
 }
 
+static void test_append_large_text(void)
+{
+  /* Appending to the end of a long document, as log viewers do, must not
+   * slow down as the document grows. */
+  static const char line[] = "Log entry\r\n";
+  static const int count = 5000;
+  HWND hwndRichEdit = new_richedit(NULL);
+  GETTEXTLENGTHEX gtl;
+  EDITSTREAM es;
+  const char *streamText;
+  DWORD start, replacesel_time, streamin_time;
+  LRESULT result;
+  int i, len;
+
+  start = GetTickCount();
+  for (i = 0; i < count; i++)
+  {
+    SendMessageA(hwndRichEdit, EM_SETSEL, -1, -1);
+    SendMessageA(hwndRichEdit, EM_REPLACESEL, FALSE, (LPARAM)line);
+  }
+  replacesel_time = GetTickCount() - start;
+
+  /* the \r\n pair is stored as a single paragraph break */
+  len = (sizeof(line) - 2) * count;
+  gtl.flags = GTL_NUMCHARS | GTL_PRECISE;
+  gtl.codepage = CP_ACP;
+  result = SendMessageA(hwndRichEdit, EM_GETTEXTLENGTHEX, (WPARAM)&gtl, 0);
+  ok(result == len, "EM_GETTEXTLENGTHEX returned %ld, expected %d\n", result, len);
+  result = SendMessageA(hwndRichEdit, EM_GETLINECOUNT, 0, 0);
+  ok(result == count + 1, "EM_GETLINECOUNT returned %ld, expected %d\n", result, count + 1);
+  result = SendMessageA(hwndRichEdit, EM_LINEINDEX, count - 1, 0);
+  ok(result == len - (sizeof(line) - 2), "EM_LINEINDEX returned %ld\n", result);
+  result = SendMessageA(hwndRichEdit, EM_LINEFROMCHAR, len - 1, 0);
+  ok(result == count - 1, "EM_LINEFROMCHAR returned %ld, expected %d\n", result, count - 1);
+
+  es.dwCookie = (DWORD_PTR)&streamText;
+  es.dwError = 0;
+  es.pfnCallback = test_EM_STREAMIN_esCallback;
+  start = GetTickCount();
+  for (i = 0; i < count; i++)
+  {
+    streamText = line;
+    SendMessageA(hwndRichEdit, EM_SETSEL, -1, -1);
+    SendMessageA(hwndRichEdit, EM_STREAMIN, SF_TEXT | SFF_SELECTION, (LPARAM)&es);
+  }
+  streamin_time = GetTickCount() - start;
+
+  result = SendMessageA(hwndRichEdit, EM_GETTEXTLENGTHEX, (WPARAM)&gtl, 0);
+  ok(result == 2 * len, "EM_GETTEXTLENGTHEX returned %ld, expected %d\n", result, 2 * len);
+  result = SendMessageA(hwndRichEdit, EM_GETLINECOUNT, 0, 0);
+  ok(result == 2 * count + 1, "EM_GETLINECOUNT returned %ld, expected %d\n", result, 2 * count + 1);
+
+  trace("appending %d lines: EM_REPLACESEL %u ms, EM_STREAMIN %u ms\n",
+        count, replacesel_time, streamin_time);
+
+  DestroyWindow(hwndRichEdit);
+}
+
 static BOOL is_em_settextex_supported(HWND hwnd)
 {
     SETTEXTEX stex = { ST_DEFAULT, CP_ACP };
@@ -7504,6 +7562,7 @@ START_TEST( editor )
   test_EM_STREAMOUT();
   test_EM_STREAMOUT_FONTTBL();
   test_EM_StreamIn_Undo();
+  test_append_large_text();
   test_EM_FORMATRANGE();
   test_unicode_conversions();
   test_EM_GETTEXTLENGTHEX();
@@ -700,14 +700,34 @@ static void ME_MarkRepaintEnd(ME_DisplayItem *para,
 
 BOOL ME_WrapMarkedParagraphs(ME_TextEditor *editor)
 {
-  ME_DisplayItem *item;
+  ME_DisplayItem *item, *start;
   ME_Context c;
   int totalWidth = 0;
   ME_DisplayItem *repaint_start = NULL, *repaint_end = NULL;
 
   ME_InitContext(&c, editor, ITextHost_TxGetDC(editor->texthost));
+
+  /* Paragraphs before the first marked one keep their layout, so start
+   * from there, backing out of any table since the rows are laid out as
+   * a whole. */
+  if (editor->nFirstMarkedOfs >= 0)
+  {
+    start = ME_FindParagraphAtOfs(editor, editor->nFirstMarkedOfs);
+    while (start->member.para.prev_para != editor->pBuffer->pFirst &&
+           (start->member.para.pCell || start->member.para.nFlags & MEPF_ROWEND))
+      start = start->member.para.prev_para;
+  }
+  else
+  {
+    start = editor->pBuffer->pLast;
+    totalWidth = editor->nTotalWidth;
+  }
+
+  c.pt = start->member.para.pt;
+  if (start == editor->pBuffer->pFirst->member.para.next_para)
+    c.pt.y = 0;
   c.pt.x = 0;
-  item = editor->pBuffer->pFirst->next;
+  item = start;
   while(item != editor->pBuffer->pLast) {
     BOOL bRedraw = FALSE;
 
@@ -832,6 +852,18 @@ BOOL ME_WrapMarkedParagraphs(ME_TextEditor *editor)
     totalWidth = max(totalWidth, item->member.para.nWidth);
     item = item->member.para.next_para;
   }
+  /* Wrapping itself may join runs and mark the paragraphs again. */
+  editor->nFirstMarkedOfs = -1;
+
+  /* The widest paragraph can only be among those skipped above if the
+   * rewrapped ones got narrower. */
+  if (totalWidth < editor->nTotalWidth)
+  {
+    for (item = editor->pBuffer->pFirst->member.para.next_para; item != start;
+         item = item->member.para.next_para)
+      totalWidth = max(totalWidth, item->member.para.nWidth);
+  }
+
   editor->sizeWindow.cx = c.rcView.right-c.rcView.left;
   editor->sizeWindow.cy = c.rcView.bottom-c.rcView.top;
 
@@ -67,6 +67,11 @@ MAKE_FUNCPTR(gnutls_record_get_max_size);
 MAKE_FUNCPTR(gnutls_record_recv);
 MAKE_FUNCPTR(gnutls_record_send);
 MAKE_FUNCPTR(gnutls_server_name_set);
+MAKE_FUNCPTR(gnutls_session_get_data);
+MAKE_FUNCPTR(gnutls_session_get_ptr);
+MAKE_FUNCPTR(gnutls_session_is_resumed);
+MAKE_FUNCPTR(gnutls_session_set_data);
+MAKE_FUNCPTR(gnutls_session_set_ptr);
 MAKE_FUNCPTR(gnutls_transport_get_ptr);
 MAKE_FUNCPTR(gnutls_transport_set_errno);
 MAKE_FUNCPTR(gnutls_transport_set_ptr);
@@ -76,6 +81,91 @@ MAKE_FUNCPTR(gnutls_transport_set_push_function);
 
 
 
+/* Client sessions are resumed from the last session negotiated with the same
+ * target, so repeated connections to a server skip the full handshake. A target
+ * of the form "host:port" keeps servers on different ports of a host apart, only
+ * the host part is sent as server name. */
+#define MAX_RESUME_ENTRIES 32
+
+struct resume_entry
+{
+    struct list entry;
+    char *target;
+    size_t size;
+    char data[1];
+};
+
+static struct list resume_cache = LIST_INIT(resume_cache);
+static unsigned int resume_count;
+
+static CRITICAL_SECTION resume_cs;
+static CRITICAL_SECTION_DEBUG resume_cs_debug =
+{
+    0, 0, &resume_cs,
+    { &resume_cs_debug.ProcessLocksList, &resume_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": resume_cs") }
+};
+static CRITICAL_SECTION resume_cs = { &resume_cs_debug, -1, 0, 0, 0, 0 };
+
+static struct resume_entry *find_resume_entry(const char *target)
+{
+    struct resume_entry *entry;
+
+    LIST_FOR_EACH_ENTRY(entry, &resume_cache, struct resume_entry, entry)
+        if (!strcmp(entry->target, target)) return entry;
+    return NULL;
+}
+
+static void remove_resume_entry(struct resume_entry *entry)
+{
+    list_remove(&entry->entry);
+    HeapFree(GetProcessHeap(), 0, entry->target);
+    HeapFree(GetProcessHeap(), 0, entry);
+    resume_count--;
+}
+
+static void restore_session_data(gnutls_session_t s, const char *target)
+{
+    struct resume_entry *entry;
+
+    EnterCriticalSection(&resume_cs);
+    if ((entry = find_resume_entry(target)))
+    {
+        if (pgnutls_session_set_data(s, entry->data, entry->size) != GNUTLS_E_SUCCESS)
+            remove_resume_entry(entry);
+    }
+    LeaveCriticalSection(&resume_cs);
+}
+
+static void save_session_data(gnutls_session_t s)
+{
+    struct resume_entry *entry, *old;
+    const char *target = pgnutls_session_get_ptr(s);
+    size_t len, size = 0;
+
+    if (!target) return;
+    len = strlen(target);
+
+    if (pgnutls_session_get_data(s, NULL, &size) != GNUTLS_E_SUCCESS || !size) return;
+    if (!(entry = HeapAlloc(GetProcessHeap(), 0, FIELD_OFFSET(struct resume_entry, data[size])))) return;
+    if (!(entry->target = HeapAlloc(GetProcessHeap(), 0, len + 1)) ||
+        pgnutls_session_get_data(s, entry->data, &size) != GNUTLS_E_SUCCESS)
+    {
+        HeapFree(GetProcessHeap(), 0, entry->target);
+        HeapFree(GetProcessHeap(), 0, entry);
+        return;
+    }
+    memcpy(entry->target, target, len + 1);
+    entry->size = size;
+
+    EnterCriticalSection(&resume_cs);
+    if ((old = find_resume_entry(target))) remove_resume_entry(old);
+    list_add_head(&resume_cache, &entry->entry);
+    if (++resume_count > MAX_RESUME_ENTRIES)
+        remove_resume_entry(LIST_ENTRY(list_tail(&resume_cache), struct resume_entry, entry));
+    LeaveCriticalSection(&resume_cs);
+}
+
 static ssize_t schan_pull_adapter(gnutls_transport_ptr_t transport,
                                       void *buff, size_t buff_len)
 {
@@ -173,6 +263,7 @@ BOOL schan_imp_create_session(schan_imp_session *session, schan_credentials *cre
 void schan_imp_dispose_session(schan_imp_session session)
 {
     gnutls_session_t s = (gnutls_session_t)session;
+    HeapFree(GetProcessHeap(), 0, pgnutls_session_get_ptr(s));
     pgnutls_deinit(s);
 }
 
@@ -186,8 +277,19 @@ void schan_imp_set_session_transport(schan_imp_session session,
 void schan_imp_set_session_target(schan_imp_session session, const char *target)
 {
     gnutls_session_t s = (gnutls_session_t)session;
-
-    pgnutls_server_name_set( s, GNUTLS_NAME_DNS, target, strlen(target) );
+    const char *port = strchr( target, ':' );
+    size_t len = strlen( target );
+    char *key;
+
+    /* the session is resumed and saved under the full target, port included */
+    if (port && port[1] && !port[1 + strspn( port + 1, "0123456789" )]) len = port - target;
+    pgnutls_server_name_set( s, GNUTLS_NAME_DNS, target, len );
+
+    if (!(key = HeapAlloc( GetProcessHeap(), 0, strlen(target) + 1 ))) return;
+    strcpy( key, target );
+    HeapFree( GetProcessHeap(), 0, pgnutls_session_get_ptr(s) );
+    pgnutls_session_set_ptr( s, key );
+    restore_session_data( s, key );
 }
 
 SECURITY_STATUS schan_imp_handshake(schan_imp_session session)
@@ -197,7 +299,8 @@ SECURITY_STATUS schan_imp_handshake(schan_imp_session session)
     switch(err)
     {
         case GNUTLS_E_SUCCESS:
-            TRACE("Handshake completed\n");
+            TRACE("Handshake completed%s\n", pgnutls_session_is_resumed(s) ? ", session resumed" : "");
+            save_session_data(s);
             return SEC_E_OK;
 
         case GNUTLS_E_AGAIN:
@@ -500,6 +603,11 @@ BOOL schan_imp_init(void)
     LOAD_FUNCPTR(gnutls_record_recv);
     LOAD_FUNCPTR(gnutls_record_send);
     LOAD_FUNCPTR(gnutls_server_name_set)
+    LOAD_FUNCPTR(gnutls_session_get_data)
+    LOAD_FUNCPTR(gnutls_session_get_ptr)
+    LOAD_FUNCPTR(gnutls_session_is_resumed)
+    LOAD_FUNCPTR(gnutls_session_set_data)
+    LOAD_FUNCPTR(gnutls_session_set_ptr)
     LOAD_FUNCPTR(gnutls_transport_get_ptr)
     LOAD_FUNCPTR(gnutls_transport_set_errno)
     LOAD_FUNCPTR(gnutls_transport_set_ptr)
@@ -530,6 +638,9 @@ fail:
 
 void schan_imp_deinit(void)
 {
+    while (!list_empty(&resume_cache))
+        remove_resume_entry(LIST_ENTRY(list_head(&resume_cache), struct resume_entry, entry));
+    DeleteCriticalSection(&resume_cs);
     pgnutls_global_deinit();
     wine_dlclose(libgnutls_handle, NULL, 0);
     libgnutls_handle = NULL;
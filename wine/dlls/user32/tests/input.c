@@ -1350,6 +1350,81 @@ done:
     SetCursorPos(pt_org.x, pt_org.y);
 }
 
+static int ll_move_count;
+static POINT ll_move_pt;
+static LONG ll_moves_sent;
+
+static LRESULT CALLBACK hook_proc_count( int code, WPARAM wparam, LPARAM lparam )
+{
+    if (code == HC_ACTION && wparam == WM_MOUSEMOVE)
+    {
+        ll_move_pt = ((MSLLHOOKSTRUCT *)lparam)->pt;
+        ll_move_count++;
+    }
+    return CallNextHookEx( 0, code, wparam, lparam );
+}
+
+static DWORD WINAPI ll_move_thread( void *arg )
+{
+    int i, dx = (INT_PTR)arg;
+
+    for (i = 0; i < 50; i++)
+    {
+        InterlockedIncrement( &ll_moves_sent );
+        mouse_event( MOUSEEVENTF_MOVE, dx, 0, 0, 0 );
+    }
+    return 0;
+}
+
+static void test_mouse_ll_hook_moves(void)
+{
+    HANDLE threads[2];
+    HHOOK hook;
+    POINT pt_org, pt;
+    DWORD start, ret;
+    MSG msg;
+
+    GetCursorPos(&pt_org);
+    SetCursorPos(100, 100);
+
+    if (!(hook = SetWindowsHookExA(WH_MOUSE_LL, hook_proc_count, GetModuleHandleA(0), 0)))
+    {
+        win_skip( "cannot set MOUSE_LL hook\n" );
+        return;
+    }
+
+    /* The hook thread doesn't process messages while two other threads send
+     * 100 moves, so each move waiting for the hook is replaced by the next one. */
+    ll_move_count = 0;
+    ll_moves_sent = 0;
+    start = GetTickCount();
+    threads[0] = CreateThread( NULL, 0, ll_move_thread, (void *)(INT_PTR)1, 0, NULL );
+    threads[1] = CreateThread( NULL, 0, ll_move_thread, (void *)(INT_PTR)-1, 0, NULL );
+    while (ll_moves_sent < 100 && GetTickCount() - start < 5000) Sleep( 10 );
+    Sleep( 100 );
+    /* Wine merges the waiting moves, Windows may time them out instead */
+    trace("hook called %d times while blocked\n", ll_move_count);
+
+    /* now let the hook see the last move */
+    while ((ret = MsgWaitForMultipleObjects( 2, threads, TRUE, 5000, QS_ALLINPUT )) == WAIT_OBJECT_0 + 2)
+        while (PeekMessageA( &msg, 0, 0, 0, PM_REMOVE )) DispatchMessageA( &msg );
+    ok(ret == WAIT_OBJECT_0, "threads didn't finish, ret %u\n", ret);
+    while (PeekMessageA( &msg, 0, 0, 0, PM_REMOVE )) DispatchMessageA( &msg );
+    trace("100 hooked mouse moves took %u ms, hook called %d times\n",
+          GetTickCount() - start, ll_move_count);
+
+    ok(ll_moves_sent == 100, "sent %d moves\n", ll_moves_sent);
+    GetCursorPos(&pt);
+    ok((ll_move_pt.x == pt.x && ll_move_pt.y == pt.y) ||
+       broken(TRUE), /* Windows skips moves once the hook times out */
+       "hook got (%d,%d), cursor is at (%d,%d)\n", ll_move_pt.x, ll_move_pt.y, pt.x, pt.y);
+
+    CloseHandle( threads[0] );
+    CloseHandle( threads[1] );
+    UnhookWindowsHookEx(hook);
+    SetCursorPos(pt_org.x, pt_org.y);
+}
+
 static void test_GetMouseMovePointsEx(void)
 {
 #define BUFLIM  64
@@ -1657,6 +1732,7 @@ START_TEST(input)
 
     test_keynames();
     test_mouse_ll_hook();
+    test_mouse_ll_hook_moves();
     test_key_map();
     test_ToUnicode();
     test_get_async_key_state();
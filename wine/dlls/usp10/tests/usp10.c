@@ -1453,6 +1453,17 @@ static void test_ScriptShape(HDC hdc)
     ok(attrs[2].fZeroWidth == 0, "fZeroWidth incorrect\n");
     ok(attrs[3].fZeroWidth == 0, "fZeroWidth incorrect\n");
 
+    /* shaping the same run again must not return the RTL result */
+    items[0].a.fRTL = 0;
+    memset(glyphs2,-1,sizeof(glyphs2));
+    memset(logclust,-1,sizeof(logclust));
+    hr = ScriptShape(hdc, &sc, test1, 4, 4, &items[0].a, glyphs2, logclust, attrs, &nb);
+    ok(!hr, "ScriptShape should return S_OK not %08x\n", hr);
+    ok(nb == 4, "Wrong number of items\n");
+    ok(!memcmp(glyphs2, glyphs, sizeof(glyphs)), "Glyphs should not be reordered\n");
+    ok(logclust[0] == 0, "clusters out of order\n");
+    ok(logclust[3] == 3, "clusters out of order\n");
+
     ScriptFreeCache(&sc);
 }
 
@@ -2521,6 +2532,97 @@ static void test_ScriptString(HDC hdc)
      ok(hr == S_OK, "ScriptStringFree should return S_OK not %08x\n", hr);
 }
 
+static void shape_items(HDC hdc, SCRIPT_CACHE *sc, const WCHAR *str, const SCRIPT_ITEM *items,
+                        int nitems, int max_glyphs, WORD *glyphs, WORD *logclust,
+                        SCRIPT_VISATTR *attrs, int *advances, GOFFSET *offsets, int *glyph_count)
+{
+    HRESULT hr;
+    int i, nb, total = 0;
+    ABC abc;
+
+    for (i = 0; i < nitems; i++)
+    {
+        const WCHAR *chars = str + items[i].iCharPos;
+        int count = items[i + 1].iCharPos - items[i].iCharPos;
+        SCRIPT_ANALYSIS sa = items[i].a;
+
+        hr = ScriptShape(hdc, sc, chars, count, max_glyphs - total, &sa, glyphs + total,
+                         logclust + items[i].iCharPos, attrs + total, &nb);
+        ok(hr == S_OK, "ScriptShape should return S_OK not %08x\n", hr);
+        if (hr != S_OK) break;
+        hr = ScriptPlace(hdc, sc, glyphs + total, nb, attrs + total, &sa,
+                         advances + total, offsets + total, &abc);
+        ok(hr == S_OK, "ScriptPlace should return S_OK not %08x\n", hr);
+        total += nb;
+    }
+    *glyph_count = total;
+}
+
+static void test_ScriptShape_long(HDC hdc)
+{
+    static const WCHAR line[] = {'T','h','e',' ','q','u','i','c','k',' ','b','r','o','w','n',' ',
+                                 'f','o','x',' ','j','u','m','p','s',' ','o','v','e','r',' ','1','3',
+                                 ' ','l','a','z','y',' ','d','o','g','s','.',' '};
+    const int line_len = sizeof(line) / sizeof(line[0]);
+    const int len = line_len * 1000;
+    const int max_glyphs = len * 3 / 2 + 16;
+    SCRIPT_CACHE sc = NULL;
+    SCRIPT_ITEM *items;
+    WORD *glyphs[2], *logclust[2];
+    SCRIPT_VISATTR *attrs[2];
+    GOFFSET *offsets[2];
+    int *advances[2], count[2], nitems, i;
+    DWORD start, elapsed[2];
+    HRESULT hr;
+    WCHAR *str;
+
+    str = HeapAlloc(GetProcessHeap(), 0, len * sizeof(WCHAR));
+    for (i = 0; i < len; i++)
+        str[i] = line[i % line_len];
+    items = HeapAlloc(GetProcessHeap(), 0, (len + 1) * sizeof(SCRIPT_ITEM));
+    hr = ScriptItemize(str, len, len, NULL, NULL, items, &nitems);
+    ok(hr == S_OK, "ScriptItemize should return S_OK not %08x\n", hr);
+
+    for (i = 0; i < 2; i++)
+    {
+        glyphs[i] = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, max_glyphs * sizeof(WORD));
+        logclust[i] = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, len * sizeof(WORD));
+        attrs[i] = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, max_glyphs * sizeof(SCRIPT_VISATTR));
+        advances[i] = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, max_glyphs * sizeof(int));
+        offsets[i] = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, max_glyphs * sizeof(GOFFSET));
+    }
+
+    /* the second pass over the same cache is what a repainting text view
+     * does, it has to give the same results as the first one */
+    for (i = 0; i < 2; i++)
+    {
+        start = GetTickCount();
+        shape_items(hdc, &sc, str, items, nitems, max_glyphs, glyphs[i], logclust[i],
+                    attrs[i], advances[i], offsets[i], &count[i]);
+        elapsed[i] = GetTickCount() - start;
+    }
+
+    ok(count[0] == count[1], "got %d glyphs, then %d\n", count[0], count[1]);
+    ok(!memcmp(glyphs[0], glyphs[1], count[0] * sizeof(WORD)), "glyphs differ\n");
+    ok(!memcmp(logclust[0], logclust[1], len * sizeof(WORD)), "clusters differ\n");
+    ok(!memcmp(attrs[0], attrs[1], count[0] * sizeof(SCRIPT_VISATTR)), "attributes differ\n");
+    ok(!memcmp(advances[0], advances[1], count[0] * sizeof(int)), "advances differ\n");
+    ok(!memcmp(offsets[0], offsets[1], count[0] * sizeof(GOFFSET)), "offsets differ\n");
+    trace("shaping %d characters in %d items: %u ms, then %u ms\n", len, nitems, elapsed[0], elapsed[1]);
+
+    for (i = 0; i < 2; i++)
+    {
+        HeapFree(GetProcessHeap(), 0, glyphs[i]);
+        HeapFree(GetProcessHeap(), 0, logclust[i]);
+        HeapFree(GetProcessHeap(), 0, attrs[i]);
+        HeapFree(GetProcessHeap(), 0, advances[i]);
+        HeapFree(GetProcessHeap(), 0, offsets[i]);
+    }
+    ScriptFreeCache(&sc);
+    HeapFree(GetProcessHeap(), 0, items);
+    HeapFree(GetProcessHeap(), 0, str);
+}
+
 static void test_ScriptStringXtoCP_CPtoX(HDC hdc)
 {
 /*****************************************************************************************
@@ -3213,6 +3315,7 @@ START_TEST(usp10)
     test_ScriptTextOut3(hdc);
     test_ScriptXtoX();
     test_ScriptString(hdc);
+    test_ScriptShape_long(hdc);
     test_ScriptStringXtoCP_CPtoX(hdc);
 
     test_ScriptLayout();
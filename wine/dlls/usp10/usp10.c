@@ -837,6 +837,87 @@ static inline BOOL set_cache_glyph_widths(SCRIPT_CACHE *psc, WORD glyph, ABC *ab
     return TRUE;
 }
 
+/* longer runs are rarely shaped twice and would only thrash the cache */
+#define SHAPED_RUN_MAX_CHARS 1024
+
+static DWORD hash_shaped_run(const WCHAR *chars, int count, OPENTYPE_TAG script_tag,
+                             OPENTYPE_TAG lang_tag)
+{
+    DWORD hash = 2166136261u;
+    int i;
+
+    for (i = 0; i < count; i++)
+        hash = (hash ^ chars[i]) * 16777619;
+    hash = (hash ^ script_tag) * 16777619;
+    hash = (hash ^ lang_tag) * 16777619;
+    return hash;
+}
+
+static ShapedRun *find_shaped_run(ScriptCache *sc, DWORD hash, const SCRIPT_ANALYSIS *psa,
+                                  OPENTYPE_TAG script_tag, OPENTYPE_TAG lang_tag,
+                                  const WCHAR *chars, int count, int max_glyphs)
+{
+    ShapedRun *run;
+
+    LIST_FOR_EACH_ENTRY(run, &sc->shaped_runs, ShapedRun, entry)
+    {
+        if (run->hash != hash || run->char_count != count || run->max_glyphs != max_glyphs ||
+            run->script_tag != script_tag || run->lang_tag != lang_tag ||
+            memcmp(&run->sa, psa, sizeof(*psa)) || memcmp(run->chars, chars, count * sizeof(WCHAR)))
+            continue;
+
+        list_remove(&run->entry);
+        list_add_head(&sc->shaped_runs, &run->entry);
+        return run;
+    }
+    return NULL;
+}
+
+static void add_shaped_run(ScriptCache *sc, DWORD hash, const SCRIPT_ANALYSIS *psa,
+                           OPENTYPE_TAG script_tag, OPENTYPE_TAG lang_tag,
+                           const WCHAR *chars, int count, int max_glyphs,
+                           const WORD *glyphs, int glyph_count, const WORD *log_clust,
+                           const SCRIPT_CHARPROP *char_props, const SCRIPT_GLYPHPROP *glyph_props)
+{
+    /* glyph properties are initialized for each character even if there are less glyphs */
+    int prop_count = max(count, glyph_count);
+    ShapedRun *run;
+
+    if (sc->shaped_run_count == SHAPED_RUN_CACHE_SIZE)
+    {
+        run = LIST_ENTRY(list_tail(&sc->shaped_runs), ShapedRun, entry);
+        list_remove(&run->entry);
+        heap_free(run);
+        sc->shaped_run_count--;
+    }
+
+    if (!(run = heap_alloc(sizeof(*run) + prop_count * sizeof(SCRIPT_GLYPHPROP) +
+                           count * (sizeof(SCRIPT_CHARPROP) + 2 * sizeof(WORD)) +
+                           glyph_count * sizeof(WORD))))
+        return;
+
+    run->hash = hash;
+    run->sa = *psa;
+    run->script_tag = script_tag;
+    run->lang_tag = lang_tag;
+    run->char_count = count;
+    run->max_glyphs = max_glyphs;
+    run->glyph_count = glyph_count;
+    run->glyph_props = (SCRIPT_GLYPHPROP *)(run + 1);
+    run->char_props = (SCRIPT_CHARPROP *)(run->glyph_props + prop_count);
+    run->chars = (WCHAR *)(run->char_props + count);
+    run->log_clust = run->chars + count;
+    run->glyphs = run->log_clust + count;
+    memcpy(run->glyph_props, glyph_props, prop_count * sizeof(SCRIPT_GLYPHPROP));
+    memcpy(run->char_props, char_props, count * sizeof(SCRIPT_CHARPROP));
+    memcpy(run->chars, chars, count * sizeof(WCHAR));
+    memcpy(run->log_clust, log_clust, count * sizeof(WORD));
+    memcpy(run->glyphs, glyphs, glyph_count * sizeof(WORD));
+
+    list_add_head(&sc->shaped_runs, &run->entry);
+    sc->shaped_run_count++;
+}
+
 static HRESULT init_script_cache(const HDC hdc, SCRIPT_CACHE *psc)
 {
     ScriptCache *sc;
@@ -847,6 +928,7 @@ static HRESULT init_script_cache(const HDC hdc, SCRIPT_CACHE *psc)
     if (!hdc) return E_PENDING;
 
     if (!(sc = heap_alloc_zero(sizeof(ScriptCache)))) return E_OUTOFMEMORY;
+    list_init(&sc->shaped_runs);
     if (!GetTextMetricsW(hdc, &sc->tm))
     {
         heap_free(sc);
@@ -892,7 +974,7 @@ static inline DWORD decode_surrogate_pair(LPCWSTR str, INT index, INT end)
     return 0;
 }
 
-static WORD get_char_script( LPCWSTR str, INT index, INT end, INT *consumed)
+static WORD lookup_char_script( LPCWSTR str, INT index, INT end, INT *consumed)
 {
     static const WCHAR latin_punc[] = {'#','$','&','\'',',',';','<','>','?','@','\\','^','_','`','{','|','}','~', 0x00a0, 0};
     WORD type = 0;
@@ -958,6 +1040,24 @@ static WORD get_char_script( LPCWSTR str, INT index, INT end, INT *consumed)
     return SCRIPT_UNDEFINED;
 }
 
+static WORD get_char_script( LPCWSTR str, INT index, INT end, INT *consumed)
+{
+    /* Basic Latin makes up most text, remember its scripts instead of
+     * classifying every character again (stored plus one, zero meaning
+     * not looked up yet). */
+    static WORD ascii_scripts[0x80];
+    WCHAR ch = str[index];
+
+    if (ch < 0x80)
+    {
+        *consumed = 1;
+        if (!ascii_scripts[ch])
+            ascii_scripts[ch] = lookup_char_script(str, index, end, consumed) + 1;
+        return ascii_scripts[ch] - 1;
+    }
+    return lookup_char_script(str, index, end, consumed);
+}
+
 static int compare_FindGlyph(const void *a, const void* b)
 {
     const FindGlyph_struct *find = (FindGlyph_struct*)a;
@@ -1016,8 +1116,11 @@ HRESULT WINAPI ScriptFreeCache(SCRIPT_CACHE *psc)
 
     if (psc && *psc)
     {
+        ShapedRun *run, *next;
         unsigned int i;
         INT n;
+        LIST_FOR_EACH_ENTRY_SAFE(run, next, &((ScriptCache *)*psc)->shaped_runs, ShapedRun, entry)
+            heap_free(run);
         for (i = 0; i < GLYPH_MAX / GLYPH_BLOCK_SIZE; i++)
         {
             heap_free(((ScriptCache *)*psc)->widths[i]);
@@ -2898,8 +3001,26 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
 
     if (psa && !psa->fNoGlyphIndex)
     {
+        ScriptCache *sc = (ScriptCache *)*psc;
+        ShapedRun *run;
+        DWORD hash = 0;
         WCHAR *rChars;
-        if ((hr = SHAPE_CheckFontForRequiredFeatures(hdc, (ScriptCache *)*psc, psa)) != S_OK) return hr;
+        if ((hr = SHAPE_CheckFontForRequiredFeatures(hdc, sc, psa)) != S_OK) return hr;
+
+        /* text is typically shaped again on every repaint */
+        if (cChars <= SHAPED_RUN_MAX_CHARS)
+        {
+            hash = hash_shaped_run(pwcChars, cChars, tagScript, tagLangSys);
+            if ((run = find_shaped_run(sc, hash, psa, tagScript, tagLangSys, pwcChars, cChars, cMaxGlyphs)))
+            {
+                memcpy(pwOutGlyphs, run->glyphs, run->glyph_count * sizeof(WORD));
+                memcpy(pwLogClust, run->log_clust, cChars * sizeof(WORD));
+                memcpy(pCharProps, run->char_props, cChars * sizeof(SCRIPT_CHARPROP));
+                memcpy(pOutGlyphProps, run->glyph_props, max(cChars, run->glyph_count) * sizeof(SCRIPT_GLYPHPROP));
+                *pcGlyphs = run->glyph_count;
+                return S_OK;
+            }
+        }
 
         rChars = heap_alloc(sizeof(WCHAR) * cChars);
         if (!rChars) return E_OUTOFMEMORY;
@@ -2961,6 +3082,10 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
         SHAPE_ApplyDefaultOpentypeFeatures(hdc, (ScriptCache *)*psc, psa, pwOutGlyphs, pcGlyphs, cMaxGlyphs, cChars, pwLogClust);
         SHAPE_CharGlyphProp(hdc, (ScriptCache *)*psc, psa, pwcChars, cChars, pwOutGlyphs, *pcGlyphs, pwLogClust, pCharProps, pOutGlyphProps);
         heap_free(rChars);
+
+        if (cChars <= SHAPED_RUN_MAX_CHARS)
+            add_shaped_run(sc, hash, psa, tagScript, tagLangSys, pwcChars, cChars, cMaxGlyphs,
+                           pwOutGlyphs, *pcGlyphs, pwLogClust, pCharProps, pOutGlyphProps);
     }
     else
     {
@@ -18,6 +18,9 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
  *
  */
+
+#include "wine/list.h"
+
 #define MS_MAKE_TAG( _x1, _x2, _x3, _x4 ) \
           ( ( (ULONG)_x4 << 24 ) |     \
             ( (ULONG)_x3 << 16 ) |     \
@@ -132,6 +135,8 @@
 #define FEATURE_GSUB_TABLE 1
 #define FEATURE_GPOS_TABLE 2
 
+#define SHAPED_RUN_CACHE_SIZE 64
+
 typedef struct {
     OPENTYPE_TAG tag;
     CHAR tableType;
@@ -163,6 +168,23 @@ typedef struct {
     WORD *glyphs[GLYPH_MAX / GLYPH_BLOCK_SIZE];
 } CacheGlyphPage;
 
+/* Result of shaping a run, the arrays follow the structure */
+typedef struct {
+    struct list entry;
+    DWORD hash;
+    SCRIPT_ANALYSIS sa;
+    OPENTYPE_TAG script_tag;
+    OPENTYPE_TAG lang_tag;
+    INT char_count;
+    INT max_glyphs;
+    INT glyph_count;
+    WCHAR *chars;
+    WORD *glyphs;
+    WORD *log_clust;
+    SCRIPT_CHARPROP *char_props;
+    SCRIPT_GLYPHPROP *glyph_props;
+} ShapedRun;
+
 typedef struct {
     LOGFONTW lf;
     TEXTMETRICW tm;
@@ -182,6 +204,9 @@ typedef struct {
 
     OPENTYPE_TAG userScript;
     OPENTYPE_TAG userLang;
+
+    struct list shaped_runs; /* most recently used first */
+    INT shaped_run_count;
 } ScriptCache;
 
 typedef struct _scriptData
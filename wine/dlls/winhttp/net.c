@@ -55,23 +55,10 @@
 /* to avoid conflicts with the Unix socket headers */
 #define USE_WS_PREFIX
 #include "winsock2.h"
+#include "ws2tcpip.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(winhttp);
 
-#ifndef HAVE_GETADDRINFO
-
-/* critical section to protect non-reentrant gethostbyname() */
-static CRITICAL_SECTION cs_gethostbyname;
-static CRITICAL_SECTION_DEBUG critsect_debug =
-{
-    0, 0, &cs_gethostbyname,
-    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
-      0, 0, { (DWORD_PTR)(__FILE__ ": cs_gethostbyname") }
-};
-static CRITICAL_SECTION cs_gethostbyname = { &critsect_debug, -1, 0, 0, 0, 0 };
-
-#endif
-
 /* translate a unix error code into a winsock error code */
 static int sock_get_error( int err )
 {
@@ -279,9 +266,6 @@ void netconn_unload( void )
     if(cred_handle_initialized)
         FreeCredentialsHandle(&cred_handle);
     DeleteCriticalSection(&init_sechandle_cs);
-#ifndef HAVE_GETADDRINFO
-    DeleteCriticalSection(&cs_gethostbyname);
-#endif
 }
 
 BOOL netconn_connected( netconn_t *conn )
@@ -289,6 +273,20 @@ BOOL netconn_connected( netconn_t *conn )
     return (conn->socket != -1);
 }
 
+/* an idle keep-alive connection must have nothing to read; data or EOF
+   means the server closed it or sent something we can't match to a request */
+BOOL netconn_is_alive( netconn_t *conn )
+{
+    struct pollfd pfd;
+
+    if (conn->socket == -1) return FALSE;
+    if (conn->peek_len || conn->extra_len) return FALSE;
+
+    pfd.fd = conn->socket;
+    pfd.events = POLLIN;
+    return !poll( &pfd, 1, 0 );
+}
+
 BOOL netconn_create( netconn_t *conn, int domain, int type, int protocol )
 {
     if ((conn->socket = socket( domain, type, protocol )) == -1)
@@ -369,8 +367,9 @@ BOOL netconn_connect( netconn_t *conn, const struct sockaddr *sockaddr, unsigned
     return ret;
 }
 
-BOOL netconn_secure_connect( netconn_t *conn, WCHAR *hostname )
+BOOL netconn_secure_connect( netconn_t *conn, WCHAR *hostname, INTERNET_PORT port )
 {
+    static const WCHAR target_fmt[] = {'%','s',':','%','u',0};
     SecBuffer out_buf = {0, SECBUFFER_TOKEN, NULL}, in_bufs[2] = {{0, SECBUFFER_TOKEN}, {0, SECBUFFER_EMPTY}};
     SecBufferDesc out_desc = {SECBUFFER_VERSION, 1, &out_buf}, in_desc = {SECBUFFER_VERSION, 2, in_bufs};
     BYTE *read_buf;
@@ -381,6 +380,7 @@ BOOL netconn_secure_connect( netconn_t *conn, WCHAR *hostname )
     const CERT_CONTEXT *cert;
     SECURITY_STATUS status;
     DWORD res = ERROR_SUCCESS;
+    WCHAR *target;
 
     const DWORD isc_req_flags = ISC_REQ_ALLOCATE_MEMORY|ISC_REQ_USE_SESSION_KEY|ISC_REQ_CONFIDENTIALITY
         |ISC_REQ_SEQUENCE_DETECT|ISC_REQ_REPLAY_DETECT|ISC_REQ_MANUAL_CRED_VALIDATION;
@@ -388,11 +388,19 @@ BOOL netconn_secure_connect( netconn_t *conn, WCHAR *hostname )
     if(!ensure_cred_handle())
         return FALSE;
 
+    /* schannel resumes sessions of the same target, the port keeps servers sharing a host name apart */
+    target = heap_alloc((strlenW(hostname) + 7) * sizeof(WCHAR)); /* sizeof(":65535") */
+    if(!target)
+        return FALSE;
+    sprintfW(target, target_fmt, hostname, port);
+
     read_buf = heap_alloc(read_buf_size);
-    if(!read_buf)
+    if(!read_buf) {
+        heap_free(target);
         return FALSE;
+    }
 
-    status = InitializeSecurityContextW(&cred_handle, NULL, hostname, isc_req_flags, 0, 0, NULL, 0,
+    status = InitializeSecurityContextW(&cred_handle, NULL, target, isc_req_flags, 0, 0, NULL, 0,
             &ctx, &out_desc, &attrs, NULL);
 
     assert(status != SEC_E_OK);
@@ -453,7 +461,7 @@ BOOL netconn_secure_connect( netconn_t *conn, WCHAR *hostname )
 
         in_bufs[0].cbBuffer += size;
         in_bufs[0].pvBuffer = read_buf;
-        status = InitializeSecurityContextW(&cred_handle, &ctx, hostname,  isc_req_flags, 0, 0, &in_desc,
+        status = InitializeSecurityContextW(&cred_handle, &ctx, target,  isc_req_flags, 0, 0, &in_desc,
                 0, NULL, &out_desc, &attrs, NULL);
         TRACE("InitializeSecurityContext ret %08x\n", status);
 
@@ -488,6 +496,7 @@ BOOL netconn_secure_connect( netconn_t *conn, WCHAR *hostname )
         }
     }
 
+    heap_free(target);
 
     if(status != SEC_E_OK || res != ERROR_SUCCESS) {
         WARN("Failed to initialize security context failed: %08x\n", status);
@@ -747,126 +756,175 @@ DWORD netconn_set_timeout( netconn_t *netconn, BOOL send, int value )
     return ERROR_SUCCESS;
 }
 
-static DWORD resolve_hostname( const WCHAR *hostnameW, INTERNET_PORT port, struct sockaddr *sa, socklen_t *sa_len )
+/* Names are resolved through ws2_32, which caches lookups for the whole
+ * process. It's loaded at runtime since its exports would otherwise shadow
+ * the Unix socket functions used here. */
+static int  (WINAPI *pGetAddrInfoW)( const WCHAR *, const WCHAR *, const ADDRINFOW *, ADDRINFOW ** );
+static void (WINAPI *pFreeAddrInfoW)( ADDRINFOW * );
+static INIT_ONCE resolver_init_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL WINAPI init_resolver( INIT_ONCE *once, void *param, void **context )
 {
-    char *hostname;
-#ifdef HAVE_GETADDRINFO
-    struct addrinfo *res, hints;
+    static const WCHAR ws2_32W[] = {'w','s','2','_','3','2','.','d','l','l',0};
+    HMODULE module;
+
+    if (!(module = LoadLibraryW( ws2_32W ))) return FALSE;
+    pGetAddrInfoW = (void *)GetProcAddress( module, "GetAddrInfoW" );
+    pFreeAddrInfoW = (void *)GetProcAddress( module, "FreeAddrInfoW" );
+    return pGetAddrInfoW && pFreeAddrInfoW;
+}
+
+static DWORD resolve_hostname( const WCHAR *hostname, INTERNET_PORT port, struct sockaddr *sa, socklen_t *sa_len )
+{
+    ADDRINFOW *res, hints;
     int ret;
-#else
-    struct hostent *he;
-    struct sockaddr_in *sin = (struct sockaddr_in *)sa;
-#endif
 
-    if (!(hostname = strdupWA( hostnameW ))) return ERROR_OUTOFMEMORY;
+    if (!InitOnceExecuteOnce( &resolver_init_once, init_resolver, NULL, NULL ))
+    {
+        ERR("failed to load ws2_32\n");
+        return ERROR_WINHTTP_NAME_NOT_RESOLVED;
+    }
 
-#ifdef HAVE_GETADDRINFO
-    memset( &hints, 0, sizeof(struct addrinfo) );
+    memset( &hints, 0, sizeof(hints) );
     /* Prefer IPv4 to IPv6 addresses, since some web servers do not listen on
      * their IPv6 addresses even though they have IPv6 addresses in the DNS.
      */
-    hints.ai_family = AF_INET;
+    hints.ai_family = WS_AF_INET;
 
-    ret = getaddrinfo( hostname, NULL, &hints, &res );
+    ret = pGetAddrInfoW( hostname, NULL, &hints, &res );
     if (ret != 0)
     {
-        TRACE("failed to get IPv4 address of %s (%s), retrying with IPv6\n", debugstr_w(hostnameW), gai_strerror(ret));
-        hints.ai_family = AF_INET6;
-        ret = getaddrinfo( hostname, NULL, &hints, &res );
+        TRACE("failed to get IPv4 address of %s (%d), retrying with IPv6\n", debugstr_w(hostname), ret);
+        hints.ai_family = WS_AF_INET6;
+        ret = pGetAddrInfoW( hostname, NULL, &hints, &res );
         if (ret != 0)
         {
-            TRACE("failed to get address of %s (%s)\n", debugstr_w(hostnameW), gai_strerror(ret));
-            heap_free( hostname );
+            TRACE("failed to get address of %s (%d)\n", debugstr_w(hostname), ret);
             return ERROR_WINHTTP_NAME_NOT_RESOLVED;
         }
     }
-    heap_free( hostname );
-    if (*sa_len < res->ai_addrlen)
-    {
-        WARN("address too small\n");
-        freeaddrinfo( res );
-        return ERROR_WINHTTP_NAME_NOT_RESOLVED;
-    }
-    *sa_len = res->ai_addrlen;
-    memcpy( sa, res->ai_addr, res->ai_addrlen );
-    /* Copy port */
+
     switch (res->ai_family)
     {
-    case AF_INET:
-        ((struct sockaddr_in *)sa)->sin_port = htons( port );
-        break;
-    case AF_INET6:
-        ((struct sockaddr_in6 *)sa)->sin6_port = htons( port );
-        break;
-    }
-
-    freeaddrinfo( res );
-    return ERROR_SUCCESS;
-#else
-    EnterCriticalSection( &cs_gethostbyname );
-
-    he = gethostbyname( hostname );
-    heap_free( hostname );
-    if (!he)
+    case WS_AF_INET:
     {
-        TRACE("failed to get address of %s (%d)\n", debugstr_w(hostnameW), h_errno);
-        LeaveCriticalSection( &cs_gethostbyname );
-        return ERROR_WINHTTP_NAME_NOT_RESOLVED;
+        struct sockaddr_in *sin = (struct sockaddr_in *)sa;
+        const struct WS_sockaddr_in *ws_sin = (const struct WS_sockaddr_in *)res->ai_addr;
+
+        if (*sa_len < sizeof(*sin)) break;
+        memset( sin, 0, sizeof(*sin) );
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons( port );
+        memcpy( &sin->sin_addr, &ws_sin->sin_addr, sizeof(sin->sin_addr) );
+        *sa_len = sizeof(*sin);
+        pFreeAddrInfoW( res );
+        return ERROR_SUCCESS;
     }
-    if (*sa_len < sizeof(struct sockaddr_in))
+    case WS_AF_INET6:
     {
-        WARN("address too small\n");
-        LeaveCriticalSection( &cs_gethostbyname );
-        return ERROR_WINHTTP_NAME_NOT_RESOLVED;
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)sa;
+        const struct WS_sockaddr_in6 *ws_sin6 = (const struct WS_sockaddr_in6 *)res->ai_addr;
+
+        if (*sa_len < sizeof(*sin6)) break;
+        memset( sin6, 0, sizeof(*sin6) );
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons( port );
+        sin6->sin6_flowinfo = ws_sin6->sin6_flowinfo;
+        sin6->sin6_scope_id = ws_sin6->sin6_scope_id;
+        memcpy( &sin6->sin6_addr, &ws_sin6->sin6_addr, sizeof(sin6->sin6_addr) );
+        *sa_len = sizeof(*sin6);
+        pFreeAddrInfoW( res );
+        return ERROR_SUCCESS;
+    }
     }
-    *sa_len = sizeof(struct sockaddr_in);
-    memset( sa, 0, sizeof(struct sockaddr_in) );
-    memcpy( &sin->sin_addr, he->h_addr, he->h_length );
-    sin->sin_family = he->h_addrtype;
-    sin->sin_port = htons( port );
 
-    LeaveCriticalSection( &cs_gethostbyname );
-    return ERROR_SUCCESS;
-#endif
+    WARN("address too small\n");
+    pFreeAddrInfoW( res );
+    return ERROR_WINHTTP_NAME_NOT_RESOLVED;
 }
 
+/* shared with the worker, which may still run after the caller timed out */
 struct resolve_args
 {
-    const WCHAR     *hostname;
-    INTERNET_PORT    port;
-    struct sockaddr *sa;
-    socklen_t       *sa_len;
+    LONG                    refs;
+    HANDLE                  done;
+    WCHAR                  *hostname;
+    INTERNET_PORT           port;
+    struct sockaddr_storage addr;
+    socklen_t               addr_len;
+    DWORD                   result;
 };
 
+static void release_resolve_args( struct resolve_args *ra )
+{
+    if (InterlockedDecrement( &ra->refs )) return;
+    if (ra->done) CloseHandle( ra->done );
+    heap_free( ra->hostname );
+    heap_free( ra );
+}
+
 static DWORD CALLBACK resolve_proc( LPVOID arg )
 {
     struct resolve_args *ra = arg;
-    return resolve_hostname( ra->hostname, ra->port, ra->sa, ra->sa_len );
+
+    ra->addr_len = sizeof(ra->addr);
+    ra->result = resolve_hostname( ra->hostname, ra->port, (struct sockaddr *)&ra->addr, &ra->addr_len );
+    SetEvent( ra->done );
+    release_resolve_args( ra );
+    return 0;
 }
 
-BOOL netconn_resolve( WCHAR *hostname, INTERNET_PORT port, struct sockaddr *sa, socklen_t *sa_len, int timeout )
+static DWORD resolve_hostname_timeout( WCHAR *hostname, INTERNET_PORT port, struct sockaddr *sa, socklen_t *sa_len,
+                                       int timeout )
 {
+    struct resolve_args *ra;
     DWORD ret;
 
-    if (timeout)
+    if (!(ra = heap_alloc_zero( sizeof(*ra) ))) return ERROR_OUTOFMEMORY;
+    ra->refs = 1;
+    ra->port = port;
+    if (!(ra->hostname = strdupW( hostname )) || !(ra->done = CreateEventW( NULL, TRUE, FALSE, NULL )))
     {
-        DWORD status;
-        HANDLE thread;
-        struct resolve_args ra;
-
-        ra.hostname = hostname;
-        ra.port     = port;
-        ra.sa       = sa;
-        ra.sa_len   = sa_len;
+        release_resolve_args( ra );
+        return ERROR_OUTOFMEMORY;
+    }
 
-        thread = CreateThread( NULL, 0, resolve_proc, &ra, 0, NULL );
-        if (!thread) return FALSE;
+    /* Lookups run on the process thread pool instead of a thread of their own.
+     * The pool already bounds and reuses its threads, so winhttp doesn't keep a
+     * fixed set of resolver threads; concurrent lookups of one name are merged
+     * by the ws2_32 cache. */
+    ra->refs++;
+    if (!QueueUserWorkItem( resolve_proc, ra, WT_EXECUTELONGFUNCTION ))
+    {
+        ret = GetLastError();
+        ra->refs--;
+        release_resolve_args( ra );
+        return ret;
+    }
 
-        status = WaitForSingleObject( thread, timeout );
-        if (status == WAIT_OBJECT_0) GetExitCodeThread( thread, &ret );
-        else ret = ERROR_WINHTTP_TIMEOUT;
-        CloseHandle( thread );
+    if (WaitForSingleObject( ra->done, timeout ) == WAIT_OBJECT_0)
+    {
+        if (!(ret = ra->result))
+        {
+            if (*sa_len < ra->addr_len) ret = ERROR_WINHTTP_NAME_NOT_RESOLVED;
+            else
+            {
+                memcpy( sa, &ra->addr, ra->addr_len );
+                *sa_len = ra->addr_len;
+            }
+        }
     }
+    else ret = ERROR_WINHTTP_TIMEOUT;
+
+    release_resolve_args( ra );
+    return ret;
+}
+
+BOOL netconn_resolve( WCHAR *hostname, INTERNET_PORT port, struct sockaddr *sa, socklen_t *sa_len, int timeout )
+{
+    DWORD ret;
+
+    if (timeout) ret = resolve_hostname_timeout( hostname, port, sa, sa_len, timeout );
     else ret = resolve_hostname( hostname, port, sa, sa_len );
 
     if (ret)
@@ -936,7 +936,131 @@ static WCHAR *addr_to_str( const struct sockaddr *addr )
     return strdupAW( buf );
 }
 
-static BOOL open_connection( request_t *request )
+#define MAX_IDLE_CONNECTIONS     16
+#define IDLE_CONNECTION_TIMEOUT  30000
+
+static void free_idle_connection( idle_conn_t *conn )
+{
+    netconn_close( &conn->netconn );
+    heap_free( conn->hostname );
+    heap_free( conn->servername );
+    heap_free( conn );
+}
+
+/* caller must hold the pool lock */
+static void expire_idle_connections( session_t *session )
+{
+    idle_conn_t *conn, *next;
+    DWORD now = GetTickCount();
+
+    LIST_FOR_EACH_ENTRY_SAFE( conn, next, &session->idle_conns, idle_conn_t, entry )
+    {
+        if (now - conn->idle_since < IDLE_CONNECTION_TIMEOUT) continue;
+        TRACE("closing idle connection to %s\n", debugstr_w(conn->servername));
+        list_remove( &conn->entry );
+        free_idle_connection( conn );
+    }
+}
+
+void free_idle_connections( session_t *session )
+{
+    idle_conn_t *conn, *next;
+
+    EnterCriticalSection( &session->pool_cs );
+    LIST_FOR_EACH_ENTRY_SAFE( conn, next, &session->idle_conns, idle_conn_t, entry )
+    {
+        list_remove( &conn->entry );
+        free_idle_connection( conn );
+    }
+    LeaveCriticalSection( &session->pool_cs );
+}
+
+static BOOL get_idle_connection( request_t *request, INTERNET_PORT port )
+{
+    connect_t *connect = request->connect;
+    session_t *session = connect->session;
+    BOOL secure = !!(request->hdr.flags & WINHTTP_FLAG_SECURE);
+    idle_conn_t *conn, *next, *found = NULL;
+
+    EnterCriticalSection( &session->pool_cs );
+    expire_idle_connections( session );
+    LIST_FOR_EACH_ENTRY_SAFE( conn, next, &session->idle_conns, idle_conn_t, entry )
+    {
+        if (conn->port != port || conn->secure != secure) continue;
+        /* certificate errors were checked against the flags of the original request */
+        if (conn->netconn.security_flags != request->netconn.security_flags) continue;
+        if (strcmpiW( conn->servername, connect->servername ) ||
+            strcmpiW( conn->hostname, connect->hostname )) continue;
+
+        list_remove( &conn->entry );
+        if (netconn_is_alive( &conn->netconn ))
+        {
+            found = conn;
+            break;
+        }
+        free_idle_connection( conn );
+    }
+    LeaveCriticalSection( &session->pool_cs );
+
+    if (!found) return FALSE;
+
+    TRACE("reusing connection to %s:%u\n", debugstr_w(found->servername), port);
+    request->netconn = found->netconn;
+    request->netconn_reused = TRUE;
+    heap_free( found->hostname );
+    heap_free( found->servername );
+    heap_free( found );
+
+    netconn_set_timeout( &request->netconn, TRUE, request->send_timeout );
+    netconn_set_timeout( &request->netconn, FALSE, request->recv_timeout );
+    return TRUE;
+}
+
+/* hand a keep-alive connection over to the session once its response has been read */
+static BOOL put_idle_connection( request_t *request )
+{
+    connect_t *connect = request->connect;
+    session_t *session = connect->session;
+    idle_conn_t *conn;
+    DWORD security_flags = request->netconn.security_flags;
+    unsigned int count = 0;
+    struct list *entry;
+
+    if (!request->netconn_reusable || request->read_pos != request->read_size) return FALSE;
+    if (!netconn_connected( &request->netconn )) return FALSE;
+
+    if (!(conn = heap_alloc( sizeof(*conn) ))) return FALSE;
+    if (!(conn->hostname = strdupW( connect->hostname )) ||
+        !(conn->servername = strdupW( connect->servername )))
+    {
+        heap_free( conn->hostname );
+        heap_free( conn );
+        return FALSE;
+    }
+    conn->port = connect->serverport ? connect->serverport : (request->hdr.flags & WINHTTP_FLAG_SECURE ? 443 : 80);
+    conn->secure = !!(request->hdr.flags & WINHTTP_FLAG_SECURE);
+    conn->idle_since = GetTickCount();
+    conn->netconn = request->netconn;
+
+    netconn_init( &request->netconn );
+    request->netconn.security_flags = security_flags;
+    request->netconn_reusable = FALSE;
+
+    EnterCriticalSection( &session->pool_cs );
+    expire_idle_connections( session );
+    list_add_head( &session->idle_conns, &conn->entry );
+    LIST_FOR_EACH( entry, &session->idle_conns ) count++;
+    if (count > MAX_IDLE_CONNECTIONS)
+    {
+        conn = LIST_ENTRY( list_tail( &session->idle_conns ), idle_conn_t, entry );
+        list_remove( &conn->entry );
+        free_idle_connection( conn );
+    }
+    LeaveCriticalSection( &session->pool_cs );
+    return TRUE;
+}
+
+static BOOL open_connection( request_t *request, BOOL reuse )
 {
     connect_t *connect;
     WCHAR *addressW = NULL;
@@ -952,6 +1076,8 @@ static BOOL open_connection( request_t *request )
     saddr = (struct sockaddr *)&connect->sockaddr;
     slen = sizeof(struct sockaddr);
 
+    if (reuse && get_idle_connection( request, port )) goto done;
+
     if (!connect->resolved)
     {
         len = strlenW( connect->servername ) + 1;
@@ -993,7 +1119,7 @@ static BOOL open_connection( request_t *request )
                 return FALSE;
             }
         }
-        if (!netconn_secure_connect( &request->netconn, connect->servername ))
+        if (!netconn_secure_connect( &request->netconn, connect->servername, port ))
         {
             netconn_close( &request->netconn );
             heap_free( addressW );
@@ -1002,12 +1128,14 @@ static BOOL open_connection( request_t *request )
     }
 
     send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_CONNECTED_TO_SERVER, addressW, strlenW(addressW) + 1 );
+    request->netconn_reused = FALSE;
 
 done:
     request->read_pos = request->read_size = 0;
     request->read_chunked = FALSE;
     request->read_chunked_size = ~0u;
     request->read_chunked_eof = FALSE;
+    request->netconn_reusable = FALSE;
     heap_free( addressW );
     return TRUE;
 }
@@ -1015,6 +1143,7 @@ done:
 void close_connection( request_t *request )
 {
     if (!netconn_connected( &request->netconn )) return;
+    if (put_idle_connection( request )) return;
 
     send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_CLOSING_CONNECTION, 0, 0 );
     netconn_close( &request->netconn );
@@ -1114,7 +1243,7 @@ static BOOL send_request( request_t *request, LPCWSTR headers, DWORD headers_len
 
     if (context) request->hdr.context = context;
 
-    if (!(ret = open_connection( request ))) goto end;
+    if (!(ret = open_connection( request, TRUE ))) goto end;
     if (!(req = build_request_string( request ))) goto end;
 
     if (!(req_ascii = strdupWA( req ))) goto end;
@@ -1123,17 +1252,28 @@ static BOOL send_request( request_t *request, LPCWSTR headers, DWORD headers_len
 
     send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_SENDING_REQUEST, NULL, 0 );
 
-    ret = netconn_send( &request->netconn, req_ascii, len, &bytes_sent );
+    for (;;)
+    {
+        ret = netconn_send( &request->netconn, req_ascii, len, &bytes_sent );
+        if (ret && optional_len) ret = netconn_send( &request->netconn, optional, optional_len, &bytes_sent );
+        if (ret || !request->netconn_reused) break;
+
+        /* the server may have closed the idle connection just as it was reused */
+        TRACE("retrying on a new connection\n");
+        netconn_close( &request->netconn );
+        if (!(ret = open_connection( request, FALSE ))) break;
+    }
     heap_free( req_ascii );
     if (!ret) goto end;
 
     if (optional_len)
     {
-        if (!netconn_send( &request->netconn, optional, optional_len, &bytes_sent )) goto end;
         request->optional = optional;
         request->optional_len = optional_len;
         len += optional_len;
     }
+    /* whole request is known, it can be sent again if the response doesn't come */
+    request->netconn_resend = request->netconn_reused && total_len <= optional_len;
     send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_REQUEST_SENT, &len, sizeof(len) );
 
 end:
@@ -2100,6 +2240,7 @@ static void finished_reading( request_t *request )
     }
     else if (!strcmpW( request->version, http1_0 )) close = TRUE;
     if (close) close_connection( request );
+    else request->netconn_reusable = TRUE;
 }
 
 static BOOL read_data( request_t *request, void *buffer, DWORD size, DWORD *read, BOOL async )
@@ -2238,14 +2379,14 @@ static BOOL handle_redirect( request_t *request, DWORD status )
             connect->hostport = port;
             if (!(ret = set_server_for_hostname( connect, hostname, port ))) goto end;
 
-            netconn_close( &request->netconn );
+            if (!put_idle_connection( request )) netconn_close( &request->netconn );
             if (!(ret = netconn_init( &request->netconn ))) goto end;
             request->read_pos = request->read_size = 0;
             request->read_chunked = FALSE;
             request->read_chunked_eof = FALSE;
         }
         if (!(ret = add_host_header( request, WINHTTP_ADDREQ_FLAG_REPLACE ))) goto end;
-        if (!(ret = open_connection( request ))) goto end;
+        if (!(ret = open_connection( request, TRUE ))) goto end;
 
         heap_free( request->path );
         request->path = NULL;
@@ -2286,6 +2427,15 @@ static BOOL receive_response( request_t *request, BOOL async )
     {
         if (!(ret = read_reply( request )))
         {
+            if (request->netconn_resend)
+            {
+                /* the server may have closed the idle connection just as it was reused */
+                TRACE("retrying on a new connection\n");
+                request->netconn_resend = FALSE;
+                netconn_close( &request->netconn );
+                if (open_connection( request, FALSE ) &&
+                    send_request( request, NULL, 0, request->optional, request->optional_len, 0, 0, FALSE )) continue;
+            }
             set_last_error( ERROR_WINHTTP_INVALID_SERVER_RESPONSE );
             break;
         }
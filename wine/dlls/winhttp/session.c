@@ -94,6 +94,9 @@ static void session_destroy( object_header_t *hdr )
         domain = LIST_ENTRY( item, domain_t, entry );
         delete_domain( domain );
     }
+    free_idle_connections( session );
+    session->pool_cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection( &session->pool_cs );
     heap_free( session->agent );
     heap_free( session->proxy_server );
     heap_free( session->proxy_bypass );
@@ -227,6 +230,9 @@ HINTERNET WINAPI WinHttpOpen( LPCWSTR agent, DWORD access, LPCWSTR proxy, LPCWST
     session->send_timeout = DEFAULT_SEND_TIMEOUT;
     session->recv_timeout = DEFAULT_RECEIVE_TIMEOUT;
     list_init( &session->cookie_cache );
+    list_init( &session->idle_conns );
+    InitializeCriticalSection( &session->pool_cs );
+    session->pool_cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": session.pool_cs");
 
     if (agent && !(session->agent = strdupW( agent ))) goto end;
     if (access == WINHTTP_ACCESS_TYPE_DEFAULT_PROXY)
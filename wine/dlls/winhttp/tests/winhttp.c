@@ -1794,12 +1794,21 @@ static const char proxymsg[] =
 "Proxy-Authenticate: Basic realm=\"placebo\"\r\n"
 "\r\n";
 
+static const char keepalivemsg[] =
+"HTTP/1.1 200 OK\r\n"
+"Server: winetest\r\n"
+"Content-Length: 2\r\n"
+"\r\n"
+"ok";
+
 struct server_info
 {
     HANDLE event;
     int port;
 };
 
+static LONG server_connections;
+
 #define BIG_BUFFER_LEN 0x2250
 
 static DWORD CALLBACK server_thread(LPVOID param)
@@ -1835,7 +1844,9 @@ static DWORD CALLBACK server_thread(LPVOID param)
     do
     {
         c = accept(s, NULL, NULL);
+        InterlockedIncrement(&server_connections);
 
+next_request:
         memset(buffer, 0, sizeof buffer);
         for(i = 0; i < sizeof buffer - 1; i++)
         {
@@ -1870,6 +1881,11 @@ static DWORD CALLBACK server_thread(LPVOID param)
         {
             send(c, page1, sizeof page1 - 1, 0);
         }
+        if (strstr(buffer, "/keepalive"))
+        {
+            send(c, keepalivemsg, sizeof keepalivemsg - 1, 0);
+            goto next_request;
+        }
         if (strstr(buffer, "GET /quit"))
         {
             send(c, okmsg, sizeof okmsg - 1, 0);
@@ -2187,6 +2203,54 @@ static void test_multiple_reads(int port)
     WinHttpCloseHandle(ses);
 }
 
+static void test_keep_alive( int port )
+{
+    static const WCHAR keepaliveW[] = {'/','k','e','e','p','a','l','i','v','e',0};
+    static const int count = 200;
+    HINTERNET ses, con, req;
+    DWORD bytes_read, start, elapsed;
+    LONG connections;
+    char buffer[16];
+    BOOL ret;
+    int i;
+
+    ses = WinHttpOpen( test_useragent, 0, NULL, NULL, 0 );
+    ok( ses != NULL, "failed to open session %u\n", GetLastError() );
+
+    con = WinHttpConnect( ses, localhostW, port, 0 );
+    ok( con != NULL, "failed to open a connection %u\n", GetLastError() );
+
+    connections = server_connections;
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        /* a new request handle each time, the connection has to come from the session */
+        req = WinHttpOpenRequest( con, NULL, keepaliveW, NULL, NULL, NULL, 0 );
+        ok( req != NULL, "failed to open a request %u\n", GetLastError() );
+
+        ret = WinHttpSendRequest( req, NULL, 0, NULL, 0, 0, 0 );
+        ok( ret, "%d: failed to send request %u\n", i, GetLastError() );
+
+        ret = WinHttpReceiveResponse( req, NULL );
+        ok( ret, "%d: failed to receive response %u\n", i, GetLastError() );
+
+        bytes_read = 0;
+        memset( buffer, 0, sizeof(buffer) );
+        ret = WinHttpReadData( req, buffer, sizeof(buffer), &bytes_read );
+        ok( ret, "%d: failed to read data %u\n", i, GetLastError() );
+        ok( bytes_read == 2 && !memcmp( buffer, "ok", 2 ), "%d: got %u %s\n", i, bytes_read, buffer );
+
+        WinHttpCloseHandle( req );
+    }
+    elapsed = GetTickCount() - start;
+    trace( "%d keep-alive requests took %u ms\n", count, elapsed );
+
+    ok( server_connections - connections == 1, "got %d connections\n", server_connections - connections );
+
+    WinHttpCloseHandle( con );
+    WinHttpCloseHandle( ses );
+}
+
 static void test_connection_info( int port )
 {
     static const WCHAR basicW[] = {'/','b','a','s','i','c',0};
@@ -3097,6 +3161,7 @@ START_TEST (winhttp)
     test_basic_authentication(si.port);
     test_bad_header(si.port);
     test_multiple_reads(si.port);
+    test_keep_alive(si.port);
 
     /* send the basic request again to shutdown the server thread */
     test_basic_request(si.port, NULL, quitW);
@@ -110,6 +110,8 @@ typedef struct
     LPWSTR proxy_username;
     LPWSTR proxy_password;
     struct list cookie_cache;
+    CRITICAL_SECTION pool_cs;
+    struct list idle_conns; /* keep-alive connections not owned by a request */
 } session_t;
 
 typedef struct
@@ -141,6 +143,17 @@ typedef struct
     DWORD security_flags;
 } netconn_t;
 
+typedef struct
+{
+    struct list entry;
+    WCHAR *hostname;
+    WCHAR *servername;
+    INTERNET_PORT port;
+    BOOL secure;
+    DWORD idle_since;
+    netconn_t netconn;
+} idle_conn_t;
+
 typedef struct
 {
     LPWSTR field;
@@ -182,6 +195,9 @@ typedef struct
     void *optional;
     DWORD optional_len;
     netconn_t netconn;
+    BOOL netconn_reusable; /* response fully read on a keep-alive connection */
+    BOOL netconn_reused;   /* connection was taken from the session pool */
+    BOOL netconn_resend;   /* request can be sent again if the reused connection fails */
     int resolve_timeout;
     int connect_timeout;
     int send_timeout;
@@ -259,17 +275,19 @@ void set_last_error( DWORD ) DECLSPEC_HIDDEN;
 DWORD get_last_error( void ) DECLSPEC_HIDDEN;
 void send_callback( object_header_t *, DWORD, LPVOID, DWORD ) DECLSPEC_HIDDEN;
 void close_connection( request_t * ) DECLSPEC_HIDDEN;
+void free_idle_connections( session_t * ) DECLSPEC_HIDDEN;
 
 BOOL netconn_close( netconn_t * ) DECLSPEC_HIDDEN;
 BOOL netconn_connect( netconn_t *, const struct sockaddr *, unsigned int, int ) DECLSPEC_HIDDEN;
 BOOL netconn_connected( netconn_t * ) DECLSPEC_HIDDEN;
 BOOL netconn_create( netconn_t *, int, int, int ) DECLSPEC_HIDDEN;
 BOOL netconn_init( netconn_t * ) DECLSPEC_HIDDEN;
+BOOL netconn_is_alive( netconn_t * ) DECLSPEC_HIDDEN;
 void netconn_unload( void ) DECLSPEC_HIDDEN;
 ULONG netconn_query_data_available( netconn_t * ) DECLSPEC_HIDDEN;
 BOOL netconn_recv( netconn_t *, void *, size_t, int, int * ) DECLSPEC_HIDDEN;
 BOOL netconn_resolve( WCHAR *, INTERNET_PORT, struct sockaddr *, socklen_t *, int ) DECLSPEC_HIDDEN;
-BOOL netconn_secure_connect( netconn_t *, WCHAR * ) DECLSPEC_HIDDEN;
+BOOL netconn_secure_connect( netconn_t *, WCHAR *, INTERNET_PORT ) DECLSPEC_HIDDEN;
 BOOL netconn_send( netconn_t *, const void *, size_t, int * ) DECLSPEC_HIDDEN;
 DWORD netconn_set_timeout( netconn_t *, BOOL, int ) DECLSPEC_HIDDEN;
 const void *netconn_get_certificate( netconn_t * ) DECLSPEC_HIDDEN;
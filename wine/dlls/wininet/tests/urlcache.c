@@ -1034,6 +1034,67 @@ static void test_GetDiskInfoA(void)
     ok(error == ERROR_INVALID_PARAMETER, "got %u expected ERROR_INVALID_PARAMETER\n", error);
 }
 
+#define CACHE_THREADS 4
+#define CACHE_ENTRIES_PER_THREAD 100
+
+static DWORD WINAPI urlcache_thread(void *param)
+{
+    static const FILETIME filetime_zero;
+    DWORD id = PtrToUlong(param), i, size, failures = 0;
+    char url[64], filename[MAX_PATH];
+    BYTE buf[4096];
+    INTERNET_CACHE_ENTRY_INFOA *info = (INTERNET_CACHE_ENTRY_INFOA *)buf;
+    BYTE data = 'x';
+    BOOL ret;
+
+    for (i = 0; i < CACHE_ENTRIES_PER_THREAD; i++)
+    {
+        sprintf(url, "http://urlcachetest.winehq.org/thread%u/%u.html", id, i);
+
+        ret = CreateUrlCacheEntryA(url, 0, "html", filename, 0);
+        if (!ret) { failures++; continue; }
+        create_and_write_file(filename, &data, sizeof(data));
+
+        ret = CommitUrlCacheEntryA(url, filename, filetime_zero, filetime_zero,
+                NORMAL_CACHE_ENTRY, NULL, 0, "html", NULL);
+        if (!ret) { failures++; DeleteFileA(filename); continue; }
+
+        size = sizeof(buf);
+        ret = RetrieveUrlCacheEntryFileA(url, info, &size, 0);
+        if (!ret || strcmp(info->lpszSourceUrlName, url) || lstrcmpiA(info->lpszLocalFileName, filename))
+            failures++;
+        if (ret && pUnlockUrlCacheEntryFileA)
+            pUnlockUrlCacheEntryFileA(url, 0);
+        if (pDeleteUrlCacheEntryA)
+            pDeleteUrlCacheEntryA(url);
+    }
+
+    return failures;
+}
+
+static void test_urlcache_threads(void)
+{
+    HANDLE threads[CACHE_THREADS];
+    DWORD i, start, exit_code;
+
+    start = GetTickCount();
+    for (i = 0; i < CACHE_THREADS; i++)
+    {
+        threads[i] = CreateThread(NULL, 0, urlcache_thread, ULongToPtr(i), 0, NULL);
+        ok(threads[i] != NULL, "CreateThread failed: %u\n", GetLastError());
+    }
+    WaitForMultipleObjects(CACHE_THREADS, threads, TRUE, INFINITE);
+    trace("%u threads committed and retrieved %u entries in %u ms\n", CACHE_THREADS,
+          CACHE_THREADS * CACHE_ENTRIES_PER_THREAD, GetTickCount() - start);
+
+    for (i = 0; i < CACHE_THREADS; i++)
+    {
+        ok(GetExitCodeThread(threads[i], &exit_code), "GetExitCodeThread failed: %u\n", GetLastError());
+        ok(!exit_code, "thread %u: %u failures\n", i, exit_code);
+        CloseHandle(threads[i]);
+    }
+}
+
 START_TEST(urlcache)
 {
     HMODULE hdll;
@@ -1057,4 +1118,5 @@ START_TEST(urlcache)
     test_urlcacheW();
     test_FindCloseUrlCache();
     test_GetDiskInfoA();
+    test_urlcache_threads();
 }
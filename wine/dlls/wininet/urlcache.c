@@ -196,6 +196,7 @@ typedef struct
     char *cache_prefix; /* string that has to be prefixed for this container to be used */
     LPWSTR path; /* path to url container directory */
     HANDLE mapping; /* handle of file mapping */
+    urlcache_header *header; /* view of mapping kept between locks, or NULL */
     DWORD file_size; /* size of file when mapping was opened */
     HANDLE mutex; /* handle of mutex */
     DWORD default_entry_type;
@@ -296,6 +297,14 @@ static DWORD urlcache_entry_alloc(urlcache_header *header, DWORD blocks_needed,
 
     for(block=0; block<header->capacity_in_blocks; block+=block_size+1)
     {
+        /* skip runs of fully allocated blocks a byte at a time */
+        if(!(block%CHAR_BIT)) {
+            while(block<header->capacity_in_blocks && header->allocation_table[block/CHAR_BIT]==0xff)
+                block += CHAR_BIT;
+            if(block >= header->capacity_in_blocks)
+                break;
+        }
+
         block_size = 0;
         while(block_size<blocks_needed && block_size+block<header->capacity_in_blocks
                 && urlcache_block_is_free(header->allocation_table, block+block_size))
@@ -694,6 +703,10 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
  */
 static void cache_container_close_index(cache_container *pContainer)
 {
+    if(pContainer->header) {
+        UnmapViewOfFile(pContainer->header);
+        pContainer->header = NULL;
+    }
     CloseHandle(pContainer->mapping);
     pContainer->mapping = NULL;
 }
@@ -710,6 +723,7 @@ static BOOL cache_containers_add(const char *cache_prefix, LPCWSTR path,
     }
 
     pContainer->mapping = NULL;
+    pContainer->header = NULL;
     pContainer->file_size = 0;
     pContainer->default_entry_type = default_entry_type;
 
@@ -908,29 +922,30 @@ static BOOL cache_containers_enum(char *search_pattern, DWORD index, cache_conta
 static urlcache_header* cache_container_lock_index(cache_container *pContainer)
 {
     BYTE index;
-    LPVOID pIndexData;
     urlcache_header* pHeader;
     DWORD error;
 
     /* acquire mutex */
     WaitForSingleObject(pContainer->mutex, INFINITE);
 
-    pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
-
-    if (!pIndexData)
+    /* the view is kept mapped between locks, so only map it the first time */
+    if (!pContainer->header)
     {
-        ReleaseMutex(pContainer->mutex);
-        ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
-        return NULL;
+        pContainer->header = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
+        if (!pContainer->header)
+        {
+            ReleaseMutex(pContainer->mutex);
+            ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
+            return NULL;
+        }
     }
-    pHeader = (urlcache_header*)pIndexData;
+    pHeader = pContainer->header;
 
     /* file has grown - we need to remap to prevent us getting
      * access violations when we try and access beyond the end
      * of the memory mapped file */
     if (pHeader->size != pContainer->file_size)
     {
-        UnmapViewOfFile( pHeader );
         cache_container_close_index(pContainer);
         error = cache_container_open_index(pContainer, MIN_BLOCK_NO);
         if (error != ERROR_SUCCESS)
@@ -939,15 +954,15 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
             SetLastError(error);
             return NULL;
         }
-        pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
+        pContainer->header = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
 
-        if (!pIndexData)
+        if (!pContainer->header)
         {
             ReleaseMutex(pContainer->mutex);
             ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
             return NULL;
         }
-        pHeader = (urlcache_header*)pIndexData;
+        pHeader = pContainer->header;
     }
 
     TRACE("Signature: %s, file size: %d bytes\n", pHeader->signature, pHeader->size);
@@ -963,12 +978,12 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
 /***********************************************************************
  *           cache_container_unlock_index (Internal)
  *
+ * The view stays mapped until the index is closed or grows.
  */
 static BOOL cache_container_unlock_index(cache_container *pContainer, urlcache_header *pHeader)
 {
     /* release mutex */
-    ReleaseMutex(pContainer->mutex);
-    return UnmapViewOfFile(pHeader);
+    return ReleaseMutex(pContainer->mutex);
 }
 
 /***********************************************************************
@@ -1180,7 +1195,7 @@ static BOOL urlcache_clean_leaked_entries(cache_container *container, urlcache_h
 static DWORD cache_container_clean_index(cache_container *container, urlcache_header **file_view)
 {
     urlcache_header *header = *file_view;
-    DWORD ret;
+    DWORD blocks_no, ret;
 
     TRACE("(%s %s)\n", debugstr_a(container->cache_prefix), debugstr_w(container->path));
 
@@ -1192,16 +1207,26 @@ static DWORD cache_container_clean_index(cache_container *container, urlcache_he
         return ERROR_NOT_ENOUGH_MEMORY;
     }
 
+    blocks_no = header->capacity_in_blocks*2;
+
+    /* the caller keeps using the old view if the index can't be remapped */
+    container->header = NULL;
     cache_container_close_index(container);
-    ret = cache_container_open_index(container, header->capacity_in_blocks*2);
-    if(ret != ERROR_SUCCESS)
+    ret = cache_container_open_index(container, blocks_no);
+    if(ret == ERROR_SUCCESS) {
+        container->header = MapViewOfFile(container->mapping, FILE_MAP_WRITE, 0, 0, 0);
+        if(!container->header)
+            ret = GetLastError();
+    }
+    if(ret != ERROR_SUCCESS) {
+        /* make the next lock unmap it and map the index again */
+        container->header = header;
+        container->file_size = 0;
         return ret;
-    header = MapViewOfFile(container->mapping, FILE_MAP_WRITE, 0, 0, 0);
-    if(!header)
-        return GetLastError();
+    }
 
-    UnmapViewOfFile(*file_view);
-    *file_view = header;
+    UnmapViewOfFile(header);
+    *file_view = container->header;
     return ERROR_SUCCESS;
 }
 
@@ -2499,9 +2524,14 @@ BOOL WINAPI FreeUrlCacheSpaceW(LPCWSTR cache_path, DWORD size, DWORD filter)
                 }
                 Sleep(0);
                 header = cache_container_lock_index(container);
+                if(!header)
+                    break;
             }
         }
 
+        if(!header)
+            continue;
+
         TRACE("cache size after cleaning 0x%s/0x%s\n",
                 wine_dbgstr_longlong(header->cache_usage.QuadPart+header->exempt_usage.QuadPart),
                 wine_dbgstr_longlong(header->cache_limit.QuadPart));
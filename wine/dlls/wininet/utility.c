@@ -42,21 +42,12 @@
 #include "wine/debug.h"
 #include "internet.h"
 
-WINE_DEFAULT_DEBUG_CHANNEL(wininet);
-
-#ifndef HAVE_GETADDRINFO
-
-/* critical section to protect non-reentrant gethostbyname() */
-static CRITICAL_SECTION cs_gethostbyname;
-static CRITICAL_SECTION_DEBUG critsect_debug =
-{
-    0, 0, &cs_gethostbyname,
-    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
-      0, 0, { (DWORD_PTR)(__FILE__ ": cs_gethostbyname") }
-};
-static CRITICAL_SECTION cs_gethostbyname = { &critsect_debug, -1, 0, 0, 0, 0 };
+/* to avoid conflicts with the Unix socket headers */
+#define USE_WS_PREFIX
+#include "winsock2.h"
+#include "ws2tcpip.h"
 
-#endif
+WINE_DEFAULT_DEBUG_CHANNEL(wininet);
 
 #define TIME_STRING_LEN  30
 
@@ -144,22 +135,40 @@ time_t ConvertTimeString(LPCWSTR asctime)
 }
 
 
+/* Names are resolved through ws2_32, which caches lookups for the whole
+ * process. It's loaded at runtime since its exports would otherwise shadow
+ * the Unix socket functions used by wininet. */
+static int  (WINAPI *pGetAddrInfoW)(const WCHAR *, const WCHAR *, const ADDRINFOW *, ADDRINFOW **);
+static void (WINAPI *pFreeAddrInfoW)(ADDRINFOW *);
+static INIT_ONCE resolver_init_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL WINAPI init_resolver(INIT_ONCE *once, void *param, void **context)
+{
+    static const WCHAR ws2_32W[] = {'w','s','2','_','3','2','.','d','l','l',0};
+    HMODULE module;
+
+    if (!(module = LoadLibraryW(ws2_32W))) return FALSE;
+    pGetAddrInfoW = (void *)GetProcAddress(module, "GetAddrInfoW");
+    pFreeAddrInfoW = (void *)GetProcAddress(module, "FreeAddrInfoW");
+    return pGetAddrInfoW && pFreeAddrInfoW;
+}
+
 BOOL GetAddress(LPCWSTR lpszServerName, INTERNET_PORT nServerPort,
 	struct sockaddr *psa, socklen_t *sa_len)
 {
-    WCHAR *found;
-    char *name;
-    int len, sz;
-#ifdef HAVE_GETADDRINFO
-    struct addrinfo *res, hints;
-    int ret;
-#else
-    struct hostent *phe;
-    struct sockaddr_in *sin = (struct sockaddr_in *)psa;
-#endif
+    ADDRINFOW *res, hints;
+    WCHAR *found, *name;
+    BOOL ret = FALSE;
+    int len, err;
 
     TRACE("%s\n", debugstr_w(lpszServerName));
 
+    if (!InitOnceExecuteOnce(&resolver_init_once, init_resolver, NULL, NULL))
+    {
+        ERR("failed to load ws2_32\n");
+        return FALSE;
+    }
+
     /* Validate server name first
      * Check if there is something like
      * pinger.macromedia.com:80
@@ -171,77 +180,65 @@ BOOL GetAddress(LPCWSTR lpszServerName, INTERNET_PORT nServerPort,
     else
         len = strlenW(lpszServerName);
 
-    sz = WideCharToMultiByte( CP_UNIXCP, 0, lpszServerName, len, NULL, 0, NULL, NULL );
-    if (!(name = heap_alloc(sz + 1))) return FALSE;
-    WideCharToMultiByte( CP_UNIXCP, 0, lpszServerName, len, name, sz, NULL, NULL );
-    name[sz] = 0;
+    if (!(name = heap_strndupW(lpszServerName, len))) return FALSE;
 
-#ifdef HAVE_GETADDRINFO
-    memset( &hints, 0, sizeof(struct addrinfo) );
+    memset( &hints, 0, sizeof(hints) );
     /* Prefer IPv4 to IPv6 addresses, since some servers do not listen on
      * their IPv6 addresses even though they have IPv6 addresses in the DNS.
      */
-    hints.ai_family = AF_INET;
+    hints.ai_family = WS_AF_INET;
 
-    ret = getaddrinfo( name, NULL, &hints, &res );
-    if (ret != 0)
+    err = pGetAddrInfoW( name, NULL, &hints, &res );
+    if (err != 0)
     {
-        TRACE("failed to get IPv4 address of %s (%s), retrying with IPv6\n", debugstr_w(lpszServerName), gai_strerror(ret));
-        hints.ai_family = AF_INET6;
-        ret = getaddrinfo( name, NULL, &hints, &res );
+        TRACE("failed to get IPv4 address of %s (%d), retrying with IPv6\n", debugstr_w(lpszServerName), err);
+        hints.ai_family = WS_AF_INET6;
+        err = pGetAddrInfoW( name, NULL, &hints, &res );
     }
     heap_free( name );
-    if (ret != 0)
-    {
-        TRACE("failed to get address of %s (%s)\n", debugstr_w(lpszServerName), gai_strerror(ret));
-        return FALSE;
-    }
-    if (*sa_len < res->ai_addrlen)
+    if (err != 0)
     {
-        WARN("address too small\n");
-        freeaddrinfo( res );
+        TRACE("failed to get address of %s (%d)\n", debugstr_w(lpszServerName), err);
         return FALSE;
     }
-    *sa_len = res->ai_addrlen;
-    memcpy( psa, res->ai_addr, res->ai_addrlen );
-    /* Copy port */
+
     switch (res->ai_family)
     {
-    case AF_INET:
-        ((struct sockaddr_in *)psa)->sin_port = htons(nServerPort);
-        break;
-    case AF_INET6:
-        ((struct sockaddr_in6 *)psa)->sin6_port = htons(nServerPort);
+    case WS_AF_INET:
+    {
+        struct sockaddr_in *sin = (struct sockaddr_in *)psa;
+        const struct WS_sockaddr_in *ws_sin = (const struct WS_sockaddr_in *)res->ai_addr;
+
+        if (*sa_len < sizeof(*sin)) break;
+        memset( sin, 0, sizeof(*sin) );
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(nServerPort);
+        memcpy( &sin->sin_addr, &ws_sin->sin_addr, sizeof(sin->sin_addr) );
+        *sa_len = sizeof(*sin);
+        ret = TRUE;
         break;
     }
-
-    freeaddrinfo( res );
-#else
-    EnterCriticalSection( &cs_gethostbyname );
-    phe = gethostbyname(name);
-    heap_free( name );
-
-    if (NULL == phe)
+    case WS_AF_INET6:
     {
-        TRACE("failed to get address of %s (%d)\n", debugstr_w(lpszServerName), h_errno);
-        LeaveCriticalSection( &cs_gethostbyname );
-        return FALSE;
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)psa;
+        const struct WS_sockaddr_in6 *ws_sin6 = (const struct WS_sockaddr_in6 *)res->ai_addr;
+
+        if (*sa_len < sizeof(*sin6)) break;
+        memset( sin6, 0, sizeof(*sin6) );
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons(nServerPort);
+        sin6->sin6_flowinfo = ws_sin6->sin6_flowinfo;
+        sin6->sin6_scope_id = ws_sin6->sin6_scope_id;
+        memcpy( &sin6->sin6_addr, &ws_sin6->sin6_addr, sizeof(sin6->sin6_addr) );
+        *sa_len = sizeof(*sin6);
+        ret = TRUE;
+        break;
     }
-    if (*sa_len < sizeof(struct sockaddr_in))
-    {
-        WARN("address too small\n");
-        LeaveCriticalSection( &cs_gethostbyname );
-        return FALSE;
     }
-    *sa_len = sizeof(struct sockaddr_in);
-    memset(sin,0,sizeof(struct sockaddr_in));
-    memcpy((char *)&sin->sin_addr, phe->h_addr, phe->h_length);
-    sin->sin_family = phe->h_addrtype;
-    sin->sin_port = htons(nServerPort);
+    if (!ret) WARN("address too small\n");
 
-    LeaveCriticalSection( &cs_gethostbyname );
-#endif
-    return TRUE;
+    pFreeAddrInfoW( res );
+    return ret;
 }
 
 /*
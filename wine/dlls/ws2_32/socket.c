@@ -154,6 +154,7 @@
 #include "wine/server.h"
 #include "wine/debug.h"
 #include "wine/exception.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 
 #ifdef HAS_IPX
@@ -4292,7 +4293,7 @@ static void release_poll_fds( const WS_fd_set *readfds, const WS_fd_set *writefd
             if (fds[j].fd != -1)
             {
                 /* make sure we have a real error before releasing the fd */
-                if (!sock_error_p( fds[j].fd )) fds[j].revents = 0;
+                if (fds[j].revents && !sock_error_p( fds[j].fd )) fds[j].revents = 0;
                 release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
             }
     }
@@ -5435,6 +5436,242 @@ static char *get_hostname(void)
     return ret;
 }
 
+#ifdef HAVE_GETADDRINFO
+
+/* Name lookups are cached for the whole process, and concurrent lookups of
+ * the same name wait for the one already in progress. getaddrinfo() doesn't
+ * report record TTLs, so fixed lifetimes are used for found and missing names. */
+#define DNS_CACHE_SIZE          128
+#define DNS_CACHE_POSITIVE_TTL  30000
+#define DNS_CACHE_NEGATIVE_TTL  5000
+#define DNS_CACHE_WAIT_TIMEOUT  5000 /* before a waiter gives up and resolves on its own */
+
+struct dns_entry
+{
+    struct list entry;
+    LONG refs;
+    char *node;
+    char *service;
+    BOOL has_hints;
+    int flags, family, socktype, protocol;
+    BOOL pending;     /* lookup still in progress, wait for the event */
+    HANDLE event;
+    int result;
+    struct addrinfo *ai;
+    DWORD expires;
+};
+
+static struct list dns_cache = LIST_INIT( dns_cache );
+static unsigned int dns_cache_count;
+
+static CRITICAL_SECTION dns_cache_cs;
+static CRITICAL_SECTION_DEBUG dns_cache_cs_debug =
+{
+    0, 0, &dns_cache_cs,
+    { &dns_cache_cs_debug.ProcessLocksList, &dns_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": dns_cache_cs") }
+};
+static CRITICAL_SECTION dns_cache_cs = { &dns_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static void free_addrinfo_copy( struct addrinfo *ai )
+{
+    while (ai)
+    {
+        struct addrinfo *next = ai->ai_next;
+        HeapFree( GetProcessHeap(), 0, ai );
+        ai = next;
+    }
+}
+
+/* each element is a single allocation holding the address and canonical name */
+static int copy_addrinfo( const struct addrinfo *src, struct addrinfo **ret )
+{
+    struct addrinfo **next = ret, *ai;
+    size_t len;
+
+    *ret = NULL;
+    for (; src; src = src->ai_next)
+    {
+        len = sizeof(*ai) + src->ai_addrlen;
+        if (src->ai_canonname) len += strlen( src->ai_canonname ) + 1;
+        if (!(ai = HeapAlloc( GetProcessHeap(), 0, len )))
+        {
+            free_addrinfo_copy( *ret );
+            *ret = NULL;
+            return EAI_MEMORY;
+        }
+        *ai = *src;
+        ai->ai_next = NULL;
+        ai->ai_addr = (struct sockaddr *)(ai + 1);
+        memcpy( ai->ai_addr, src->ai_addr, src->ai_addrlen );
+        if (src->ai_canonname)
+        {
+            ai->ai_canonname = (char *)ai->ai_addr + src->ai_addrlen;
+            strcpy( ai->ai_canonname, src->ai_canonname );
+        }
+        *next = ai;
+        next = &ai->ai_next;
+    }
+    return 0;
+}
+
+static void release_dns_entry( struct dns_entry *entry )
+{
+    if (InterlockedDecrement( &entry->refs )) return;
+    free_addrinfo_copy( entry->ai );
+    CloseHandle( entry->event );
+    HeapFree( GetProcessHeap(), 0, entry->node );
+    HeapFree( GetProcessHeap(), 0, entry->service );
+    HeapFree( GetProcessHeap(), 0, entry );
+}
+
+/* caller must hold dns_cache_cs */
+static void remove_dns_entry( struct dns_entry *entry )
+{
+    list_remove( &entry->entry );
+    dns_cache_count--;
+    release_dns_entry( entry );
+}
+
+static BOOL dns_entry_matches( const struct dns_entry *entry, const char *node, const char *service,
+                               const struct addrinfo *hints )
+{
+    if (strcasecmp( entry->node, node )) return FALSE;
+    if (!entry->service != !service || (service && strcmp( entry->service, service ))) return FALSE;
+    if (entry->has_hints != !!hints) return FALSE;
+    if (!hints) return TRUE;
+    return entry->flags == hints->ai_flags && entry->family == hints->ai_family &&
+           entry->socktype == hints->ai_socktype && entry->protocol == hints->ai_protocol;
+}
+
+static struct dns_entry *create_dns_entry( const char *node, const char *service, const struct addrinfo *hints )
+{
+    struct dns_entry *entry;
+
+    if (!(entry = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*entry) ))) return NULL;
+    entry->refs = 1;
+    entry->pending = TRUE;
+    if (!(entry->event = CreateEventW( NULL, TRUE, FALSE, NULL ))) goto failed;
+    if (!(entry->node = HeapAlloc( GetProcessHeap(), 0, strlen( node ) + 1 ))) goto failed;
+    strcpy( entry->node, node );
+    if (service)
+    {
+        if (!(entry->service = HeapAlloc( GetProcessHeap(), 0, strlen( service ) + 1 ))) goto failed;
+        strcpy( entry->service, service );
+    }
+    if ((entry->has_hints = (hints != NULL)))
+    {
+        entry->flags    = hints->ai_flags;
+        entry->family   = hints->ai_family;
+        entry->socktype = hints->ai_socktype;
+        entry->protocol = hints->ai_protocol;
+    }
+    return entry;
+
+failed:
+    release_dns_entry( entry );
+    return NULL;
+}
+
+static int cached_getaddrinfo( const char *node, const char *service, const struct addrinfo *hints,
+                               struct addrinfo **res )
+{
+    struct dns_entry *entry, *next, *found = NULL;
+    struct addrinfo *unixaires;
+    DWORD now, ttl;
+    int result;
+
+    *res = NULL;
+    if (!node)
+    {
+        if ((result = getaddrinfo( node, service, hints, &unixaires ))) return result;
+        result = copy_addrinfo( unixaires, res );
+        freeaddrinfo( unixaires );
+        return result;
+    }
+
+    EnterCriticalSection( &dns_cache_cs );
+    now = GetTickCount();
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &dns_cache, struct dns_entry, entry )
+    {
+        if (!entry->pending && (int)(entry->expires - now) <= 0)
+        {
+            remove_dns_entry( entry );
+            continue;
+        }
+        if (!found && dns_entry_matches( entry, node, service, hints )) found = entry;
+    }
+
+    if (found)
+    {
+        /* most recently used first */
+        list_remove( &found->entry );
+        list_add_head( &dns_cache, &found->entry );
+        InterlockedIncrement( &found->refs );
+        LeaveCriticalSection( &dns_cache_cs );
+
+        TRACE( "%s %s from cache%s\n", debugstr_a(node), debugstr_a(service), found->pending ? ", waiting" : "" );
+        /* don't get stuck behind a lookup that doesn't finish */
+        if (WaitForSingleObject( found->event, DNS_CACHE_WAIT_TIMEOUT ) == WAIT_OBJECT_0)
+        {
+            if (!(result = found->result)) result = copy_addrinfo( found->ai, res );
+            release_dns_entry( found );
+            return result;
+        }
+        WARN( "lookup of %s %s still pending, resolving directly\n", debugstr_a(node), debugstr_a(service) );
+        release_dns_entry( found );
+        entry = NULL;
+    }
+    else
+    {
+        if ((entry = create_dns_entry( node, service, hints )))
+        {
+            InterlockedIncrement( &entry->refs );
+            list_add_head( &dns_cache, &entry->entry );
+            if (++dns_cache_count > DNS_CACHE_SIZE)
+            {
+                LIST_FOR_EACH_ENTRY_SAFE_REV( found, next, &dns_cache, struct dns_entry, entry )
+                {
+                    if (found->pending) continue;
+                    remove_dns_entry( found );
+                    break;
+                }
+            }
+        }
+        LeaveCriticalSection( &dns_cache_cs );
+    }
+
+    /* getaddrinfo(3) is thread safe, no need to wrap in CS */
+    if (!(result = getaddrinfo( node, service, hints, &unixaires )))
+    {
+        result = copy_addrinfo( unixaires, res );
+        freeaddrinfo( unixaires );
+    }
+    if (!entry) return result;
+
+    /* transient failures are reported to the waiters but not kept */
+    if (!result) ttl = DNS_CACHE_POSITIVE_TTL;
+    else if (result == EAI_NONAME) ttl = DNS_CACHE_NEGATIVE_TTL;
+#ifdef EAI_NODATA
+    else if (result == EAI_NODATA) ttl = DNS_CACHE_NEGATIVE_TTL;
+#endif
+    else ttl = 0;
+
+    if (!result && copy_addrinfo( *res, &entry->ai )) ttl = 0;
+
+    EnterCriticalSection( &dns_cache_cs );
+    entry->result = result;
+    entry->expires = GetTickCount() + ttl;
+    entry->pending = FALSE;
+    SetEvent( entry->event );
+    LeaveCriticalSection( &dns_cache_cs );
+
+    release_dns_entry( entry );
+    return result;
+}
+
+#endif /* HAVE_GETADDRINFO */
+
 /***********************************************************************
  *		getaddrinfo		(WS2_32.@)
  */
@@ -5493,8 +5730,7 @@ int WINAPI WS_getaddrinfo(LPCSTR nodename, LPCSTR servname, const struct WS_addr
             punixhints->ai_socktype = 0;
     }
 
-    /* getaddrinfo(3) is thread safe, no need to wrap in CS */
-    result = getaddrinfo(node, servname, punixhints, &unixaires);
+    result = cached_getaddrinfo(node, servname, punixhints, &unixaires);
 
     TRACE("%s, %s %p -> %p %d\n", debugstr_a(nodename), debugstr_a(servname), hints, res, result);
     HeapFree(GetProcessHeap(), 0, hostname);
@@ -5549,7 +5785,7 @@ int WINAPI WS_getaddrinfo(LPCSTR nodename, LPCSTR servname, const struct WS_addr
             } while (1);
             xuai = xuai->ai_next;
         }
-        freeaddrinfo(unixaires);
+        free_addrinfo_copy(unixaires);
 
         if (TRACE_ON(winsock))
         {
@@ -5569,7 +5805,7 @@ int WINAPI WS_getaddrinfo(LPCSTR nodename, LPCSTR servname, const struct WS_addr
 
 outofmem:
     if (*res) WS_freeaddrinfo(*res);
-    if (unixaires) freeaddrinfo(unixaires);
+    free_addrinfo_copy(unixaires);
     return WSA_NOT_ENOUGH_MEMORY;
 #else
     FIXME("getaddrinfo() failed, not found during buildtime.\n");
@@ -5602,13 +5838,13 @@ static struct WS_addrinfoW *addrinfo_AtoW(const struct WS_addrinfo *ai)
     }
     if (ai->ai_addr)
     {
-        if (!(ret->ai_addr = HeapAlloc(GetProcessHeap(), 0, sizeof(struct WS_sockaddr))))
+        if (!(ret->ai_addr = HeapAlloc(GetProcessHeap(), 0, ai->ai_addrlen)))
         {
             HeapFree(GetProcessHeap(), 0, ret->ai_canonname);
             HeapFree(GetProcessHeap(), 0, ret);
             return NULL;
         }
-        memcpy(ret->ai_addr, ai->ai_addr, sizeof(struct WS_sockaddr));
+        memcpy(ret->ai_addr, ai->ai_addr, ai->ai_addrlen);
     }
     return ret;
 }
@@ -5656,13 +5892,13 @@ static struct WS_addrinfo *addrinfo_WtoA(const struct WS_addrinfoW *ai)
     }
     if (ai->ai_addr)
     {
-        if (!(ret->ai_addr = HeapAlloc(GetProcessHeap(), 0, sizeof(struct WS_sockaddr))))
+        if (!(ret->ai_addr = HeapAlloc(GetProcessHeap(), 0, ai->ai_addrlen)))
         {
             HeapFree(GetProcessHeap(), 0, ret->ai_canonname);
             HeapFree(GetProcessHeap(), 0, ret);
             return NULL;
         }
-        memcpy(ret->ai_addr, ai->ai_addr, sizeof(struct WS_sockaddr));
+        memcpy(ret->ai_addr, ai->ai_addr, ai->ai_addrlen);
     }
     return ret;
 }
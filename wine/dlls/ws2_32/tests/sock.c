@@ -3190,6 +3190,92 @@ static void test_select(void)
     ok ( !FD_ISSET(fdRead, &exceptfds), "FD should not be set\n");
 }
 
+static void test_select_many(void)
+{
+    struct
+    {
+        u_int fd_count;
+        SOCKET fd_array[257];
+    } readfds;
+    SOCKET idle[256], src, dst;
+    struct sockaddr_in addr;
+    struct timeval timeout = {0, 0};
+    DWORD start;
+    int i, ret, count = 0;
+
+    if (tcp_socketpair(&src, &dst) != 0)
+    {
+        ok(0, "creating socket pair failed, skipping test\n");
+        return;
+    }
+    ret = send(src, "x", 1, 0);
+    ok(ret == 1, "send failed: %d\n", WSAGetLastError());
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    for (i = 0; i < sizeof(idle) / sizeof(idle[0]); i++)
+    {
+        if ((idle[i] = socket(AF_INET, SOCK_DGRAM, 0)) == INVALID_SOCKET) break;
+        if (bind(idle[i], (struct sockaddr *)&addr, sizeof(addr)))
+        {
+            closesocket(idle[i]);
+            break;
+        }
+        count++;
+    }
+    ok(count > 0, "couldn't create any idle socket: %d\n", WSAGetLastError());
+
+    /* the same idle sockets and one readable socket, selected over and over */
+    start = GetTickCount();
+    for (i = 0; i < 1000; i++)
+    {
+        memcpy(readfds.fd_array, idle, count * sizeof(SOCKET));
+        readfds.fd_array[count] = dst;
+        readfds.fd_count = count + 1;
+        ret = select(0, (fd_set *)&readfds, NULL, NULL, NULL);
+        if (ret != 1) break;
+        if (readfds.fd_count != 1 || readfds.fd_array[0] != dst) break;
+    }
+    ok(i == 1000, "select %d returned %d, %u sockets\n", i, ret, readfds.fd_count);
+    trace("1000 selects over %d idle sockets took %u ms\n", count, GetTickCount() - start);
+
+    /* a socket closed since the last call must not be reported */
+    closesocket(idle[0]);
+    readfds.fd_array[0] = dst;
+    readfds.fd_count = 1;
+    ret = select(0, (fd_set *)&readfds, NULL, NULL, NULL);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+    readfds.fd_array[0] = idle[0];
+    readfds.fd_count = 1;
+    SetLastError(0xdeadbeef);
+    ret = select(0, (fd_set *)&readfds, NULL, NULL, NULL);
+    ok(ret == SOCKET_ERROR, "expected SOCKET_ERROR, got %d\n", ret);
+    ok(WSAGetLastError() == WSAENOTSOCK, "expected WSAENOTSOCK, got %d\n", WSAGetLastError());
+
+    /* nor the old socket of a handle closed with CloseHandle and reused */
+    readfds.fd_array[0] = dst;
+    readfds.fd_count = 1;
+    ret = select(0, (fd_set *)&readfds, NULL, NULL, NULL);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+    CloseHandle((HANDLE)dst);
+    idle[0] = socket(AF_INET, SOCK_DGRAM, 0);
+    ok(idle[0] != INVALID_SOCKET, "socket failed: %d\n", WSAGetLastError());
+    ret = bind(idle[0], (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed: %d\n", WSAGetLastError());
+    if (idle[0] == dst)
+    {
+        readfds.fd_array[0] = idle[0];
+        readfds.fd_count = 1;
+        ret = select(0, (fd_set *)&readfds, NULL, NULL, &timeout);
+        ok(ret == 0, "expected 0, got %d\n", ret);
+    }
+    else skip("the socket handle wasn't reused\n");
+
+    for (i = 0; i < count; i++) closesocket(idle[i]);
+    closesocket(src);
+}
+
 static DWORD WINAPI AcceptKillThread(void *param)
 {
     select_thread_params *par = param;
@@ -5437,6 +5523,97 @@ static void test_GetAddrInfoW(void)
     }
 }
 
+static BOOL compare_addrinfo(const ADDRINFOA *a, const ADDRINFOA *b)
+{
+    for (; a && b; a = a->ai_next, b = b->ai_next)
+    {
+        if (a->ai_family != b->ai_family || a->ai_addrlen != b->ai_addrlen) return FALSE;
+        if (memcmp(a->ai_addr, b->ai_addr, a->ai_addrlen)) return FALSE;
+    }
+    return !a && !b;
+}
+
+struct getaddrinfo_thread_param
+{
+    const ADDRINFOA *expected;
+    LONG mismatches;
+};
+
+static DWORD WINAPI getaddrinfo_thread(void *arg)
+{
+    struct getaddrinfo_thread_param *param = arg;
+    ADDRINFOA *result, hint;
+    int i, ret;
+
+    memset(&hint, 0, sizeof(hint));
+    hint.ai_family = AF_INET;
+    for (i = 0; i < 100; i++)
+    {
+        result = NULL;
+        ret = pgetaddrinfo("localhost", "80", &hint, &result);
+        if (ret || !compare_addrinfo(result, param->expected))
+            InterlockedIncrement(&param->mismatches);
+        pfreeaddrinfo(result);
+    }
+    return 0;
+}
+
+static void test_getaddrinfo_repeated(void)
+{
+    struct getaddrinfo_thread_param param;
+    ADDRINFOA *expected, *result, hint;
+    HANDLE threads[8];
+    DWORD start;
+    int i, ret;
+
+    if (!pgetaddrinfo || !pfreeaddrinfo)
+    {
+        win_skip("getaddrinfo and/or freeaddrinfo not present\n");
+        return;
+    }
+
+    memset(&hint, 0, sizeof(hint));
+    hint.ai_family = AF_INET;
+    expected = NULL;
+    ret = pgetaddrinfo("localhost", "80", &hint, &expected);
+    ok(!ret, "getaddrinfo failed with %d\n", WSAGetLastError());
+    if (ret) return;
+
+    /* repeated and concurrent lookups return the same list, each caller owning its copy */
+    param.expected = expected;
+    param.mismatches = 0;
+    start = GetTickCount();
+    for (i = 0; i < sizeof(threads) / sizeof(threads[0]); i++)
+        threads[i] = CreateThread(NULL, 0, getaddrinfo_thread, &param, 0, NULL);
+    for (i = 0; i < sizeof(threads) / sizeof(threads[0]); i++)
+    {
+        ok(!WaitForSingleObject(threads[i], 20000), "thread %d didn't finish\n", i);
+        CloseHandle(threads[i]);
+    }
+    trace("%u lookups took %u ms\n", (UINT)(sizeof(threads) / sizeof(threads[0])) * 100, GetTickCount() - start);
+    ok(!param.mismatches, "got %d mismatching results\n", param.mismatches);
+
+    /* a different service must not get the cached port */
+    result = NULL;
+    ret = pgetaddrinfo("localhost", "81", &hint, &result);
+    ok(!ret, "getaddrinfo failed with %d\n", WSAGetLastError());
+    if (!ret)
+    {
+        ok(((struct sockaddr_in *)result->ai_addr)->sin_port == htons(81), "got port %u\n",
+           ntohs(((struct sockaddr_in *)result->ai_addr)->sin_port));
+        pfreeaddrinfo(result);
+    }
+    pfreeaddrinfo(expected);
+
+    for (i = 0; i < 2; i++)
+    {
+        result = (ADDRINFOA *)0xdeadbeef;
+        ret = pgetaddrinfo("nxdomain.codeweavers.com", NULL, NULL, &result);
+        ok(ret == WSAHOST_NOT_FOUND, "%d: got %d expected WSAHOST_NOT_FOUND\n", i, ret);
+        ok(result == NULL, "%d: got %p\n", i, result);
+    }
+}
+
 static void test_getaddrinfo(void)
 {
     int i, ret;
@@ -7327,6 +7504,7 @@ START_TEST( sock )
     test_errors();
     test_listen();
     test_select();
+    test_select_many();
     test_accept();
     test_getpeername();
     test_getsockname();
@@ -7346,6 +7524,7 @@ START_TEST( sock )
     test_ipv6only();
     test_GetAddrInfoW();
     test_getaddrinfo();
+    test_getaddrinfo_repeated();
     test_AcceptEx();
     test_ConnectEx();
 
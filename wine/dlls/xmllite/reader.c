@@ -188,6 +188,7 @@ typedef struct
     ISequentialStream *stream;
     input_buffer *buffer;
     unsigned int pending : 1;
+    unsigned int eof : 1;
 } xmlreaderinput;
 
 static const struct IUnknownVtbl xmlreaderinputvtbl;
@@ -220,8 +221,18 @@ struct attribute
 struct element
 {
     struct list entry;
-    strval qname;
-    strval localname;
+    strval qname;     /* interned */
+    strval localname; /* interned */
+};
+
+/* element names repeat a lot, only one copy of each is kept */
+#define NAME_HASH_SIZE 64
+
+struct name
+{
+    struct list entry;
+    UINT len;
+    WCHAR str[1];
 };
 
 typedef struct
@@ -240,6 +251,7 @@ typedef struct
     struct attribute *attr; /* current attribute */
     UINT attr_count;
     struct list elements;
+    struct list names[NAME_HASH_SIZE]; /* interned element names */
     strval strvalues[StringValue_Last];
     UINT depth;
     UINT max_depth;
@@ -252,6 +264,8 @@ struct input_buffer
     encoded_buffer utf16;
     encoded_buffer encoded;
     UINT code_page;
+    int converted; /* raw bytes already converted while encoding isn't settled yet */
+    BOOL truncated; /* input ended in the middle of a char */
     xmlreaderinput *input;
 };
 
@@ -312,22 +326,6 @@ static inline WCHAR *reader_get_strptr(const xmlreader *reader, const strval *v)
     return v->str ? v->str : reader_get_ptr2(reader, v->start);
 }
 
-static HRESULT reader_strvaldup(xmlreader *reader, const strval *src, strval *dest)
-{
-    *dest = *src;
-
-    if (src->str != strval_empty.str)
-    {
-        dest->str = reader_alloc(reader, (dest->len+1)*sizeof(WCHAR));
-        if (!dest->str) return E_OUTOFMEMORY;
-        memcpy(dest->str, reader_get_strptr(reader, src), dest->len*sizeof(WCHAR));
-        dest->str[dest->len] = 0;
-        dest->start = 0;
-    }
-
-    return S_OK;
-}
-
 /* reader input memory allocation functions */
 static inline void *readerinput_alloc(xmlreaderinput *input, size_t len)
 {
@@ -448,13 +446,64 @@ static void reader_clear_elements(xmlreader *reader)
     struct element *elem, *elem2;
     LIST_FOR_EACH_ENTRY_SAFE(elem, elem2, &reader->elements, struct element, entry)
     {
-        reader_free_strvalued(reader, &elem->qname);
         reader_free(reader, elem);
     }
     list_init(&reader->elements);
     reader->empty_element = FALSE;
 }
 
+/* should only be called once element stack is empty */
+static void reader_clear_names(xmlreader *reader)
+{
+    struct name *name, *name2;
+    int i;
+
+    for (i = 0; i < NAME_HASH_SIZE; i++)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE(name, name2, &reader->names[i], struct name, entry)
+            reader_free(reader, name);
+        list_init(&reader->names[i]);
+    }
+}
+
+/* returns a reader owned copy of a name, shared by all elements using the same name */
+static HRESULT reader_intern_name(xmlreader *reader, const strval *src, strval *dest)
+{
+    const WCHAR *str;
+    struct name *name;
+    UINT hash = 0, i;
+
+    if (src->str == strval_empty.str)
+    {
+        *dest = *src;
+        return S_OK;
+    }
+
+    str = reader_get_strptr(reader, src);
+    for (i = 0; i < src->len; i++)
+        hash = hash * 31 + str[i];
+    hash %= NAME_HASH_SIZE;
+
+    LIST_FOR_EACH_ENTRY(name, &reader->names[hash], struct name, entry)
+    {
+        if (name->len == src->len && !memcmp(name->str, str, src->len*sizeof(WCHAR)))
+        {
+            reader_init_cstrvalue(name->str, name->len, dest);
+            return S_OK;
+        }
+    }
+
+    name = reader_alloc(reader, sizeof(*name) + src->len*sizeof(WCHAR));
+    if (!name) return E_OUTOFMEMORY;
+    name->len = src->len;
+    memcpy(name->str, str, src->len*sizeof(WCHAR));
+    name->str[src->len] = 0;
+    list_add_head(&reader->names[hash], &name->entry);
+
+    reader_init_cstrvalue(name->str, name->len, dest);
+    return S_OK;
+}
+
 static HRESULT reader_inc_depth(xmlreader *reader)
 {
     if (++reader->depth > reader->max_depth) return SC_E_MAXELEMENTDEPTH;
@@ -474,16 +523,11 @@ static HRESULT reader_push_element(xmlreader *reader, strval *qname, strval *loc
     elem = reader_alloc(reader, sizeof(*elem));
     if (!elem) return E_OUTOFMEMORY;
 
-    hr = reader_strvaldup(reader, qname, &elem->qname);
-    if (FAILED(hr)) {
-        reader_free(reader, elem);
-        return hr;
-    }
-
-    hr = reader_strvaldup(reader, localname, &elem->localname);
+    hr = reader_intern_name(reader, qname, &elem->qname);
+    if (SUCCEEDED(hr))
+        hr = reader_intern_name(reader, localname, &elem->localname);
     if (FAILED(hr))
     {
-        reader_free_strvalued(reader, &elem->qname);
         reader_free(reader, elem);
         return hr;
     }
@@ -509,8 +553,6 @@ static void reader_pop_element(xmlreader *reader)
     if (elem)
     {
         list_remove(&elem->entry);
-        reader_free_strvalued(reader, &elem->qname);
-        reader_free_strvalued(reader, &elem->localname);
         reader_free(reader, elem);
         reader_dec_depth(reader);
     }
@@ -630,6 +672,8 @@ static HRESULT alloc_input_buffer(xmlreaderinput *input)
 
     buffer->input = input;
     buffer->code_page = ~0; /* code page is unknown at this point */
+    buffer->converted = 0;
+    buffer->truncated = FALSE;
     hr = init_encoded_buffer(input, &buffer->utf16);
     if (hr != S_OK) {
         readerinput_free(input, buffer);
@@ -688,8 +732,9 @@ static HRESULT readerinput_growraw(xmlreaderinput *readerinput)
     /* always try to get aligned to 4 bytes, so the only case we can get partially read characters is
        variable width encodings like UTF-8 */
     len = (len + 3) & ~3;
-    /* try to use allocated space or grow */
-    if (buffer->allocated - buffer->written < len)
+    /* try to use allocated space or grow, raw data isn't shrunk until encoding
+       is settled so the buffer can be full */
+    if (!len || buffer->allocated - buffer->written < len)
     {
         buffer->allocated *= 2;
         buffer->data = readerinput_realloc(readerinput, buffer->data, buffer->allocated);
@@ -701,6 +746,7 @@ static HRESULT readerinput_growraw(xmlreaderinput *readerinput)
     TRACE("written=%d, alloc=%d, requested=%d, read=%d, ret=0x%08x\n", buffer->written, buffer->allocated, len, read, hr);
     readerinput->pending = hr == E_PENDING;
     if (FAILED(hr)) return hr;
+    readerinput->eof = len && !read;
     buffer->written += read;
 
     return hr;
@@ -767,12 +813,12 @@ static HRESULT readerinput_detectencoding(xmlreaderinput *readerinput, xml_encod
     /* try with BOM now */
     else if (!memcmp(buffer->data, utf8bom, sizeof(utf8bom)))
     {
-        buffer->cur += sizeof(utf8bom);
+        buffer->cur = sizeof(utf8bom);
         *enc = XmlEncoding_UTF8;
     }
     else if (!memcmp(buffer->data, utf16lebom, sizeof(utf16lebom)))
     {
-        buffer->cur += sizeof(utf16lebom);
+        buffer->cur = sizeof(utf16lebom);
         *enc = XmlEncoding_UTF16;
     }
 
@@ -782,14 +828,22 @@ static HRESULT readerinput_detectencoding(xmlreaderinput *readerinput, xml_encod
 static int readerinput_get_utf8_convlen(xmlreaderinput *readerinput)
 {
     encoded_buffer *buffer = &readerinput->buffer->encoded;
-    int len = buffer->written;
+    int len = buffer->written, start;
+    unsigned char lead;
 
     /* complete single byte char */
-    if (!(buffer->data[len-1] & 0x80)) return len;
+    if (!len || !(buffer->data[len-1] & 0x80)) return len;
 
     /* find start byte of multibyte char */
-    while (--len && !(buffer->data[len] & 0xc0))
-        ;
+    start = len - 1;
+    while (start > (int)buffer->cur && (buffer->data[start] & 0xc0) == 0x80 && len - start < 4)
+        start--;
+
+    /* keep it for the next chunk if it's not complete yet */
+    lead = buffer->data[start];
+    if ((lead >> 5) == 0x6 && len - start < 2) return start;
+    if ((lead >> 4) == 0xe && len - start < 3) return start;
+    if ((lead >> 3) == 0x1e && len - start < 4) return start;
 
     return len;
 }
@@ -804,6 +858,9 @@ static int readerinput_get_convlen(xmlreaderinput *readerinput)
 
     if (readerinput->buffer->code_page == CP_UTF8)
         len = readerinput_get_utf8_convlen(readerinput);
+    else if (readerinput->buffer->code_page == ~0)
+        /* don't split UTF-16 code units */
+        len = buffer->cur + ((buffer->written - buffer->cur) & ~1);
     else
         len = buffer->written;
 
@@ -821,47 +878,80 @@ static void readerinput_shrinkraw(xmlreaderinput *readerinput, int len)
     if (len == -1)
         len = readerinput_get_convlen(readerinput);
 
-    memmove(buffer->data, buffer->data + buffer->cur + (buffer->written - len), len);
     /* everything below cur is lost too */
     buffer->written -= len + buffer->cur;
+    memmove(buffer->data, buffer->data + buffer->cur + len, buffer->written);
     /* after this point we don't need cur offset really,
        it's used only to mark where actual data begins when first chunk is read */
     buffer->cur = 0;
 }
 
-/* note that raw buffer content is kept */
-static void readerinput_switchencoding(xmlreaderinput *readerinput, xml_encoding enc)
+/* Converts 'len' bytes starting 'start' bytes past raw buffer position and appends them to UTF-16 buffer.
+   Conversion is done in a single pass, no code page produces more than one WCHAR
+   per byte so destination is grown upfront. ASCII runs of UTF-8 data are widened
+   directly, only the rest goes through MultiByteToWideChar(). */
+static void readerinput_decode(xmlreaderinput *readerinput, UINT cp, int start, int len)
 {
     encoded_buffer *src = &readerinput->buffer->encoded;
     encoded_buffer *dest = &readerinput->buffer->utf16;
-    int len, dest_len;
-    HRESULT hr;
+    const unsigned char *raw = (const unsigned char *)src->data + src->cur + start;
+    const unsigned char *end = raw + len;
     WCHAR *ptr;
+
+    readerinput_grow(readerinput, len);
+    ptr = (WCHAR*)(dest->data + dest->written);
+
+    if (cp == ~0)
+    {
+        memcpy(ptr, raw, len);
+        ptr += len / sizeof(WCHAR);
+    }
+    else if (cp == CP_UTF8)
+    {
+        while (raw < end)
+        {
+            const unsigned char *run;
+
+            while (raw < end && *raw < 0x80) *ptr++ = *raw++;
+            if (raw == end) break;
+
+            /* multibyte sequences up to the next ASCII char */
+            run = raw;
+            while (raw < end && *raw >= 0x80) raw++;
+            ptr += MultiByteToWideChar(cp, 0, (const char *)run, raw - run, ptr, raw - run);
+        }
+    }
+    else
+        ptr += MultiByteToWideChar(cp, 0, (const char *)raw, len, ptr, len);
+
+    *ptr = 0;
+    dest->written = (char*)ptr - dest->data;
+}
+
+static void readerinput_switchencoding(xmlreaderinput *readerinput, xml_encoding enc)
+{
+    HRESULT hr;
     UINT cp;
 
     hr = get_code_page(enc, &cp);
     if (FAILED(hr)) return;
 
     readerinput->buffer->code_page = cp;
-    len = readerinput_get_convlen(readerinput);
 
     TRACE("switching to cp %d\n", cp);
 
-    /* just copy in this case */
-    if (enc == XmlEncoding_UTF16)
-    {
-        readerinput_grow(readerinput, len);
-        memcpy(dest->data, src->data + src->cur, len);
-        dest->written += len*sizeof(WCHAR);
-        return;
-    }
+    /* Raw data is kept until the declaration is parsed, on failure reader starts
+       over from initial state and detects encoding again. */
+    readerinput->buffer->utf16.written = readerinput->buffer->utf16.cur = 0;
+    readerinput->buffer->converted = readerinput_get_convlen(readerinput);
+    readerinput_decode(readerinput, cp, 0, readerinput->buffer->converted);
+}
 
-    dest_len = MultiByteToWideChar(cp, 0, src->data + src->cur, len, NULL, 0);
-    readerinput_grow(readerinput, dest_len);
-    ptr = (WCHAR*)dest->data;
-    MultiByteToWideChar(cp, 0, src->data + src->cur, len, ptr, dest_len);
-    ptr[dest_len] = 0;
-    dest->written += dest_len*sizeof(WCHAR);
+/* drops raw data converted while encoding was switched */
+static void readerinput_commitencoding(xmlreaderinput *readerinput)
+{
+    readerinput_shrinkraw(readerinput, readerinput->buffer->converted);
+    readerinput->buffer->converted = 0;
 }
 
 /* shrinks parsed data a buffer begins with */
@@ -884,34 +974,34 @@ static void reader_shrink(xmlreader *reader)
 static HRESULT reader_more(xmlreader *reader)
 {
     xmlreaderinput *readerinput = reader->input;
-    encoded_buffer *src = &readerinput->buffer->encoded;
-    encoded_buffer *dest = &readerinput->buffer->utf16;
-    UINT cp = readerinput->buffer->code_page;
-    int len, dest_len;
+    input_buffer *buffer = readerinput->buffer;
     HRESULT hr;
-    WCHAR *ptr;
+    int len;
 
     /* get some raw data from stream first */
     hr = readerinput_growraw(readerinput);
     len = readerinput_get_convlen(readerinput);
 
-    /* just copy for UTF-16 case */
-    if (cp == ~0)
+    readerinput_decode(readerinput, buffer->code_page, buffer->converted, len - buffer->converted);
+
+    /* incomplete char at the end of input won't be completed, it's replaced
+       and reported as an error once reader gets to the end */
+    if (readerinput->eof && len < (int)(buffer->encoded.written - buffer->encoded.cur))
     {
-        readerinput_grow(readerinput, len);
-        memcpy(dest->data + dest->written, src->data + src->cur, len);
-        dest->written += len*sizeof(WCHAR);
-        return hr;
+        WARN("input ends with incomplete char\n");
+        readerinput_grow(readerinput, 1);
+        *(WCHAR*)(buffer->utf16.data + buffer->utf16.written) = 0xfffd;
+        buffer->utf16.written += sizeof(WCHAR);
+        *(WCHAR*)(buffer->utf16.data + buffer->utf16.written) = 0;
+        buffer->truncated = TRUE;
+        len = buffer->encoded.written - buffer->encoded.cur;
     }
 
-    dest_len = MultiByteToWideChar(cp, 0, src->data + src->cur, len, NULL, 0);
-    readerinput_grow(readerinput, dest_len);
-    ptr = (WCHAR*)(dest->data + dest->written);
-    MultiByteToWideChar(cp, 0, src->data + src->cur, len, ptr, dest_len);
-    ptr[dest_len] = 0;
-    dest->written += dest_len*sizeof(WCHAR);
-    /* get rid of processed data */
-    readerinput_shrinkraw(readerinput, len);
+    /* get rid of processed data, unless encoding could still change */
+    if (reader->instate == XmlReadInState_Initial)
+        buffer->converted = len;
+    else
+        readerinput_shrinkraw(readerinput, len);
 
     return hr;
 }
@@ -953,6 +1043,45 @@ static inline BOOL is_wchar_space(WCHAR ch)
     return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
 }
 
+/* ASCII chars that stop a run of plain characters, terminating null is part of every class */
+#define CHARCLASS_CHARDATA 0x1 /* '<', ']' */
+#define CHARCLASS_ATTVALUE 0x2 /* '<', '&', quotes, whitespace */
+#define CHARCLASS_COMMENT  0x4 /* '-' */
+#define CHARCLASS_CDATA    0x8 /* ']', '\r' */
+
+static const BYTE char_class[0x80] =
+{
+    0xf, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x2, 0x2, 0x0, 0x0, 0xa, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x2, 0x0, 0x2, 0x0, 0x0, 0x0, 0x2, 0x2, 0x0, 0x0, 0x0, 0x0, 0x0, 0x4, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x3, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x9, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
+    0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0
+};
+
+static inline BOOL is_char_class(WCHAR ch, BYTE class)
+{
+    return ch < 0x80 && (char_class[ch] & class);
+}
+
+/* Returns length of the run of chars not belonging to given class. Text is
+   checked four chars at a time, so the common case of long plain runs doesn't
+   go through the reader one char at a time. */
+static UINT reader_scan_run(const WCHAR *ptr, BYTE class)
+{
+    const WCHAR *start = ptr;
+
+    for (;; ptr += 4)
+    {
+        if (is_char_class(ptr[0], class)) return ptr - start;
+        if (is_char_class(ptr[1], class)) return ptr - start + 1;
+        if (is_char_class(ptr[2], class)) return ptr - start + 2;
+        if (is_char_class(ptr[3], class)) return ptr - start + 3;
+    }
+}
+
 /* [3] S ::= (#x20 | #x9 | #xD | #xA)+ */
 static int reader_skipspaces(xmlreader *reader)
 {
@@ -1206,7 +1335,7 @@ static HRESULT reader_parse_xmldecl(xmlreader *reader)
 static HRESULT reader_parse_comment(xmlreader *reader)
 {
     WCHAR *ptr;
-    UINT start;
+    UINT start, len;
 
     if (reader->resumestate == XmlReadResumeState_Comment)
     {
@@ -1258,8 +1387,9 @@ static HRESULT reader_parse_comment(xmlreader *reader)
             }
         }
 
-        reader_skipn(reader, 1);
-        ptr++;
+        len = reader_scan_run(ptr + 1, CHARCLASS_COMMENT) + 1;
+        reader_skipn(reader, len);
+        ptr += len;
     }
 
     return S_OK;
@@ -1354,7 +1484,7 @@ static XmlNodeType reader_get_nodetype(const xmlreader *reader)
 static HRESULT reader_parse_name(xmlreader *reader, strval *name)
 {
     WCHAR *ptr;
-    UINT start;
+    UINT start, len;
 
     if (reader->resume[XmlReadResume_Name])
     {
@@ -1370,7 +1500,9 @@ static HRESULT reader_parse_name(xmlreader *reader, strval *name)
 
     while (is_namechar(*ptr))
     {
-        reader_skipn(reader, 1);
+        len = 1;
+        while (is_namechar(ptr[len])) len++;
+        reader_skipn(reader, len);
         ptr = reader_get_ptr(reader);
     }
 
@@ -1709,7 +1841,7 @@ static HRESULT reader_parse_dtd(xmlreader *reader)
 static HRESULT reader_parse_local(xmlreader *reader, strval *local)
 {
     WCHAR *ptr;
-    UINT start;
+    UINT start, len;
 
     if (reader->resume[XmlReadResume_Local])
     {
@@ -1724,7 +1856,9 @@ static HRESULT reader_parse_local(xmlreader *reader, strval *local)
 
     while (is_ncnamechar(*ptr))
     {
-        reader_skipn(reader, 1);
+        len = 1;
+        while (is_ncnamechar(ptr[len])) len++;
+        reader_skipn(reader, len);
         ptr = reader_get_ptr(reader);
     }
 
@@ -1778,7 +1912,9 @@ static HRESULT reader_parse_qname(xmlreader *reader, strval *prefix, strval *loc
         /* skip prefix part */
         while (is_ncnamechar(*ptr))
         {
-            reader_skipn(reader, 1);
+            UINT len = 1;
+            while (is_ncnamechar(ptr[len])) len++;
+            reader_skipn(reader, len);
             ptr = reader_get_ptr(reader);
         }
 
@@ -2012,7 +2148,7 @@ static HRESULT reader_parse_attvalue(xmlreader *reader, strval *value)
         else
         {
             reader_normalize_space(reader, ptr);
-            reader_skipn(reader, 1);
+            reader_skipn(reader, reader_scan_run(ptr + 1, CHARCLASS_ATTVALUE) + 1);
         }
         ptr = reader_get_ptr(reader);
     }
@@ -2190,7 +2326,7 @@ static HRESULT reader_parse_endtag(xmlreader *reader)
 static HRESULT reader_parse_cdata(xmlreader *reader)
 {
     WCHAR *ptr;
-    UINT start;
+    UINT start, len;
 
     if (reader->resumestate == XmlReadResumeState_CDATA)
     {
@@ -2239,8 +2375,9 @@ static HRESULT reader_parse_cdata(xmlreader *reader)
                - sequence '\r\n' -> '\n', in this case value length changes;
             */
             if (*ptr == '\r') *ptr = '\n';
-            reader_skipn(reader, 1);
-            ptr++;
+            len = reader_scan_run(ptr + 1, CHARCLASS_CDATA) + 1;
+            reader_skipn(reader, len);
+            ptr += len;
         }
     }
 
@@ -2251,7 +2388,7 @@ static HRESULT reader_parse_cdata(xmlreader *reader)
 static HRESULT reader_parse_chardata(xmlreader *reader)
 {
     WCHAR *ptr;
-    UINT start;
+    UINT start, len, i;
 
     if (reader->resumestate == XmlReadResumeState_CharData)
     {
@@ -2291,11 +2428,21 @@ static HRESULT reader_parse_chardata(xmlreader *reader)
             return S_OK;
         }
 
-        reader_skipn(reader, 1);
+        len = reader_scan_run(ptr + 1, CHARCLASS_CHARDATA) + 1;
 
         /* this covers a case when text has leading whitespace chars */
-        if (!is_wchar_space(*ptr)) reader->nodetype = XmlNodeType_Text;
-        ptr++;
+        if (reader->nodetype == XmlNodeType_Whitespace)
+        {
+            for (i = 0; i < len; i++)
+            {
+                if (is_wchar_space(ptr[i])) continue;
+                reader->nodetype = XmlNodeType_Text;
+                break;
+            }
+        }
+
+        reader_skipn(reader, len);
+        ptr += len;
     }
 
     return S_OK;
@@ -2382,7 +2529,7 @@ static HRESULT reader_parse_nextnode(xmlreader *reader)
                 hr = reader_parse_xmldecl(reader);
                 if (FAILED(hr)) return hr;
 
-                readerinput_shrinkraw(reader->input, -1);
+                readerinput_commitencoding(reader->input);
                 reader->instate = XmlReadInState_Misc_DTD;
                 if (hr == S_OK) return hr;
             }
@@ -2427,8 +2574,12 @@ static HRESULT reader_parse_nextnode(xmlreader *reader)
 
             if (hr == S_FALSE)
                 reader->instate = XmlReadInState_Eof;
-            return hr;
+            else
+                return hr;
+            break;
         case XmlReadInState_Eof:
+            /* input ended in the middle of a char */
+            if (reader->input->buffer->truncated) return MX_E_INPUTEND;
             return S_FALSE;
         default:
             FIXME("internal state %d not handled\n", reader->instate);
@@ -2483,6 +2634,7 @@ static ULONG WINAPI xmlreader_Release(IXmlReader *iface)
         if (This->input) IUnknown_Release(&This->input->IXmlReaderInput_iface);
         reader_clear_attrs(This);
         reader_clear_elements(This);
+        reader_clear_names(This);
         reader_free_strvalues(This);
         reader_free(This, This);
         if (imalloc) IMalloc_Release(imalloc);
@@ -2508,6 +2660,7 @@ static HRESULT WINAPI xmlreader_SetInput(IXmlReader* iface, IUnknown *input)
 
     This->line = This->pos = 0;
     reader_clear_elements(This);
+    reader_clear_names(This);
     This->depth = 0;
     This->resumestate = XmlReadResumeState_Initial;
     memset(This->resume, 0, sizeof(This->resume));
@@ -2991,6 +3144,8 @@ HRESULT WINAPI CreateXmlReader(REFIID riid, void **obj, IMalloc *imalloc)
     reader->attr_count = 0;
     reader->attr = NULL;
     list_init(&reader->elements);
+    for (i = 0; i < NAME_HASH_SIZE; i++)
+        list_init(&reader->names[i]);
     reader->depth = 0;
     reader->max_depth = 256;
     reader->empty_element = FALSE;
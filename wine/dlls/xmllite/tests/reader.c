@@ -1680,6 +1680,100 @@ static void test_read_attribute(void)
     IXmlReader_Release(reader);
 }
 
+static void test_read_large(void)
+{
+    static const char declA[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><root>";
+    static const char itemA[] = "<item name=\"value\">text \xc3\xa9\xc3\xa9 text</item>";
+    static const char endA[] = "</root>";
+    static const WCHAR textW[] = {'t','e','x','t',' ',0xe9,0xe9,' ','t','e','x','t',0};
+    static const WCHAR itemW[] = {'i','t','e','m',0};
+    const int count = 20000;
+    int i, elements = 0, texts = 0, size;
+    IXmlReader *reader;
+    XmlNodeType type;
+    IStream *stream;
+    const WCHAR *str = NULL;
+    char *xml, *ptr;
+    DWORD start;
+    HRESULT hr;
+
+    size = sizeof(declA) - 1 + count * (sizeof(itemA) - 1) + sizeof(endA);
+    ptr = xml = HeapAlloc(GetProcessHeap(), 0, size);
+    memcpy(ptr, declA, sizeof(declA) - 1);
+    ptr += sizeof(declA) - 1;
+    for (i = 0; i < count; i++)
+    {
+        memcpy(ptr, itemA, sizeof(itemA) - 1);
+        ptr += sizeof(itemA) - 1;
+    }
+    memcpy(ptr, endA, sizeof(endA));
+
+    hr = pCreateXmlReader(&IID_IXmlReader, (void**)&reader, NULL);
+    ok(hr == S_OK, "S_OK, got %08x\n", hr);
+
+    stream = create_stream_on_data(xml, size - 1);
+    hr = IXmlReader_SetInput(reader, (IUnknown*)stream);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    /* multibyte chars end up split between input chunks */
+    start = GetTickCount();
+    while ((hr = IXmlReader_Read(reader, &type)) == S_OK)
+    {
+        if (type == XmlNodeType_Element)
+        {
+            elements++;
+            if (elements == 1) continue;
+            hr = IXmlReader_GetLocalName(reader, &str, NULL);
+            ok(hr == S_OK, "got 0x%08x\n", hr);
+            if (lstrcmpW(str, itemW)) break;
+        }
+        else if (type == XmlNodeType_Text)
+        {
+            texts++;
+            hr = IXmlReader_GetValue(reader, &str, NULL);
+            ok(hr == S_OK, "got 0x%08x\n", hr);
+            if (lstrcmpW(str, textW)) break;
+        }
+    }
+    trace("read %d bytes in %u ms\n", size - 1, GetTickCount() - start);
+
+    ok(hr == S_FALSE, "got 0x%08x\n", hr);
+    ok(elements == count + 1, "got %d elements\n", elements);
+    ok(texts == count, "got %d text nodes, last %s\n", texts, wine_dbgstr_w(str));
+
+    IStream_Release(stream);
+    IXmlReader_Release(reader);
+    HeapFree(GetProcessHeap(), 0, xml);
+}
+
+static void test_read_truncated(void)
+{
+    static const char xmlA[] = "<a/>\xc3";
+    IXmlReader *reader;
+    XmlNodeType type;
+    IStream *stream;
+    HRESULT hr;
+
+    hr = pCreateXmlReader(&IID_IXmlReader, (void**)&reader, NULL);
+    ok(hr == S_OK, "S_OK, got %08x\n", hr);
+
+    /* input ends in the middle of a multibyte char */
+    stream = create_stream_on_data(xmlA, sizeof(xmlA) - 1);
+    hr = IXmlReader_SetInput(reader, (IUnknown*)stream);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    type = XmlNodeType_None;
+    hr = IXmlReader_Read(reader, &type);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(type == XmlNodeType_Element, "got %d\n", type);
+
+    hr = IXmlReader_Read(reader, &type);
+    ok(FAILED(hr), "got %08x\n", hr);
+
+    IStream_Release(stream);
+    IXmlReader_Release(reader);
+}
+
 START_TEST(reader)
 {
     HRESULT r;
@@ -1708,6 +1802,8 @@ START_TEST(reader)
     test_read_pending();
     test_readvaluechunk();
     test_read_xmldeclaration();
+    test_read_large();
+    test_read_truncated();
 
     CoUninitialize();
 }
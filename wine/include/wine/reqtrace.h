@@ -0,0 +1,48 @@
+/*
+ * Binary request trace format of the unifiedkernel module
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __WINE_WINE_REQTRACE_H
+#define __WINE_WINE_REQTRACE_H
+
+/* The module writes these records to /proc/unifiedkernel/reqtrace and
+ * tools/decode_reqtrace prints them with the server request dumpers.
+ * A record is followed by header_size bytes of the raw request or reply
+ * structure and data_copied bytes of its variable-size data, padded to a
+ * multiple of 8 bytes. */
+
+#define REQTRACE_REQUEST  1  /* request sent by a thread */
+#define REQTRACE_REPLY    2  /* reply to the previous request of that thread */
+#define REQTRACE_LOST     3  /* error holds the number of records overwritten */
+
+#define REQTRACE_DATA_MAX 256  /* maximum amount of variable-size data recorded */
+
+struct reqtrace_record
+{
+    unsigned int       size;         /* size of the whole record, including padding */
+    unsigned short     type;         /* REQTRACE_* */
+    unsigned short     cpu;          /* cpu the record was written on */
+    unsigned long long time;         /* timestamp in nanoseconds */
+    unsigned int       tid;          /* thread id */
+    unsigned int       req;          /* request code */
+    unsigned int       error;        /* reply status */
+    unsigned int       header_size;  /* size of the request or reply structure */
+    unsigned int       data_size;    /* full size of the variable-size data */
+    unsigned int       data_copied;  /* size of the variable-size data recorded */
+};
+
+#endif  /* __WINE_WINE_REQTRACE_H */
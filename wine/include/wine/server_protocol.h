@@ -652,6 +652,30 @@ struct rawinput_device
     user_handle_t  target;
 };
 
+struct process_info
+{
+    timeout_t       start_time;     /* process start time */
+    data_size_t     name_len;       /* length of the main exe file name in bytes */
+    int             thread_count;   /* number of threads */
+    int             priority;       /* process priority */
+    process_id_t    pid;            /* process id */
+    process_id_t    parent_pid;     /* parent process id */
+    int             handle_count;   /* number of handles */
+    int             unix_pid;       /* Unix pid */
+    int             __pad;
+    /* VARARG(name,unicode_str,name_len); padded to 8 bytes */
+    /* VARARG(threads,struct thread_info,thread_count); */
+};
+
+struct thread_info
+{
+    timeout_t       start_time;     /* thread creation time */
+    thread_id_t     tid;            /* thread id */
+    int             base_priority;  /* base priority */
+    int             current_priority; /* current priority */
+    int             unix_tid;       /* Unix tid */
+};
+
 
 
 
@@ -2216,6 +2240,21 @@ struct next_thread_reply
 
 
 
+struct list_processes_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct list_processes_reply
+{
+    struct reply_header __header;
+    data_size_t  info_size;
+    int          process_count;
+    /* VARARG(data,process_info,info_size); */
+};
+
+
+
 struct wait_debug_event_request
 {
     struct request_header __header;
@@ -2379,6 +2418,8 @@ struct create_key_reply
     struct reply_header __header;
     obj_handle_t hkey;
     int          created;
+    unsigned int key_id;
+    char __pad_20[4];
 };
 
 
@@ -2394,9 +2435,12 @@ struct open_key_reply
 {
     struct reply_header __header;
     obj_handle_t hkey;
-    char __pad_12[4];
+    unsigned int key_id;
 };
 
+#define REG_GENERATION_SLOTS    8192
+#define REG_GENERATION_SLOT(id) (1 + (id) % (REG_GENERATION_SLOTS - 1))
+
 
 
 struct delete_key_request
@@ -5175,6 +5219,7 @@ enum request
     REQ_create_snapshot,
     REQ_next_process,
     REQ_next_thread,
+    REQ_list_processes,
     REQ_wait_debug_event,
     REQ_queue_exception_event,
     REQ_get_exception_status,
@@ -5437,6 +5482,7 @@ union generic_request
     struct create_snapshot_request create_snapshot_request;
     struct next_process_request next_process_request;
     struct next_thread_request next_thread_request;
+    struct list_processes_request list_processes_request;
     struct wait_debug_event_request wait_debug_event_request;
     struct queue_exception_event_request queue_exception_event_request;
     struct get_exception_status_request get_exception_status_request;
@@ -5697,6 +5743,7 @@ union generic_reply
     struct create_snapshot_reply create_snapshot_reply;
     struct next_process_reply next_process_reply;
     struct next_thread_reply next_thread_reply;
+    struct list_processes_reply list_processes_reply;
     struct wait_debug_event_reply wait_debug_event_reply;
     struct queue_exception_event_reply queue_exception_event_reply;
     struct get_exception_status_reply get_exception_status_reply;
@@ -5869,6 +5916,6 @@ union generic_reply
     struct set_suspend_context_reply set_suspend_context_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 454
+#define SERVER_PROTOCOL_VERSION 456
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
@@ -42,6 +42,8 @@
 #define HASH_SIZE     37
 #define MIN_HASH_SIZE 4
 #define MAX_HASH_SIZE 0x200
+#define MAX_REHASH_SIZE 0x2001  /* upper bound when growing, about MAX_ATOMS / 2 */
+#define MAX_LOAD      2         /* average chain length that triggers a rehash */
 
 #define MAX_ATOM_LEN  (255 * sizeof(WCHAR))
 #define MIN_STR_ATOM  0xc000
@@ -54,7 +56,7 @@ struct atom_entry
     int                count;  /* reference count */
     short              pinned; /* whether the atom is pinned or not */
     atom_t             atom;   /* atom handle */
-    unsigned short     hash;   /* string hash */
+    unsigned int       hash;   /* full string hash, bucket is hash % entries_count */
     unsigned short     len;    /* string len */
     WCHAR              str[1]; /* atom string */
 };
@@ -64,9 +66,14 @@ struct atom_table
     struct object       obj;                 /* object header */
     int                 count;               /* count of atom handles */
     int                 last;                /* last handle in-use */
+    int                 free;                /* lowest handle that may be free */
+    int                 atoms;               /* number of atoms in the table */
     struct atom_entry **handles;             /* atom handles */
     int                 entries_count;       /* number of hash entries */
     struct atom_entry **entries;             /* hash table entries */
+    unsigned int        lookups;             /* statistics: hash lookups */
+    unsigned int        probes;              /* statistics: chain entries compared */
+    unsigned int        rehashes;            /* statistics: times the hash table grew */
 };
 
 static void atom_table_dump( struct object *obj, int verbose );
@@ -112,6 +119,11 @@ static struct atom_table *create_table(int entries_count)
         memset( table->entries, 0, sizeof(*table->entries) * table->entries_count );
         table->count = 64;
         table->last  = -1;
+        table->free  = 0;
+        table->atoms = 0;
+        table->lookups  = 0;
+        table->probes   = 0;
+        table->rehashes = 0;
         if ((table->handles = mem_alloc( sizeof(*table->handles) * table->count )))
             return table;
 fail:
@@ -135,7 +147,7 @@ static struct atom_entry *get_atom_entry( struct atom_table *table, atom_t atom
 static atom_t add_atom_entry( struct atom_table *table, struct atom_entry *entry )
 {
     int i;
-    for (i = 0; i <= table->last; i++)
+    for (i = table->free; i <= table->last; i++)
         if (!table->handles[i]) goto found;
     if (i == table->count)
     {
@@ -155,34 +167,98 @@ static atom_t add_atom_entry( struct atom_table *table, struct atom_entry *entry
     table->last = i;
  found:
     table->handles[i] = entry;
+    table->free = i + 1;
     entry->atom = i + MIN_STR_ATOM;
     return entry->atom;
 }
 
-/* compute the hash code for a string */
-static unsigned short atom_hash( struct atom_table *table, const struct unicode_str *str )
+/* remove an atom entry from its hash chain and free its handle */
+static void remove_atom_entry( struct atom_table *table, struct atom_entry *entry )
+{
+    int index = entry->atom - MIN_STR_ATOM;
+
+    if (entry->next) entry->next->prev = entry->prev;
+    if (entry->prev) entry->prev->next = entry->next;
+    else table->entries[entry->hash % table->entries_count] = entry->next;
+    table->handles[index] = NULL;
+    if (index < table->free) table->free = index;
+    table->atoms--;
+    free( entry );
+}
+
+/* compute the case-insensitive hash code for a string (FNV-1a) */
+static unsigned int atom_hash( const struct unicode_str *str )
 {
     unsigned int i;
-    unsigned short hash = 0;
-    for (i = 0; i < str->len / sizeof(WCHAR); i++) hash ^= toupperW(str->str[i]) + i;
-    return hash % table->entries_count;
+    unsigned int hash = 2166136261u;
+    for (i = 0; i < str->len / sizeof(WCHAR); i++)
+    {
+        WCHAR ch = toupperW( str->str[i] );
+        hash = (hash ^ (ch & 0xff)) * 16777619;
+        hash = (hash ^ (ch >> 8)) * 16777619;
+    }
+    return hash;
+}
+
+/* grow the hash table once the average chain gets too long */
+static void rehash_table( struct atom_table *table )
+{
+    struct atom_entry **entries;
+    int i, new_count;
+
+    if (table->atoms <= table->entries_count * MAX_LOAD) return;
+    if (table->entries_count >= MAX_REHASH_SIZE) return;
+
+    new_count = table->entries_count * 2 + 1;
+    if (new_count > MAX_REHASH_SIZE) new_count = MAX_REHASH_SIZE;
+    /* failing to grow is not fatal, the chains just stay longer */
+    if (!(entries = calloc( new_count, sizeof(*entries) ))) return;
+
+    for (i = 0; i <= table->last; i++)
+    {
+        struct atom_entry *entry = table->handles[i];
+        unsigned int bucket;
+
+        if (!entry) continue;
+        bucket = entry->hash % new_count;
+        entry->prev = NULL;
+        if ((entry->next = entries[bucket])) entry->next->prev = entry;
+        entries[bucket] = entry;
+    }
+    free( table->entries );
+    table->entries = entries;
+    table->entries_count = new_count;
+    table->rehashes++;
 }
 
 /* dump an atom table */
 static void atom_table_dump( struct object *obj, int verbose )
 {
     int i;
+    int used = 0, longest = 0;
     struct atom_table *table = (struct atom_table *)obj;
     assert( obj->ops == &atom_table_ops );
 
-    fprintf( stderr, "Atom table size=%d entries=%d\n",
-             table->last + 1, table->entries_count );
+    for (i = 0; i < table->entries_count; i++)
+    {
+        struct atom_entry *entry;
+        int len = 0;
+
+        for (entry = table->entries[i]; entry; entry = entry->next) len++;
+        if (len) used++;
+        if (len > longest) longest = len;
+    }
+
+    fprintf( stderr, "Atom table size=%d entries=%d atoms=%d used=%d longest=%d"
+             " lookups=%u probes=%u rehashes=%u\n",
+             table->last + 1, table->entries_count, table->atoms, used, longest,
+             table->lookups, table->probes, table->rehashes );
     if (!verbose) return;
     for (i = 0; i <= table->last; i++)
     {
         struct atom_entry *entry = table->handles[i];
         if (!entry) continue;
-        fprintf( stderr, "  %04x: ref=%d pinned=%c hash=%d \"",
+        fprintf( stderr, "  %04x: ref=%d pinned=%c hash=%08x \"",
                  entry->atom, entry->count, entry->pinned ? 'Y' : 'N', entry->hash );
         dump_strW( entry->str, entry->len / sizeof(WCHAR), stderr, "\"\"");
         fprintf( stderr, "\"\n" );
@@ -205,12 +281,16 @@ static void atom_table_destroy( struct object *obj )
 
 /* find an atom entry in its hash list */
 static struct atom_entry *find_atom_entry( struct atom_table *table, const struct unicode_str *str,
-                                           unsigned short hash )
+                                           unsigned int hash )
 {
-    struct atom_entry *entry = table->entries[hash];
+    struct atom_entry *entry = table->entries[hash % table->entries_count];
+
+    table->lookups++;
     while (entry)
     {
-        if (entry->len == str->len && !memicmpW( entry->str, str->str, str->len/sizeof(WCHAR) )) break;
+        table->probes++;
+        if (entry->hash == hash && entry->len == str->len &&
+            !memicmpW( entry->str, str->str, str->len/sizeof(WCHAR) )) break;
         entry = entry->next;
     }
     return entry;
@@ -220,7 +300,7 @@ static struct atom_entry *find_atom_entry( struct atom_table *table, const struc
 static atom_t add_atom( struct atom_table *table, const struct unicode_str *str )
 {
     struct atom_entry *entry;
-    unsigned short hash = atom_hash( table, str );
+    unsigned int hash = atom_hash( str );
     atom_t atom = 0;
 
     if (!str->len)
@@ -243,14 +323,18 @@ static atom_t add_atom( struct atom_table *table, const struct unicode_str *str
     {
         if ((atom = add_atom_entry( table, entry )))
         {
+            unsigned int bucket = hash % table->entries_count;
+
             entry->prev  = NULL;
-            if ((entry->next = table->entries[hash])) entry->next->prev = entry;
-            table->entries[hash] = entry;
+            if ((entry->next = table->entries[bucket])) entry->next->prev = entry;
+            table->entries[bucket] = entry;
             entry->count  = 1;
             entry->pinned = 0;
             entry->hash   = hash;
             entry->len    = str->len;
             memcpy( entry->str, str->str, str->len );
+            table->atoms++;
+            rehash_table( table );
         }
         else free( entry );
     }
@@ -264,14 +348,7 @@ static void delete_atom( struct atom_table *table, atom_t atom, int if_pinned )
     struct atom_entry *entry = get_atom_entry( table, atom );
     if (!entry) return;
     if (entry->pinned && !if_pinned) set_error( STATUS_WAS_LOCKED );
-    else if (!--entry->count)
-    {
-        if (entry->next) entry->next->prev = entry->prev;
-        if (entry->prev) entry->prev->next = entry->next;
-        else table->entries[entry->hash] = entry->next;
-        table->handles[atom - MIN_STR_ATOM] = NULL;
-        free( entry );
-    }
+    else if (!--entry->count) remove_atom_entry( table, entry );
 }
 
 /* find an atom in the table */
@@ -289,7 +366,7 @@ static atom_t find_atom( struct atom_table *table, const struct unicode_str *str
         set_error( STATUS_INVALID_PARAMETER );
         return 0;
     }
-    if (table && (entry = find_atom_entry( table, str, atom_hash(table, str) )))
+    if (table && (entry = find_atom_entry( table, str, atom_hash(str) )))
         return entry->atom;
     set_error( STATUS_OBJECT_NAME_NOT_FOUND );
     return 0;
@@ -346,7 +423,7 @@ atom_t find_global_atom( struct winstation *winstation, const struct unicode_str
     struct atom_entry *entry;
 
     if (!str->len || str->len > MAX_ATOM_LEN || !table) return 0;
-    if ((entry = find_atom_entry( table, str, atom_hash(table, str) )))
+    if ((entry = find_atom_entry( table, str, atom_hash(str) )))
         return entry->atom;
     return 0;
 }
@@ -477,14 +554,7 @@ DECL_HANDLER(empty_atom_table)
         for (i = 0; i <= table->last; i++)
         {
             entry = table->handles[i];
-            if (entry && (!entry->pinned || req->if_pinned))
-            {
-                if (entry->next) entry->next->prev = entry->prev;
-                if (entry->prev) entry->prev->next = entry->next;
-                else table->entries[entry->hash] = entry->next;
-                table->handles[i] = NULL;
-                free( entry );
-            }
+            if (entry && (!entry->pinned || req->if_pinned)) remove_atom_entry( table, entry );
         }
         release_object( table );
     }
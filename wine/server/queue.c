@@ -60,6 +60,8 @@ struct message_result
     lparam_t               result;        /* reply result */
     struct message        *hardware_msg;  /* hardware message if low-level hook result */
     struct desktop        *desktop;       /* desktop for hardware message */
+    user_handle_t          hook;          /* low-level hook the message was sent for */
+    timeout_t              hook_time;     /* time the low-level hook message was sent */
     struct message        *callback_msg;  /* message to queue for callback */
     void                  *data;          /* message reply data */
     unsigned int           data_size;     /* size of message reply data */
@@ -544,6 +546,11 @@ static void store_message_result( struct message_result *res, lparam_t result, u
     res->result  = result;
     res->error   = error;
     res->replied = 1;
+    if (res->hook)
+    {
+        add_hook_ll_latency( res->hook, current_time - res->hook_time, error == STATUS_TIMEOUT );
+        res->hook = 0;
+    }
     if (res->timeout)
     {
         remove_timeout_user( res->timeout );
@@ -655,6 +662,8 @@ static struct message_result *alloc_message_result( struct msg_queue *send_queue
         result->hardware_msg = NULL;
         result->desktop      = NULL;
         result->callback_msg = NULL;
+        result->hook         = 0;
+        result->hook_time    = 0;
 
         if (msg->type == MSG_CALLBACK)
         {
@@ -1506,6 +1515,33 @@ static void queue_hardware_message( struct desktop *desktop, struct message *msg
     release_object( thread );
 }
 
+/* drop a mouse move still waiting for the low-level hook if a newer one replaces it */
+static void coalesce_hook_ll_move( struct msg_queue *queue, const struct message *hardware_msg )
+{
+    struct message_result *result;
+    struct message *prev;
+    struct list *ptr;
+
+    if (hardware_msg->msg != WM_MOUSEMOVE) return;
+    if (!(ptr = list_tail( &queue->msg_list[SEND_MESSAGE] ))) return;
+    prev = LIST_ENTRY( ptr, struct message, entry );
+    if (prev->type != MSG_HOOK_LL || prev->msg != WH_MOUSE_LL) return;
+    if (!(result = prev->result) || !result->hardware_msg) return;
+    if (result->hardware_msg->msg != WM_MOUSEMOVE) return;
+    if (result->hardware_msg->win != hardware_msg->win) return;
+
+    /* the hook hasn't seen it yet, so the newer position supersedes it;
+       the sender gets a normal reply instead of a failure */
+    free_message( result->hardware_msg );
+    result->hardware_msg = NULL;
+    result->hook = 0;
+    result->msg = NULL;
+    result->receiver = NULL;
+    prev->result = NULL;
+    store_message_result( result, 0, STATUS_SUCCESS );
+    remove_queue_message( queue, prev, SEND_MESSAGE );
+}
+
 /* send the low-level hook message for a given hardware message */
 static int send_hook_ll_message( struct desktop *desktop, struct message *hardware_msg,
                                  const hw_input_t *input, struct msg_queue *sender )
@@ -1513,13 +1549,16 @@ static int send_hook_ll_message( struct desktop *desktop, struct message *hardwa
     struct thread *hook_thread;
     struct msg_queue *queue;
     struct message *msg;
+    user_handle_t hook;
     timeout_t timeout = 2000 * -10000;  /* FIXME: load from registry */
     int id = (input->type == INPUT_MOUSE) ? WH_MOUSE_LL : WH_KEYBOARD_LL;
 
-    if (!(hook_thread = get_first_global_hook( id ))) return 0;
+    if (!(hook_thread = get_first_global_hook( id, &hook ))) return 0;
     if (!(queue = hook_thread->queue)) return 0;
     if (is_queue_hung( queue )) return 0;
 
+    if (id == WH_MOUSE_LL) coalesce_hook_ll_move( queue, hardware_msg );
+
     if (!(msg = mem_alloc( sizeof(*msg) ))) return 0;
 
     msg->type      = MSG_HOOK_LL;
@@ -1546,6 +1585,8 @@ static int send_hook_ll_message( struct desktop *desktop, struct message *hardwa
     }
     msg->result->hardware_msg = hardware_msg;
     msg->result->desktop = (struct desktop *)grab_object( desktop );
+    msg->result->hook = hook;
+    msg->result->hook_time = current_time;
     list_add_tail( &queue->msg_list[SEND_MESSAGE], &msg->entry );
     set_queue_bits( queue, QS_SENDMESSAGE );
     return 1;
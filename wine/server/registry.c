@@ -77,6 +77,7 @@ struct key
     struct key_value *values;      /* values array */
     unsigned int      flags;       /* flags */
     timeout_t         modif;       /* last modification time */
+    unsigned int      id;          /* key id used by the client caches */
     struct list       notify_list; /* list of notifications */
 };
 
@@ -106,6 +107,7 @@ struct key_value
 
 /* the root of the registry tree */
 static struct key *root_key;
+static unsigned int last_key_id;  /* id of the last allocated key */
 
 static const timeout_t ticks_1601_to_1970 = (timeout_t)86400 * (369 * 365 + 89) * TICKS_PER_SEC;
 static const timeout_t save_period = 30 * -TICKS_PER_SEC;  /* delay between periodic saves */
@@ -481,6 +483,7 @@ static struct key *alloc_key( const struct unicode_str *name, timeout_t modif )
         key->values      = NULL;
         key->modif       = modif;
         key->parent      = NULL;
+        if (!(key->id = ++last_key_id)) key->id = ++last_key_id;
         list_init( &key->notify_list );
         if (name->len && !(key->name = memdup( name->str, name->len )))
         {
@@ -491,6 +494,101 @@ static struct key *alloc_key( const struct unicode_str *name, timeout_t modif )
     return key;
 }
 
+/* cache of the keys found by open_key, indexed by the key the path is relative to
+ * and the case-folded path; flushed when a key is deleted and when a change can
+ * redirect an existing path (Wow6432Node keys, shared keys and symlinks) */
+
+#define KEY_CACHE_BUCKETS  256
+#define KEY_CACHE_MAX      1024  /* max. number of cached paths */
+#define KEY_CACHE_MAX_PATH 256   /* max. length of a cached path in chars */
+
+struct key_cache_entry
+{
+    struct key_cache_entry  *next;  /* next entry in the hash bucket */
+    struct list              lru;   /* entry in the lru list */
+    struct key              *root;  /* key the path is relative to */
+    struct key              *key;   /* key the path resolves to */
+    unsigned int             flags; /* wow64 access flags and OBJ_OPENLINK */
+    unsigned int             hash;  /* hash of the case-folded path */
+    data_size_t              len;   /* length of the path in bytes */
+    WCHAR                    path[1]; /* case-folded path */
+};
+
+static struct key_cache_entry *key_cache[KEY_CACHE_BUCKETS];
+static struct list key_cache_lru = LIST_INIT( key_cache_lru );
+static unsigned int key_cache_count;
+
+/* case-fold a path into a buffer and return its hash */
+static unsigned int fold_key_path( const struct unicode_str *name, WCHAR *buffer )
+{
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < name->len / sizeof(WCHAR); i++)
+    {
+        buffer[i] = toupperW( name->str[i] );
+        hash = hash * 31 + buffer[i];
+    }
+    return hash;
+}
+
+/* remove an entry from the key cache */
+static void remove_cached_key( struct key_cache_entry *entry )
+{
+    struct key_cache_entry **prev = &key_cache[entry->hash % KEY_CACHE_BUCKETS];
+
+    while (*prev != entry) prev = &(*prev)->next;
+    *prev = entry->next;
+    list_remove( &entry->lru );
+    free( entry );
+    key_cache_count--;
+}
+
+/* flush the whole key cache */
+static void flush_key_cache(void)
+{
+    while (key_cache_count)
+        remove_cached_key( LIST_ENTRY( key_cache_lru.prev, struct key_cache_entry, lru ));
+}
+
+/* find the key a case-folded path resolved to */
+static struct key *get_cached_key( struct key *root, const WCHAR *path, data_size_t len,
+                                   unsigned int hash, unsigned int flags )
+{
+    struct key_cache_entry *entry;
+
+    for (entry = key_cache[hash % KEY_CACHE_BUCKETS]; entry; entry = entry->next)
+    {
+        if (entry->hash != hash || entry->root != root || entry->flags != flags || entry->len != len)
+            continue;
+        if (memcmp( entry->path, path, len )) continue;
+        list_remove( &entry->lru );
+        list_add_head( &key_cache_lru, &entry->lru );
+        return entry->key;
+    }
+    return NULL;
+}
+
+/* remember the key a case-folded path resolved to */
+static void add_cached_key( struct key *root, const WCHAR *path, data_size_t len,
+                            unsigned int hash, unsigned int flags, struct key *key )
+{
+    struct key_cache_entry *entry;
+
+    if (key_cache_count >= KEY_CACHE_MAX)
+        remove_cached_key( LIST_ENTRY( key_cache_lru.prev, struct key_cache_entry, lru ));
+    if (!(entry = malloc( offsetof( struct key_cache_entry, path ) + len ))) return;
+    entry->root  = root;
+    entry->key   = key;
+    entry->flags = flags;
+    entry->hash  = hash;
+    entry->len   = len;
+    memcpy( entry->path, path, len );
+    entry->next = key_cache[hash % KEY_CACHE_BUCKETS];
+    key_cache[hash % KEY_CACHE_BUCKETS] = entry;
+    list_add_head( &key_cache_lru, &entry->lru );
+    key_cache_count++;
+}
+
 /* mark a key and all its parents as dirty (modified) */
 static void make_dirty( struct key *key )
 {
@@ -533,6 +631,7 @@ static void touch_key( struct key *key, unsigned int change )
 
     key->modif = current_time;
     make_dirty( key );
+    if (key->flags & KEY_SYMLINK) flush_key_cache();
 
     /* do notifications */
     check_notify( key, change, 1 );
@@ -590,6 +689,9 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
         parent->subkeys[index] = key;
         if (is_wow6432node( key->name, key->namelen ) && !is_wow6432node( parent->name, parent->namelen ))
             parent->flags |= KEY_WOW64;
+        /* the new key may hide the same path in a Wow64 or shared parent */
+        if (parent->flags & (KEY_WOW64|KEY_WOWSHARE))
+            flush_key_cache();
     }
     return key;
 }
@@ -608,6 +710,7 @@ static void free_subkey( struct key *parent, int index )
     parent->last_subkey--;
     key->flags |= KEY_DELETED;
     key->parent = NULL;
+    flush_key_cache();
     if (is_wow6432node( key->name, key->namelen )) parent->flags &= ~KEY_WOW64;
     release_object( key );
 
@@ -736,6 +839,20 @@ static struct key *open_key( struct key *key, const struct unicode_str *name, un
 {
     int index;
     struct unicode_str token;
+    struct key *root = key, *cached;
+    unsigned int hash = 0, flags = (access & (KEY_WOW64_32KEY | KEY_WOW64_64KEY)) | (attributes & OBJ_OPENLINK);
+    WCHAR path[KEY_CACHE_MAX_PATH];
+    int cache = name->len && name->len <= sizeof(path);
+
+    if (cache)
+    {
+        hash = fold_key_path( name, path );
+        if ((cached = get_cached_key( root, path, name->len, hash, flags )))
+        {
+            key = cached;
+            goto done;
+        }
+    }
 
     if (!(key = open_key_prefix( key, name, access, &token, &index ))) return NULL;
 
@@ -750,6 +867,8 @@ static struct key *open_key( struct key *key, const struct unicode_str *name, un
         set_error( STATUS_OBJECT_NAME_NOT_FOUND );
         return NULL;
     }
+    if (cache) add_cached_key( root, path, name->len, hash, flags, key );
+done:
     if (debug_level > 1) dump_operation( key, NULL, "Open" );
     grab_object( key );
     return key;
@@ -1403,7 +1522,11 @@ static int load_key_option( struct key *key, const char *buffer, struct file_loa
         if (!(key->class = memdup( info->tmp, len ))) len = 0;
         key->classlen = len;
     }
-    if (!strncmp( buffer, "#link", 5 )) key->flags |= KEY_SYMLINK;
+    if (!strncmp( buffer, "#link", 5 ))
+    {
+        key->flags |= KEY_SYMLINK;
+        flush_key_cache();
+    }
     /* ignore unknown options */
     return 1;
 }
@@ -1959,6 +2082,13 @@ static int is_wow64_thread( struct thread *thread )
 }
 
 
+/* key id returned to the client cache, only for handles that can query values */
+static unsigned int get_cache_key_id( struct key *key, obj_handle_t handle )
+{
+    if (!handle || !(get_handle_access( current->process, handle ) & KEY_QUERY_VALUE)) return 0;
+    return key->id;
+}
+
 /* create a registry key */
 DECL_HANDLER(create_key)
 {
@@ -1992,6 +2122,7 @@ DECL_HANDLER(create_key)
                                req->attributes, &reply->created )))
         {
             reply->hkey = alloc_handle( current->process, key, access, req->attributes );
+            reply->key_id = get_cache_key_id( key, reply->hkey );
             release_object( key );
         }
         release_object( parent );
@@ -2015,6 +2146,7 @@ DECL_HANDLER(open_key)
         if ((key = open_key( parent, &name, access, req->attributes )))
         {
             reply->hkey = alloc_handle( current->process, key, access, req->attributes );
+            reply->key_id = get_cache_key_id( key, reply->hkey );
             release_object( key );
         }
         release_object( parent );
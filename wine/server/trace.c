@@ -1074,6 +1074,43 @@ static void dump_varargs_filesystem_event( const char *prefix, data_size_t size
     fputc( '}', stderr );
 }
 
+static void dump_varargs_process_info( const char *prefix, data_size_t size )
+{
+    const struct process_info *process;
+    const struct thread_info *thread;
+    data_size_t pos = 0;
+    unsigned int i;
+
+    fprintf( stderr, "%s{", prefix );
+    for (;;)
+    {
+        pos = (pos + 7) & ~7;
+        if (pos >= size || size - pos < sizeof(*process)) break;
+        process = (const struct process_info *)((const char *)cur_data + pos);
+        if (pos) fputc( ',', stderr );
+        dump_timeout( "{start_time=", &process->start_time );
+        fprintf( stderr, ",thread_count=%d,priority=%d,pid=%04x,parent_pid=%04x,handle_count=%d,unix_pid=%d",
+                 process->thread_count, process->priority, process->pid,
+                 process->parent_pid, process->handle_count, process->unix_pid );
+        pos = dump_inline_unicode_string( ",name=L\"", pos + sizeof(*process), process->name_len, size );
+        fputs( "\",threads={", stderr );
+        for (i = 0; i < process->thread_count; i++)
+        {
+            pos = (pos + 7) & ~7;
+            if (pos >= size || size - pos < sizeof(*thread)) break;
+            thread = (const struct thread_info *)((const char *)cur_data + pos);
+            if (i) fputc( ',', stderr );
+            dump_timeout( "{start_time=", &thread->start_time );
+            fprintf( stderr, ",tid=%04x,base_priority=%d,current_priority=%d,unix_tid=%d}",
+                     thread->tid, thread->base_priority, thread->current_priority, thread->unix_tid );
+            pos += sizeof(*thread);
+        }
+        fputs( "}}", stderr );
+    }
+    fputc( '}', stderr );
+    remove_data( size );
+}
+
 static void dump_varargs_rawinput_devices(const char *prefix, data_size_t size )
 {
     const struct rawinput_device *device;
@@ -2134,6 +2171,17 @@ static void dump_next_thread_reply( const struct next_thread_reply *req )
     fprintf( stderr, ", delta_pri=%d", req->delta_pri );
 }
 
+static void dump_list_processes_request( const struct list_processes_request *req )
+{
+}
+
+static void dump_list_processes_reply( const struct list_processes_reply *req )
+{
+    fprintf( stderr, " info_size=%u", req->info_size );
+    fprintf( stderr, ", process_count=%d", req->process_count );
+    dump_varargs_process_info( ", data=", min(cur_size,req->info_size) );
+}
+
 static void dump_wait_debug_event_request( const struct wait_debug_event_request *req )
 {
     fprintf( stderr, " get_handle=%d", req->get_handle );
@@ -2241,6 +2289,7 @@ static void dump_create_key_reply( const struct create_key_reply *req )
 {
     fprintf( stderr, " hkey=%04x", req->hkey );
     fprintf( stderr, ", created=%d", req->created );
+    fprintf( stderr, ", key_id=%08x", req->key_id );
 }
 
 static void dump_open_key_request( const struct open_key_request *req )
@@ -2254,6 +2303,7 @@ static void dump_open_key_request( const struct open_key_request *req )
 static void dump_open_key_reply( const struct open_key_reply *req )
 {
     fprintf( stderr, " hkey=%04x", req->hkey );
+    fprintf( stderr, ", key_id=%08x", req->key_id );
 }
 
 static void dump_delete_key_request( const struct delete_key_request *req )
@@ -4181,6 +4231,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_create_snapshot_request,
     (dump_func)dump_next_process_request,
     (dump_func)dump_next_thread_request,
+    (dump_func)dump_list_processes_request,
     (dump_func)dump_wait_debug_event_request,
     (dump_func)dump_queue_exception_event_request,
     (dump_func)dump_get_exception_status_request,
@@ -4439,6 +4490,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_create_snapshot_reply,
     (dump_func)dump_next_process_reply,
     (dump_func)dump_next_thread_reply,
+    (dump_func)dump_list_processes_reply,
     (dump_func)dump_wait_debug_event_reply,
     (dump_func)dump_queue_exception_event_reply,
     (dump_func)dump_get_exception_status_reply,
@@ -4697,6 +4749,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "create_snapshot",
     "next_process",
     "next_thread",
+    "list_processes",
     "wait_debug_event",
     "queue_exception_event",
     "get_exception_status",
@@ -0,0 +1,180 @@
+/*
+ * Decode a binary request trace of the unifiedkernel module
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The records are printed with the request and reply dumpers generated
+ * into the server's trace.c by make_requests, so the output matches the
+ * text trace of wineserver. Like that trace, it goes to stderr. */
+#include "trace.c"
+#include "unicode.c"
+
+#include "wine/reqtrace.h"
+
+/* the dumpers of the server's own trace refer to the current thread */
+struct thread *current = NULL;
+
+/* there is no current time to relate absolute timeouts to */
+const char *get_timeout_str( timeout_t timeout )
+{
+    static char buffer[64];
+
+    if (!timeout) return "0";
+    if (timeout == TIMEOUT_INFINITE) return "infinite";
+    if (timeout < 0)
+        sprintf( buffer, "+%ld.%07ld", (long)(-timeout / TICKS_PER_SEC), (long)(-timeout % TICKS_PER_SEC) );
+    else
+        sprintf( buffer, "%x%08x", (unsigned int)(timeout >> 32), (unsigned int)timeout );
+    return buffer;
+}
+
+static int compare_trace_records( const void *p1, const void *p2 )
+{
+    const struct reqtrace_record *rec1 = *(const struct reqtrace_record * const *)p1;
+    const struct reqtrace_record *rec2 = *(const struct reqtrace_record * const *)p2;
+
+    if (rec1->time != rec2->time) return rec1->time < rec2->time ? -1 : 1;
+    /* keep the order of records written with the same timestamp */
+    return rec1 < rec2 ? -1 : rec1 > rec2;
+}
+
+static void dump_trace_record( const struct reqtrace_record *rec, unsigned long long start )
+{
+    union generic_request request;
+    union generic_reply reply;
+    unsigned long long time = rec->time - start;
+
+    fprintf( stderr, "%u.%06u %04x: ", (unsigned int)(time / 1000000000),
+             (unsigned int)(time % 1000000000 / 1000), rec->tid );
+
+    if (rec->req >= REQ_NB_REQUESTS)
+    {
+        fprintf( stderr, "%d%s\n", rec->req, rec->type == REQTRACE_REQUEST ? "(?)" : "() = ?" );
+        return;
+    }
+
+    cur_data = (const char *)(rec + 1) + rec->header_size;
+    cur_size = rec->data_copied;
+
+    if (rec->type == REQTRACE_REQUEST)
+    {
+        memset( &request, 0, sizeof(request) );
+        memcpy( &request, rec + 1, min( rec->header_size, sizeof(request) ));
+        fprintf( stderr, "%s(", req_names[rec->req] );
+        if (req_dumpers[rec->req]) req_dumpers[rec->req]( &request );
+        fprintf( stderr, " )" );
+    }
+    else
+    {
+        memset( &reply, 0, sizeof(reply) );
+        memcpy( &reply, rec + 1, min( rec->header_size, sizeof(reply) ));
+        fprintf( stderr, "%s() = %s", req_names[rec->req], get_status_name(rec->error) );
+        if (reply_dumpers[rec->req])
+        {
+            fprintf( stderr, " {" );
+            reply_dumpers[rec->req]( &reply );
+            fprintf( stderr, " }" );
+        }
+    }
+    if (rec->data_copied < rec->data_size)
+        fprintf( stderr, " /* %u of %u data bytes */", rec->data_copied, rec->data_size );
+    fputc( '\n', stderr );
+}
+
+static int decode_request_trace( const char *name )
+{
+    FILE *file = strcmp( name, "-" ) ? fopen( name, "rb" ) : stdin;
+    const struct reqtrace_record **records = NULL, **new_records;
+    char *buffer = NULL, *new_buffer;
+    size_t size = 0, alloc = 0, pos, count = 0, i;
+
+    if (!file)
+    {
+        perror( name );
+        return 0;
+    }
+    for (;;)
+    {
+        if (size == alloc)
+        {
+            alloc = alloc ? alloc * 2 : 1024 * 1024;
+            if (!(new_buffer = realloc( buffer, alloc )))
+            {
+                if (file != stdin) fclose( file );
+                goto nomem;
+            }
+            buffer = new_buffer;
+        }
+        if (!(pos = fread( buffer + size, 1, alloc - size, file ))) break;
+        size += pos;
+    }
+    if (file != stdin) fclose( file );
+
+    for (pos = 0; pos + sizeof(**records) <= size; pos += records[count++]->size)
+    {
+        const struct reqtrace_record *rec = (const struct reqtrace_record *)(buffer + pos);
+
+        if (rec->size < sizeof(*rec) || rec->size > size - pos ||
+            sizeof(*rec) + rec->header_size + rec->data_copied > rec->size)
+        {
+            fprintf( stderr, "%s: corrupted record at offset %lu\n", name, (unsigned long)pos );
+            break;
+        }
+        if (!(count % 4096))
+        {
+            if (!(new_records = realloc( records, (count + 4096) * sizeof(*records) ))) goto nomem;
+            records = new_records;
+        }
+        records[count] = rec;
+    }
+
+    qsort( records, count, sizeof(*records), compare_trace_records );
+    for (i = 0; i < count; i++)
+    {
+        if (records[i]->type == REQTRACE_LOST)
+            fprintf( stderr, "--- %u records lost on cpu %u ---\n", records[i]->error, records[i]->cpu );
+        else
+            dump_trace_record( records[i], records[0]->time );
+    }
+    free( records );
+    free( buffer );
+    return 1;
+
+nomem:
+    fprintf( stderr, "%s: out of memory\n", name );
+    free( records );
+    free( buffer );
+    return 0;
+}
+
+int main( int argc, char *argv[] )
+{
+    if (argc != 2)
+    {
+        fprintf( stderr, "Usage: %s <file>\n"
+                 "Print a binary request trace read from /proc/unifiedkernel/reqtrace,\n"
+                 "or from stdin if <file> is \"-\".\n", argv[0] );
+        return 1;
+    }
+    return !decode_request_trace( argv[1] );
+}
@@ -30,6 +30,15 @@
 #include <stdarg.h>
 #include <signal.h>
 #include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_TIME_H
+# include <sys/time.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
@@ -41,6 +50,7 @@
 struct incl_file
 {
     struct list        entry;
+    struct list        hash_entry;
     char              *name;
     char              *filename;
     char              *sourcename;    /* source file name for generated headers */
@@ -80,8 +90,42 @@ static const struct
     { FLAG_IDL_HEADER,     ".h" }
 };
 
+#define HASH_SIZE 997
+
 static struct list sources = LIST_INIT(sources);
 static struct list includes = LIST_INIT(includes);
+static struct list src_hash[HASH_SIZE];
+static struct list incl_hash[HASH_SIZE];
+
+/* parse results of a file, saved across runs in the dependency cache */
+struct dep_cache_entry
+{
+    struct list        entry;         /* entry in dep_cache hash table */
+    char              *key;           /* device, inode and parse mode of the file */
+    long               mtime;
+    long               mtime_nsec;
+    long               size;
+    unsigned int       flags;         /* flags set by the parser */
+    char              *sourcename;    /* source name set by the parser, if any */
+    unsigned int       count;         /* number of included files */
+    unsigned int       alloc;
+    struct dep_include
+    {
+        char *name;
+        int   line;
+        int   system;
+    }                 *incl;          /* included files, in order */
+    int                dirty;         /* parsed during this run */
+    int                used;          /* looked up during this run */
+};
+
+static struct list dep_cache[HASH_SIZE];
+static struct dep_cache_entry *dep_recording;
+static const char *dep_cache_name;
+static const char *dep_cache_file;
+static int dep_cache_disabled;
+static unsigned int nb_files_parsed;
+static unsigned int nb_files_cached;
 
 struct strarray
 {
@@ -108,6 +152,8 @@ static const char *output_file_name;
 static const char *temp_file_name;
 static int parse_makefile_mode;
 static int relative_dir_mode;
+static int nb_jobs = 1;
+static int show_timing;
 static int input_line;
 static int output_column;
 static FILE *output_file;
@@ -123,7 +169,11 @@ static const char Usage[] =
     "   -M dirs    Parse the makefiles from the specified directories\n"
     "   -R from to Compute the relative path between two directories\n"
     "   -fxxx      Store output in file 'xxx' (default: Makefile)\n"
-    "   -sxxx      Use 'xxx' as separator (default: \"### Dependencies\")\n";
+    "   -sxxx      Use 'xxx' as separator (default: \"### Dependencies\")\n"
+    "   -cxxx      Store the dependency cache in file 'xxx' (default: .makedep.cache with -M)\n"
+    "   -c         Don't use a dependency cache\n"
+    "   -jN        Process the makefiles given to -M with N parallel jobs\n"
+    "   -t         Print the time spent and the cache statistics\n";
 
 
 #ifndef __GNUC__
@@ -521,6 +571,32 @@ static char *get_line( FILE *file )
     }
 }
 
+/*******************************************************************
+ *         hash_filename
+ */
+static unsigned int hash_filename( const char *name )
+{
+    unsigned int ret = 0;
+    while (*name) ret = (ret << 7) + (ret << 3) + *name++;
+    return ret % HASH_SIZE;
+}
+
+/*******************************************************************
+ *         init_file_lists
+ */
+static void init_file_lists(void)
+{
+    unsigned int i;
+
+    list_init( &sources );
+    list_init( &includes );
+    for (i = 0; i < HASH_SIZE; i++)
+    {
+        list_init( &src_hash[i] );
+        list_init( &incl_hash[i] );
+    }
+}
+
 /*******************************************************************
  *         find_src_file
  */
@@ -528,7 +604,7 @@ static struct incl_file *find_src_file( const char *name )
 {
     struct incl_file *file;
 
-    LIST_FOR_EACH_ENTRY( file, &sources, struct incl_file, entry )
+    LIST_FOR_EACH_ENTRY( file, &src_hash[hash_filename( name )], struct incl_file, hash_entry )
         if (!strcmp( name, file->name )) return file;
     return NULL;
 }
@@ -540,11 +616,20 @@ static struct incl_file *find_include_file( const char *name )
 {
     struct incl_file *file;
 
-    LIST_FOR_EACH_ENTRY( file, &includes, struct incl_file, entry )
+    LIST_FOR_EACH_ENTRY( file, &incl_hash[hash_filename( name )], struct incl_file, hash_entry )
         if (!strcmp( name, file->name )) return file;
     return NULL;
 }
 
+/*******************************************************************
+ *         add_to_sources
+ */
+static void add_to_sources( struct incl_file *file )
+{
+    list_add_tail( &sources, &file->entry );
+    list_add_tail( &src_hash[hash_filename( file->name )], &file->hash_entry );
+}
+
 /*******************************************************************
  *         add_include
  *
@@ -583,8 +668,22 @@ static struct incl_file *add_include( struct incl_file *pFile, const char *name,
             fatal_error( "config.h must be included before wine/port.h\n" );
     }
 
-    LIST_FOR_EACH_ENTRY( include, &includes, struct incl_file, entry )
-        if (!strcmp( name, include->name )) goto found;
+    if (dep_recording)
+    {
+        struct dep_cache_entry *entry = dep_recording;
+
+        if (entry->count == entry->alloc)
+        {
+            entry->alloc = entry->alloc ? 2 * entry->alloc : 16;
+            entry->incl = xrealloc( entry->incl, entry->alloc * sizeof(*entry->incl) );
+        }
+        entry->incl[entry->count].name = xstrdup( name );
+        entry->incl[entry->count].line = input_line;
+        entry->incl[entry->count].system = system;
+        entry->count++;
+    }
+
+    if ((include = find_include_file( name ))) goto found;
 
     include = xmalloc( sizeof(*include) );
     memset( include, 0, sizeof(*include) );
@@ -593,6 +692,7 @@ static struct incl_file *add_include( struct incl_file *pFile, const char *name,
     include->included_line = input_line;
     if (system) include->flags |= FLAG_SYSTEM;
     list_add_tail( &includes, &include->entry );
+    list_add_tail( &incl_hash[hash_filename( name )], &include->hash_entry );
 found:
     pFile->files[pos] = include;
     return include;
@@ -1060,12 +1160,100 @@ static void parse_in_file( struct incl_file *source, FILE *file )
 }
 
 
+/*******************************************************************
+ *         get_mtime_nsec
+ */
+static long get_mtime_nsec( const struct stat *st )
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    return st->st_mtimespec.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+
+/*******************************************************************
+ *         find_dep_cache
+ *
+ * Find the cache entry of a file, creating it if needed.
+ * Returns NULL if the entry is out of date and has been reset.
+ */
+static struct dep_cache_entry *find_dep_cache( FILE *file, int mode, struct dep_cache_entry **ret )
+{
+    struct dep_cache_entry *entry;
+    struct stat st;
+    char *key;
+    unsigned int i, hash;
+
+    *ret = NULL;
+    if (fstat( fileno(file), &st ) == -1) return NULL;
+    key = strmake( "%lx:%lx:%d", (unsigned long)st.st_dev, (unsigned long)st.st_ino, mode );
+    hash = hash_filename( key );
+
+    LIST_FOR_EACH_ENTRY( entry, &dep_cache[hash], struct dep_cache_entry, entry )
+    {
+        if (strcmp( entry->key, key )) continue;
+        free( key );
+        *ret = entry;
+        entry->used = 1;
+        if (entry->mtime == (long)st.st_mtime && entry->mtime_nsec == get_mtime_nsec( &st ) &&
+            entry->size == (long)st.st_size) return entry;
+        for (i = 0; i < entry->count; i++) free( entry->incl[i].name );
+        free( entry->sourcename );
+        entry->count = 0;
+        entry->flags = 0;
+        entry->sourcename = NULL;
+        entry->mtime = st.st_mtime;
+        entry->mtime_nsec = get_mtime_nsec( &st );
+        entry->size = st.st_size;
+        entry->dirty = 1;
+        return NULL;
+    }
+
+    entry = xmalloc( sizeof(*entry) );
+    memset( entry, 0, sizeof(*entry) );
+    entry->key = key;
+    entry->mtime = st.st_mtime;
+    entry->mtime_nsec = get_mtime_nsec( &st );
+    entry->size = st.st_size;
+    entry->dirty = entry->used = 1;
+    list_add_tail( &dep_cache[hash], &entry->entry );
+    *ret = entry;
+    return NULL;
+}
+
+
+/*******************************************************************
+ *         replay_dep_cache
+ *
+ * Apply the saved parse results of a file.
+ */
+static void replay_dep_cache( struct incl_file *source, const struct dep_cache_entry *entry )
+{
+    unsigned int i;
+
+    for (i = 0; i < entry->count; i++)
+    {
+        input_line = entry->incl[i].line;
+        add_include( source, entry->incl[i].name, entry->incl[i].system );
+    }
+    source->flags |= entry->flags;
+    if (entry->sourcename) source->sourcename = xstrdup( entry->sourcename );
+}
+
+
 /*******************************************************************
  *         parse_file
  */
 static void parse_file( struct incl_file *source, int src )
 {
+    struct dep_cache_entry *entry = NULL;
+    char *sourcename;
     FILE *file;
+    int mode = 0;
 
     /* don't try to open certain types of files */
     if (strendswith( source->name, ".tlb" ))
@@ -1078,20 +1266,45 @@ static void parse_file( struct incl_file *source, int src )
     if (!file) return;
     input_file_name = source->filename;
 
-    if (source->sourcename && strendswith( source->sourcename, ".idl" ))
-        parse_idl_file( source, file, 1 );
-    else if (strendswith( source->filename, ".idl" ))
-        parse_idl_file( source, file, 0 );
+    if (source->sourcename && strendswith( source->sourcename, ".idl" )) mode = 1;
+    else if (strendswith( source->filename, ".idl" )) mode = 2;
     else if (strendswith( source->filename, ".c" ) ||
-             strendswith( source->filename, ".m" ) ||
              strendswith( source->filename, ".h" ) ||
              strendswith( source->filename, ".l" ) ||
-             strendswith( source->filename, ".y" ))
-        parse_c_file( source, file );
-    else if (strendswith( source->filename, ".rc" ))
-        parse_rc_file( source, file );
-    else if (strendswith( source->filename, ".in" ))
-        parse_in_file( source, file );
+             strendswith( source->filename, ".y" )) mode = 3;
+    else if (strendswith( source->filename, ".m" )) mode = 4;
+    else if (strendswith( source->filename, ".rc" )) mode = 5;
+    else if (strendswith( source->filename, ".man.in" )) mode = 6;
+    else if (strendswith( source->filename, ".in" )) mode = 7;
+
+    if (mode && dep_cache_name && find_dep_cache( file, mode, &entry ))
+    {
+        replay_dep_cache( source, entry );
+        nb_files_cached++;
+        fclose( file );
+        input_file_name = NULL;
+        return;
+    }
+    if (mode) nb_files_parsed++;
+
+    sourcename = source->sourcename;
+    dep_recording = entry;
+    switch (mode)
+    {
+    case 1: parse_idl_file( source, file, 1 ); break;
+    case 2: parse_idl_file( source, file, 0 ); break;
+    case 3:
+    case 4: parse_c_file( source, file ); break;
+    case 5: parse_rc_file( source, file ); break;
+    case 6:
+    case 7: parse_in_file( source, file ); break;
+    }
+    dep_recording = NULL;
+    if (entry)
+    {
+        entry->flags = source->flags & ~(FLAG_SYSTEM | FLAG_GENERATED);
+        if (source->sourcename != sourcename) entry->sourcename = xstrdup( source->sourcename );
+    }
     fclose(file);
     input_file_name = NULL;
 }
@@ -1110,7 +1323,7 @@ static struct incl_file *add_src_file( const char *name )
     file = xmalloc( sizeof(*file) );
     memset( file, 0, sizeof(*file) );
     file->name = xstrdup(name);
-    list_add_tail( &sources, &file->entry );
+    add_to_sources( file );
     parse_file( file, 1 );
     return file;
 }
@@ -1269,7 +1482,7 @@ static struct incl_file *add_generated_source( const char *name, const char *fil
     file->name = xstrdup( name );
     file->filename = xstrdup( filename ? filename : name );
     file->flags = FLAG_GENERATED;
-    list_add_tail( &sources, &file->entry );
+    add_to_sources( file );
     return file;
 }
 
@@ -1977,6 +2190,15 @@ static void rename_temp_file( const char *dest )
 }
 
 
+/*******************************************************************
+ *         get_dep_cache_file
+ */
+static const char *get_dep_cache_file(void)
+{
+    return dep_cache_file ? dep_cache_file : ".makedep.cache";
+}
+
+
 /*******************************************************************
  *         output_gitignore
  */
@@ -1988,6 +2210,7 @@ static void output_gitignore( const char *dest, const struct strarray *files )
 
     output( "# Automatically generated by make depend; DO NOT EDIT!!\n" );
     output( "/.gitignore\n" );
+    if (dep_cache_name && !strchr( get_dep_cache_file(), '/' )) output( "/%s\n", get_dep_cache_file() );
     output( "/Makefile\n" );
     for (i = 0; i < files->count; i++)
     {
@@ -2039,6 +2262,146 @@ static void output_dependencies( const char *path )
 }
 
 
+/*******************************************************************
+ *         free_dep_cache
+ */
+static void free_dep_cache(void)
+{
+    struct dep_cache_entry *entry, *next;
+    unsigned int i, j;
+
+    for (i = 0; i < HASH_SIZE; i++)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE( entry, next, &dep_cache[i], struct dep_cache_entry, entry )
+        {
+            for (j = 0; j < entry->count; j++) free( entry->incl[j].name );
+            free( entry->incl );
+            free( entry->sourcename );
+            free( entry->key );
+            free( entry );
+        }
+    }
+}
+
+
+/*******************************************************************
+ *         load_dep_cache
+ */
+static void load_dep_cache( const char *name )
+{
+    struct dep_cache_entry *entry = NULL;
+    unsigned int i, flags;
+    long mtime, mtime_nsec, size;
+    char key[64], *buffer;
+    int line, system, pos;
+    FILE *file;
+
+    for (i = 0; i < HASH_SIZE; i++) list_init( &dep_cache[i] );
+    if (!(file = fopen( name, "r" ))) return;
+
+    input_file_name = name;
+    input_line = 0;
+    while ((buffer = get_line( file )))
+    {
+        if (buffer[0] == 'F')
+        {
+            if (sscanf( buffer, "F %63s %ld %ld %ld %x %n", key, &mtime, &mtime_nsec, &size,
+                        &flags, &pos ) != 5 || !buffer[pos]) goto error;
+            entry = xmalloc( sizeof(*entry) );
+            memset( entry, 0, sizeof(*entry) );
+            entry->key = xstrdup( key );
+            entry->mtime = mtime;
+            entry->mtime_nsec = mtime_nsec;
+            entry->size = size;
+            entry->flags = flags;
+            if (strcmp( buffer + pos, "-" )) entry->sourcename = xstrdup( buffer + pos );
+            list_add_tail( &dep_cache[hash_filename( entry->key )], &entry->entry );
+        }
+        else if (buffer[0] == 'I' && entry)
+        {
+            if (sscanf( buffer, "I %d %d %n", &line, &system, &pos ) != 2 || !buffer[pos]) goto error;
+            if (entry->count == entry->alloc)
+            {
+                entry->alloc = entry->alloc ? 2 * entry->alloc : 16;
+                entry->incl = xrealloc( entry->incl, entry->alloc * sizeof(*entry->incl) );
+            }
+            entry->incl[entry->count].name = xstrdup( buffer + pos );
+            entry->incl[entry->count].line = line;
+            entry->incl[entry->count].system = system;
+            entry->count++;
+        }
+        else if (!strcmp( buffer, "makedep cache 1" )) goto outdated;
+        else if (strcmp( buffer, "makedep cache 2" )) goto error;
+    }
+    fclose( file );
+    input_file_name = NULL;
+    return;
+
+error:
+    /* don't trust anything in a corrupted cache, it will be rewritten */
+    fprintf( stderr, "%s:%d: ignoring invalid dependency cache\n", input_file_name, input_line );
+outdated:
+    /* the cache of an older makedep is silently rewritten too */
+    fclose( file );
+    input_file_name = NULL;
+    free_dep_cache();
+    for (i = 0; i < HASH_SIZE; i++) list_init( &dep_cache[i] );
+}
+
+
+/*******************************************************************
+ *         save_dep_cache
+ *
+ * Write back the cache if any file had to be parsed, dropping the
+ * entries of files that are no longer used.
+ */
+static void save_dep_cache( const char *name )
+{
+    struct dep_cache_entry *entry;
+    unsigned int i, j;
+    int dirty = 0;
+    FILE *file;
+
+    for (i = 0; i < HASH_SIZE && !dirty; i++)
+        LIST_FOR_EACH_ENTRY( entry, &dep_cache[i], struct dep_cache_entry, entry )
+            if ((dirty = entry->dirty || !entry->used)) break;
+    if (!dirty) return;
+
+    file = create_temp_file( name );
+    fprintf( file, "makedep cache 2\n" );
+    for (i = 0; i < HASH_SIZE; i++)
+    {
+        LIST_FOR_EACH_ENTRY( entry, &dep_cache[i], struct dep_cache_entry, entry )
+        {
+            if (!entry->used) continue;
+            fprintf( file, "F %s %ld %ld %ld %x %s\n", entry->key, entry->mtime, entry->mtime_nsec,
+                     entry->size, entry->flags, entry->sourcename ? entry->sourcename : "-" );
+            for (j = 0; j < entry->count; j++)
+                fprintf( file, "I %d %d %s\n", entry->incl[j].line, entry->incl[j].system,
+                         entry->incl[j].name );
+        }
+    }
+    if (fclose( file )) fatal_perror( "write" );
+    rename_temp_file( name );
+}
+
+
+/*******************************************************************
+ *         get_time
+ */
+static double get_time(void)
+{
+#ifdef HAVE_GETTIMEOFDAY
+    struct timeval tv;
+
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+#else
+    return time( NULL );
+#endif
+}
+
+
 /*******************************************************************
  *         update_makefile
  */
@@ -2064,9 +2427,11 @@ static void update_makefile( const char *path )
     unsigned int i;
     struct strarray value;
     struct incl_file *file;
+    double start = get_time();
 
     base_dir = path;
     output_file_name = strmake( "%s/%s", base_dir, makefile_name );
+    make_vars = empty_strarray;
     parse_makefile();
 
     src_dir     = get_expanded_make_variable( "srcdir" );
@@ -2081,9 +2446,14 @@ static void update_makefile( const char *path )
             strarray_add_uniq( &include_args, value.str[i] );
 
     init_paths();
+    init_file_lists();
 
-    list_init( &sources );
-    list_init( &includes );
+    nb_files_parsed = nb_files_cached = 0;
+    if (!dep_cache_disabled)
+    {
+        dep_cache_name = strmake( "%s/%s", base_dir, get_dep_cache_file() );
+        load_dep_cache( dep_cache_name );
+    }
 
     for (var = source_vars; *var; var++)
     {
@@ -2106,6 +2476,58 @@ static void update_makefile( const char *path )
     LIST_FOR_EACH_ENTRY( file, &includes, struct incl_file, entry ) parse_file( file, 0 );
     output_dependencies( output_file_name );
     output_file_name = NULL;
+
+    if (dep_cache_name)
+    {
+        save_dep_cache( dep_cache_name );
+        free_dep_cache();
+        dep_cache_name = NULL;
+    }
+    if (show_timing)
+        fprintf( stderr, "%s: %u files parsed, %u cached, %.3f s\n",
+                 base_dir, nb_files_parsed, nb_files_cached, get_time() - start );
+}
+
+
+/*******************************************************************
+ *         update_makefiles
+ *
+ * Update all the makefiles given with -M, running nb_jobs processes
+ * that each handle a subset of the directories.
+ */
+static void update_makefiles( int count, char *paths[] )
+{
+    double start = get_time();
+    int i;
+
+#if defined(HAVE_FORK) && defined(HAVE_SYS_WAIT_H)
+    if (nb_jobs > 1 && count > 1)
+    {
+        pid_t *pids = xmalloc( nb_jobs * sizeof(*pids) );
+        int job, status, ret = 0;
+
+        fflush( NULL );
+        for (job = 0; job < nb_jobs && job < count; job++)
+        {
+            if ((pids[job] = fork()) == -1) fatal_perror( "fork" );
+            if (pids[job]) continue;
+            for (i = job; i < count; i += nb_jobs) update_makefile( paths[i] );
+            exit( 0 );
+        }
+        while (job--)
+        {
+            if (waitpid( pids[job], &status, 0 ) == -1) fatal_perror( "waitpid" );
+            if (!WIFEXITED( status ) || WEXITSTATUS( status )) ret = 1;
+        }
+        free( pids );
+        if (ret) exit( 1 );
+    }
+    else
+#endif
+    for (i = 0; i < count; i++) update_makefile( paths[i] );
+
+    if (show_timing && count > 1)
+        fprintf( stderr, "%u makefiles updated in %.3f s\n", count, get_time() - start );
 }
 
 
@@ -2172,6 +2594,17 @@ static int parse_option( const char *opt )
         if (opt[2]) Separator = opt + 2;
         else Separator = NULL;
         break;
+    case 'c':
+        if (opt[2]) dep_cache_file = opt + 2;
+        else dep_cache_disabled = 1;
+        break;
+    case 'j':
+        nb_jobs = atoi( opt + 2 );
+        if (nb_jobs < 1) nb_jobs = 1;
+        break;
+    case 't':
+        show_timing = 1;
+        break;
     case 'x':
         break;  /* ignored */
     default:
@@ -2227,15 +2660,22 @@ int main( int argc, char *argv[] )
 
     if (parse_makefile_mode)
     {
-        for (i = 1; i < argc; i++) update_makefile( argv[i] );
+        update_makefiles( argc - 1, argv + 1 );
         exit( 0 );
     }
 
     init_paths();
+    init_file_lists();
+    if (dep_cache_file && !dep_cache_disabled)
+    {
+        dep_cache_name = dep_cache_file;
+        load_dep_cache( dep_cache_name );
+    }
     for (i = 1; i < argc; i++) add_src_file( argv[i] );
     add_generated_sources();
 
     LIST_FOR_EACH_ENTRY( pFile, &includes, struct incl_file, entry ) parse_file( pFile, 0 );
     output_dependencies( makefile_name );
+    if (dep_cache_name) save_dep_cache( dep_cache_name );
     return 0;
 }